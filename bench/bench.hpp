@@ -0,0 +1,75 @@
+#pragma once
+
+#include <input.hpp>
+#include <output.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <string_view>
+
+namespace coreutils::bench {
+
+// Best wall-clock time of `repeats` runs, in seconds.
+template <typename Func>
+double measure(Func&& func, int repeats = 5) {
+  double best = std::numeric_limits<double>::max();
+  for (int i = 0; i < repeats; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const auto stop = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double>(stop - start).count());
+  }
+  return best;
+}
+
+// Input and Output over a borrowed descriptor, typically /dev/null.
+class FdInput final : public Input {
+ public:
+  explicit FdInput(int fd) : fd_(fd) {}
+  [[nodiscard]] int fd() const override { return fd_; }
+
+ private:
+  int fd_;
+};
+
+class FdOutput final : public Output {
+ public:
+  explicit FdOutput(int fd) : fd_(fd) {}
+  [[nodiscard]] int fd() const override { return fd_; }
+
+ private:
+  int fd_;
+};
+
+inline std::string formatSize(size_t bytes) {
+  constexpr size_t kKiB = 1024;
+  if (bytes >= kKiB * kKiB * kKiB) {
+    return std::to_string(bytes / (kKiB * kKiB * kKiB)) + "G";
+  }
+  if (bytes >= kKiB * kKiB) {
+    return std::to_string(bytes / (kKiB * kKiB)) + "M";
+  }
+  if (bytes >= kKiB) {
+    return std::to_string(bytes / kKiB) + "K";
+  }
+  return std::to_string(bytes);
+}
+
+inline void reportThroughput(std::string_view name, size_t bytes,
+                             double seconds) {
+  std::printf("%-32.*s %8s %10.3f ms %10.1f MB/s\n",
+              static_cast<int>(name.size()), name.data(),
+              formatSize(bytes).c_str(), seconds * 1e3,
+              static_cast<double>(bytes) / seconds / 1e6);
+}
+
+inline void reportTime(std::string_view name, size_t items, double seconds) {
+  std::printf("%-32.*s %8zu %10.3f ms\n", static_cast<int>(name.size()),
+              name.data(), items, seconds * 1e3);
+}
+
+}  // namespace coreutils::bench
@@ -0,0 +1,93 @@
+#include <bench.hpp>
+
+#include <count_command.hpp>
+#include <uniq_command.hpp>
+#include <unique_fd.hpp>
+
+#include <fcntl.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Usage: count_bench [base-dir] [lines]
+// Generates `lines` (default 4M) words drawn from 100k distinct ones with a
+// skewed distribution, then times the pipelines that count them with GNU
+// tools (LC_ALL=C) against the builtins that need no sort, all writing to
+// /dev/null. Streaming uniq -c is timed on a sorted copy of the input.
+
+namespace {
+
+void runExternal(const std::string& command) {
+  if (std::system(command.c_str()) != 0) {
+    throw std::runtime_error("external command failed: " + command);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  using namespace coreutils;
+  using namespace coreutils::bench;
+
+  const std::filesystem::path base =
+      argc > 1 ? std::filesystem::path(argv[1])
+               : std::filesystem::temp_directory_path();
+  const size_t lines =
+      argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4000000;
+
+  const auto path = (base / "count-bench").string();
+  const auto sorted_path = (base / "count-bench-sorted").string();
+  size_t bytes = 0;
+  {
+    std::mt19937 rng(9);
+    // Squaring a uniform variate makes the low ids far more frequent.
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::ofstream file(path, std::ios::trunc);
+    for (size_t i = 0; i < lines; ++i) {
+      const auto id = static_cast<unsigned>(std::pow(uniform(rng), 2) * 1e5);
+      const std::string line = "word-" + std::to_string(id * 7919) + '\n';
+      file << line;
+      bytes += line.size();
+    }
+  }
+  runExternal("LC_ALL=C sort '" + path + "' > '" + sorted_path + "'");
+
+  UniqueFd null_fd(open("/dev/null", O_RDWR | O_CLOEXEC));
+  FdInput input(null_fd.get());
+  FdOutput output(null_fd.get());
+
+  const std::string sorted_count =
+      "LC_ALL=C sort '" + path + "' | LC_ALL=C uniq -c";
+  double seconds =
+      measure([&] { runExternal(sorted_count + " | sort -rn > /dev/null"); },
+              3);
+  reportThroughput("count/external", bytes, seconds);
+  CountCommand count({path});
+  seconds = measure([&] { count.run(input, output); }, 3);
+  reportThroughput("count/builtin", bytes, seconds);
+
+  seconds = measure([&] { runExternal(sorted_count + " > /dev/null"); }, 3);
+  reportThroughput("uniq -c --unsorted/external", bytes, seconds);
+  UniqCommand unsorted({"-c", "--unsorted", path});
+  seconds = measure([&] { unsorted.run(input, output); }, 3);
+  reportThroughput("uniq -c --unsorted/builtin", bytes, seconds);
+
+  seconds = measure(
+      [&] {
+        runExternal("LC_ALL=C uniq -c '" + sorted_path + "' > /dev/null");
+      },
+      3);
+  reportThroughput("uniq -c sorted/external", bytes, seconds);
+  UniqCommand streaming({"-c", sorted_path});
+  seconds = measure([&] { streaming.run(input, output); }, 3);
+  reportThroughput("uniq -c sorted/builtin", bytes, seconds);
+
+  std::filesystem::remove(path);
+  std::filesystem::remove(sorted_path);
+}
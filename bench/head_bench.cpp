@@ -0,0 +1,59 @@
+#include <bench.hpp>
+
+#include <cli.hpp>
+#include <parser.hpp>
+#include <unique_fd.hpp>
+
+#include <fcntl.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+// Usage: head_bench [base-dir] [megabytes]
+// Writes a file of `megabytes` (default 256) whose only match is on its
+// first line, then times `cat file | grep x | head -1` run by /bin/sh and
+// by the shell with every stage a builtin. Both only finish early when
+// head cancels the stages feeding it.
+
+int main(int argc, char** argv) {
+  using namespace coreutils;
+  using namespace coreutils::bench;
+
+  const std::filesystem::path base =
+      argc > 1 ? std::filesystem::path(argv[1])
+               : std::filesystem::temp_directory_path();
+  const size_t megabytes =
+      argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 256;
+
+  const auto path = (base / "head-bench").string();
+  {
+    std::ofstream file(path, std::ios::trunc);
+    const std::string block(1 << 20, 'y');
+    file << "x\n";
+    for (size_t i = 0; i < megabytes; ++i) {
+      file << block << '\n';
+    }
+  }
+
+  UniqueFd null_fd(open("/dev/null", O_RDWR | O_CLOEXEC));
+  FdInput input(null_fd.get());
+  FdOutput output(null_fd.get());
+
+  const std::string pipeline = "cat '" + path + "' | grep x | head -1";
+  double seconds = measure([&] {
+    if (std::system((pipeline + " > /dev/null").c_str()) != 0) {
+      throw std::runtime_error("external pipeline failed");
+    }
+  });
+  reportTime("cat | grep | head/external", megabytes, seconds);
+
+  Parser parser;
+  CLI cli{parser};
+  seconds = measure([&] { cli.runScript(pipeline, input, output); });
+  reportTime("cat | grep | head/builtin", megabytes, seconds);
+
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,85 @@
+#include <bench.hpp>
+
+#include <history.hpp>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+
+// Usage: history_bench [base-dir] [entries]
+// Writes a history file of `entries` (default 1M) random pipelines, then
+// times the first lookup, which maps and indexes the file, and searches
+// for frequent, rare and missing texts.
+
+namespace coreutils::bench {
+
+namespace {
+
+constexpr std::string_view kWords[] = {
+    "ls",    "-l",     "cat",    "grep",   "find",  "du",     "-s",
+    "make",  "build",  "test",   "git",    "log",   "status", "commit",
+    "echo",  "export", "src",    "core",   "bench", "/tmp",   "*.cpp",
+    "wc",    "-w",     "sort",   "-n",     "uniq",  "head",   "tail",
+    "-f",    "docker", "run",    "kubectl", "get",  "pods",   "deploy"};
+
+std::string randomLine(std::mt19937& rng) {
+  std::uniform_int_distribution<size_t> word(0, std::size(kWords) - 1);
+  std::uniform_int_distribution<int> count(2, 9);
+  std::uniform_int_distribution<int> number(0, 99999);
+  std::string line;
+  for (int i = count(rng); i > 0; --i) {
+    line.append(kWords[word(rng)]).push_back(' ');
+  }
+  line.append(std::to_string(number(rng)));
+  return line;
+}
+
+}  // namespace
+
+}  // namespace coreutils::bench
+
+int main(int argc, char** argv) {
+  using namespace coreutils;
+  using namespace coreutils::bench;
+
+  const std::filesystem::path base =
+      argc > 1 ? std::filesystem::path(argv[1])
+               : std::filesystem::temp_directory_path();
+  const size_t entries =
+      argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+
+  const auto path = (base / "history-bench").string();
+  size_t bytes = 0;
+  {
+    std::mt19937 rng(1);
+    std::ofstream file(path, std::ios::trunc);
+    for (size_t i = 0; i < entries; ++i) {
+      const auto line = randomLine(rng);
+      file << line << '\n';
+      bytes += line.size() + 1;
+    }
+  }
+
+  // A fresh History per run, so that every run loads the file.
+  double seconds = measure([&] {
+    History history;
+    history.open(path);
+    (void)history.search("kubectl get pods", 1);
+  });
+  reportThroughput("history/first-search", bytes, seconds);
+
+  History history;
+  history.open(path);
+  (void)history.search("", 1);
+  for (std::string_view text :
+       {"git", "make test 4242", "docker run deploy 123", "no such text"}) {
+    seconds = measure([&] { (void)history.search(text, 10); });
+    reportTime("history/search '" + std::string(text) + "'", entries,
+               seconds);
+  }
+
+  std::filesystem::remove(path);
+}
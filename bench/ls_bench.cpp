@@ -0,0 +1,98 @@
+#include <bench.hpp>
+
+#include <ls_command.hpp>
+#include <unique_fd.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Usage: ls_bench [base-dir] [entry-count...]
+// Creates one directory per count under base-dir (default: the system temp
+// directory), lists it with the old std::filesystem approach and with the
+// builtin engine, writing to /dev/null, and removes it again.
+
+namespace coreutils::bench {
+
+namespace {
+
+std::filesystem::path createDirectory(const std::filesystem::path& base,
+                                      size_t count) {
+  auto dir = base / ("ls-bench-" + std::to_string(count));
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  UniqueFd dirfd(open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+
+  std::mt19937_64 rng(count);
+  for (size_t i = 0; i < count; ++i) {
+    const auto name = "entry-" + std::to_string(rng() % 1000000007) + "-" +
+                      std::to_string(i);
+    UniqueFd file(openat(dirfd.get(), name.c_str(),
+                         O_CREAT | O_WRONLY | O_CLOEXEC, 0644));
+    if (!file) {
+      throw std::runtime_error("cannot create " + name);
+    }
+  }
+  return dir;
+}
+
+// What LsCommand did before: a path and a string per entry, std::sort and
+// one write per line.
+void listWithFilesystem(const std::filesystem::path& dir, const Output& out) {
+  std::vector<std::string> entries;
+  for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+    entries.push_back(entry.path().filename().string());
+  }
+  std::sort(entries.begin(), entries.end());
+  for (auto& entry : entries) {
+    entry.push_back('\n');
+    out.write(entry);
+  }
+}
+
+}  // namespace
+
+}  // namespace coreutils::bench
+
+int main(int argc, char** argv) {
+  using namespace coreutils;
+  using namespace coreutils::bench;
+
+  std::filesystem::path base = std::filesystem::temp_directory_path();
+  std::vector<size_t> counts;
+  if (argc > 1) {
+    base = argv[1];
+  }
+  for (int i = 2; i < argc; ++i) {
+    counts.push_back(std::strtoull(argv[i], nullptr, 10));
+  }
+  if (counts.empty()) {
+    counts = {10000, 1000000, 5000000};
+  }
+
+  UniqueFd null_fd(open("/dev/null", O_RDWR | O_CLOEXEC));
+  FdInput input(null_fd.get());
+  FdOutput output(null_fd.get());
+
+  for (size_t count : counts) {
+    const auto dir = createDirectory(base, count);
+    const int repeats = count >= 1000000 ? 3 : 10;
+
+    double seconds =
+        measure([&] { listWithFilesystem(dir, output); }, repeats);
+    reportTime("ls/filesystem", count, seconds);
+
+    LsCommand command({dir.string()});
+    seconds = measure([&] { command.run(input, output); }, repeats);
+    reportTime("ls/engine", count, seconds);
+
+    std::filesystem::remove_all(dir);
+  }
+}
@@ -0,0 +1,44 @@
+#include <bench.hpp>
+
+#include <cli.hpp>
+#include <parser.hpp>
+#include <unique_fd.hpp>
+
+#include <fcntl.h>
+
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+// Usage: plugin_bench [lines]
+// Runs a script of `lines` (default 200) pipelines `echo ... | rev`, first
+// with rev as an external program and then as a builtin loaded from the
+// sample plugin, both writing to /dev/null.
+
+int main(int argc, char** argv) {
+  using namespace coreutils;
+  using namespace coreutils::bench;
+
+  const size_t lines = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200;
+
+  std::string script;
+  for (size_t i = 0; i < lines; ++i) {
+    script += "echo line " + std::to_string(i) + " of the script | rev\n";
+  }
+
+  UniqueFd null_fd(open("/dev/null", O_RDWR | O_CLOEXEC));
+  FdInput input(null_fd.get());
+  FdOutput output(null_fd.get());
+
+  Parser parser;
+  CLI cli{parser};
+
+  double seconds = measure([&] { cli.runScript(script, input, output); });
+  reportTime("rev/external", lines, seconds);
+
+  if (cli.runScript("enable -f " REV_PLUGIN_PATH " rev", input, output) != 0) {
+    throw std::runtime_error("cannot load " REV_PLUGIN_PATH);
+  }
+  seconds = measure([&] { cli.runScript(script, input, output); });
+  reportTime("rev/plugin", lines, seconds);
+}
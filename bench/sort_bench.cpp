@@ -0,0 +1,84 @@
+#include <bench.hpp>
+
+#include <sort_command.hpp>
+#include <unique_fd.hpp>
+
+#include <fcntl.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Usage: sort_bench [base-dir] [lines]
+// Generates `lines` (default 2M) random lines of words and numbers, then
+// times GNU sort (LC_ALL=C) against the builtin, both writing to
+// /dev/null: whole lines, -n on a numeric field, and with a 4M memory
+// budget that forces sorted runs on disk and an external merge.
+
+int main(int argc, char** argv) {
+  using namespace coreutils;
+  using namespace coreutils::bench;
+
+  const std::filesystem::path base =
+      argc > 1 ? std::filesystem::path(argv[1])
+               : std::filesystem::temp_directory_path();
+  const size_t lines =
+      argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000000;
+
+  const auto path = (base / "sort-bench").string();
+  size_t bytes = 0;
+  {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> length(4, 24);
+    std::uniform_int_distribution<int> number(-1000000, 1000000);
+    std::ofstream file(path, std::ios::trunc);
+    for (size_t i = 0; i < lines; ++i) {
+      std::string line(length(rng), ' ');
+      for (auto& ch : line) {
+        ch = static_cast<char>(letter(rng));
+      }
+      line += ' ' + std::to_string(number(rng)) + '\n';
+      file << line;
+      bytes += line.size();
+    }
+  }
+
+  UniqueFd null_fd(open("/dev/null", O_RDWR | O_CLOEXEC));
+  FdInput input(null_fd.get());
+  FdOutput output(null_fd.get());
+
+  const std::vector<std::vector<std::string>> workloads = {
+      {}, {"-n", "-k", "2"}, {"-S", "4M"}};
+  for (const auto& options : workloads) {
+    std::string name = "sort";
+    std::string flags;
+    for (const auto& option : options) {
+      name += ' ' + option;
+      flags += ' ' + option;
+    }
+
+    const std::string external =
+        "LC_ALL=C sort" + flags + " '" + path + "' > /dev/null";
+    double seconds = measure(
+        [&] {
+          if (std::system(external.c_str()) != 0) {
+            throw std::runtime_error("external sort failed");
+          }
+        },
+        3);
+    reportThroughput(name + "/external", bytes, seconds);
+
+    std::vector<std::string> args = options;
+    args.push_back(path);
+    SortCommand command(args);
+    seconds = measure([&] { command.run(input, output); }, 3);
+    reportThroughput(name + "/builtin", bytes, seconds);
+  }
+
+  std::filesystem::remove(path);
+}
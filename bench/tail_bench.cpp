@@ -0,0 +1,75 @@
+#include <bench.hpp>
+
+#include <tail_command.hpp>
+#include <unique_fd.hpp>
+
+#include <fcntl.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+// Usage: tail_bench [base-dir] [lines]
+// Writes a file of `lines` (default 4M) short lines and times GNU tail
+// against the builtin, both writing to /dev/null: the last 10 lines of the
+// file, read backwards from its end, and of the same data from a pipe,
+// kept in the ring of blocks.
+
+int main(int argc, char** argv) {
+  using namespace coreutils;
+  using namespace coreutils::bench;
+
+  const std::filesystem::path base =
+      argc > 1 ? std::filesystem::path(argv[1])
+               : std::filesystem::temp_directory_path();
+  const size_t lines =
+      argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4000000;
+
+  const auto path = (base / "tail-bench").string();
+  size_t bytes = 0;
+  {
+    std::ofstream file(path, std::ios::trunc);
+    for (size_t i = 0; i < lines; ++i) {
+      const std::string line = "log line " + std::to_string(i) + '\n';
+      file << line;
+      bytes += line.size();
+    }
+  }
+
+  UniqueFd null_fd(open("/dev/null", O_RDWR | O_CLOEXEC));
+  FdInput input(null_fd.get());
+  FdOutput output(null_fd.get());
+
+  auto run_external = [](const std::string& command) {
+    if (std::system(command.c_str()) != 0) {
+      throw std::runtime_error("external tail failed");
+    }
+  };
+
+  double seconds =
+      measure([&] { run_external("tail '" + path + "' > /dev/null"); });
+  reportThroughput("tail file/external", bytes, seconds);
+  TailCommand from_file({path});
+  seconds = measure([&] { from_file.run(input, output); });
+  reportThroughput("tail file/builtin", bytes, seconds);
+
+  seconds = measure(
+      [&] { run_external("cat '" + path + "' | tail > /dev/null"); });
+  reportThroughput("tail pipe/external", bytes, seconds);
+  TailCommand from_pipe({});
+  seconds = measure([&] {
+    FILE* cat = popen(("cat '" + path + "'").c_str(), "r");
+    if (cat == nullptr) {
+      throw std::runtime_error("cannot run cat");
+    }
+    FdInput pipe_input(fileno(cat));
+    from_pipe.run(pipe_input, output);
+    pclose(cat);
+  });
+  reportThroughput("tail pipe/builtin", bytes, seconds);
+
+  std::filesystem::remove(path);
+}
@@ -0,0 +1,112 @@
+#include <bench.hpp>
+
+#include <arena.hpp>
+#include <parser.hpp>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace coreutils::bench {
+
+namespace {
+
+// Script lines in the shape an interactive session produces: mostly plain
+// words and pipes, with some quoting and variable expansion mixed in.
+std::vector<std::string> makeScript(size_t line_count, size_t min_words,
+                                    size_t max_words) {
+  static constexpr std::string_view kWords[] = {
+      "grep", "-rn", "TODO", "src/", "|", "wc", "-l", "&&", "cat",
+      "README.md", "ls", "-la", "/usr/share/doc", "'single quoted'",
+      "\"double $HOME quoted\"", "$USER", "${PATH}", "--exclude-dir=build"};
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<size_t> word(0, std::size(kWords) - 1);
+  std::uniform_int_distribution<size_t> length(min_words, max_words);
+
+  std::vector<std::string> lines(line_count);
+  for (auto& line : lines) {
+    for (size_t i = length(rng); i > 0; --i) {
+      line += kWords[word(rng)];
+      line.push_back(' ');
+    }
+  }
+  return lines;
+}
+
+}  // namespace
+
+}  // namespace coreutils::bench
+
+int main() {
+  using namespace coreutils;
+  using namespace coreutils::bench;
+
+  setenv("HOME", "/home/user", 0);
+  setenv("USER", "user", 0);
+
+  struct Workload {
+    std::string name;
+    size_t lines;
+    size_t min_words;
+    size_t max_words;
+  };
+  // Interactive-sized lines, and generated argument lists of ~100 KB.
+  const Workload workloads[] = {{"short/1000", 1000, 2, 24},
+                                {"short/100000", 100000, 2, 24},
+                                {"100K-args/100", 100, 10000, 10000}};
+
+  for (const auto& workload : workloads) {
+    const auto lines =
+        makeScript(workload.lines, workload.min_words, workload.max_words);
+    size_t bytes = 0;
+    for (const auto& line : lines) {
+      bytes += line.size();
+    }
+
+    Parser parser;
+    volatile size_t sink = 0;
+
+    double seconds = measure([&] {
+      Arena arena;
+      for (const auto& line : lines) {
+        arena.reset();
+        sink = sink + parser.tokenize(line, arena).size();
+      }
+    });
+    reportThroughput("tokenize/" + workload.name, bytes, seconds);
+
+    seconds = measure([&] {
+      for (const auto& line : lines) {
+        sink = sink + parser.parseToTokens(std::string(line)).size();
+      }
+    });
+    reportThroughput("parseToTokens/" + workload.name, bytes, seconds);
+  }
+
+  // Two globs over one directory: the listing is read once per line, and
+  // the time should grow linearly with the number of matches.
+  const auto dir =
+      std::filesystem::temp_directory_path() / "tokenizer_bench_glob";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  size_t files = 0;
+  for (size_t count : {size_t{1000}, size_t{10000}, size_t{50000}}) {
+    for (; files < count; ++files) {
+      std::ofstream(dir / ("file-" + std::to_string(files) + ".dat"));
+    }
+    const std::string line = "cat " + dir.string() + "/*.dat " +
+                             dir.string() + "/file-1*.dat";
+
+    Parser parser;
+    volatile size_t sink = 0;
+    const double seconds = measure([&] {
+      Arena arena;
+      sink = sink + parser.tokenize(line, arena).size();
+    });
+    reportTime("glob/" + std::to_string(count), count, seconds);
+  }
+  std::filesystem::remove_all(dir);
+}
@@ -0,0 +1,99 @@
+#include <bench.hpp>
+
+#include <cut_command.hpp>
+#include <tr_command.hpp>
+#include <unique_fd.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Usage: tr_cut_bench [base-dir] [megabytes]
+// Writes `megabytes` (default 64) of comma-separated lines ending in CRLF
+// and times `tr a-z A-Z`, `tr -d '\r'` and `cut -d, -f3` over it, run as
+// external programs and as builtins.
+
+namespace {
+
+struct Case {
+  std::string name;
+  std::string external;  // command line; the file is appended
+  std::vector<std::string> args;
+  bool cut;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  using namespace coreutils;
+  using namespace coreutils::bench;
+
+  const std::filesystem::path base =
+      argc > 1 ? std::filesystem::path(argv[1])
+               : std::filesystem::temp_directory_path();
+  const size_t megabytes =
+      argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 64;
+
+  const auto path = (base / "tr-cut-bench").string();
+  size_t bytes = 0;
+  {
+    std::ofstream file(path, std::ios::trunc);
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    std::uniform_int_distribution<int> length(2, 12);
+    std::string line;
+    while (bytes < megabytes << 20) {
+      line.clear();
+      for (int field = 0; field < 6; ++field) {
+        if (field != 0) {
+          line += ',';
+        }
+        for (int i = length(rng); i > 0; --i) {
+          line += static_cast<char>(letter(rng));
+        }
+      }
+      line += "\r\n";
+      file << line;
+      bytes += line.size();
+    }
+  }
+
+  UniqueFd file_fd(open(path.c_str(), O_RDONLY | O_CLOEXEC));
+  UniqueFd null_fd(open("/dev/null", O_WRONLY | O_CLOEXEC));
+  FdInput input(file_fd.get());
+  FdOutput output(null_fd.get());
+
+  const std::vector<Case> cases = {
+      {"tr a-z A-Z", "tr a-z A-Z <", {"a-z", "A-Z"}, false},
+      {"tr -d '\\r'", "tr -d '\\r' <", {"-d", "\\r"}, false},
+      {"cut -d, -f3", "cut -d, -f3", {"-d,", "-f3"}, true},
+  };
+  for (const auto& c : cases) {
+    const std::string command = c.external + " '" + path + "' > /dev/null";
+    double seconds = measure([&] {
+      if (std::system(command.c_str()) != 0) {
+        throw std::runtime_error("external command failed");
+      }
+    });
+    reportThroughput(c.name + "/external", bytes, seconds);
+
+    seconds = measure([&] {
+      lseek(file_fd.get(), 0, SEEK_SET);
+      if (c.cut) {
+        CutCommand(c.args).run(input, output);
+      } else {
+        TrCommand(c.args).run(input, output);
+      }
+    });
+    reportThroughput(c.name + "/builtin", bytes, seconds);
+  }
+
+  std::filesystem::remove(path);
+}
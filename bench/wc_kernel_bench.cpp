@@ -0,0 +1,64 @@
+#include <bench.hpp>
+
+#include <cpu_features.hpp>
+#include <text_kernels.hpp>
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace coreutils::bench {
+
+namespace {
+
+std::string makeText(size_t size) {
+  static constexpr std::string_view kWords[] = {
+      "the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog",
+      "\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82"};
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<size_t> word(0, std::size(kWords) - 1);
+  std::uniform_int_distribution<int> line_break(0, 11);
+
+  std::string text;
+  text.reserve(size + 16);
+  while (text.size() < size) {
+    text += kWords[word(rng)];
+    text.push_back(line_break(rng) == 0 ? '\n' : ' ');
+  }
+  text.resize(size);
+  return text;
+}
+
+}  // namespace
+
+}  // namespace coreutils::bench
+
+int main() {
+  using namespace coreutils;
+  using namespace coreutils::bench;
+
+  std::printf("detected: %s\n", std::string(toString(simdLevel())).c_str());
+
+  for (size_t size : {size_t{4} << 10, size_t{256} << 10, size_t{16} << 20,
+                      size_t{256} << 20}) {
+    const auto text = makeText(size);
+    const int repeats = size >= (size_t{256} << 20) ? 3 : 20;
+
+    for (auto level : {SimdLevel::kScalar, SimdLevel::kSse2, SimdLevel::kAvx2,
+                       SimdLevel::kAvx512}) {
+      if (level > simdLevel()) {
+        continue;
+      }
+      volatile size_t sink = 0;
+      double seconds = measure(
+          [&] {
+            bool in_word = false;
+            sink = sink +
+                   countText(level, text.data(), text.size(), in_word).words;
+          },
+          repeats);
+      reportThroughput("countText/" + std::string(toString(level)), size,
+                       seconds);
+    }
+  }
+}
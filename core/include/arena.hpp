@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+// Bump allocator for short-lived character data, such as the tokens of one
+// command line. Allocations are never freed individually: reset() drops all
+// of them at once and keeps the first block for reuse.
+class Arena final {
+ public:
+  static constexpr size_t kDefaultBlockSize = 4096;
+
+  explicit Arena(size_t block_size = kDefaultBlockSize)
+      : block_size_(block_size) {}
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // Uninitialized storage for `size` chars.
+  char* allocate(size_t size) {
+    if (size > left_) {
+      addBlock(std::max(size, block_size_));
+    }
+    char* result = current_;
+    current_ += size;
+    left_ -= size;
+    return result;
+  }
+
+  // Copies `text` into the arena; the view is valid until reset().
+  std::string_view copy(std::string_view text) {
+    char* data = allocate(text.size());
+    std::memcpy(data, text.data(), text.size());
+    return {data, text.size()};
+  }
+
+  void reset() {
+    if (blocks_.empty()) {
+      return;
+    }
+    blocks_.resize(1);
+    current_ = blocks_.front().data.get();
+    left_ = blocks_.front().size;
+  }
+
+ private:
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t size;
+  };
+
+  void addBlock(size_t size) {
+    blocks_.push_back({std::make_unique_for_overwrite<char[]>(size), size});
+    current_ = blocks_.back().data.get();
+    left_ = size;
+  }
+
+  size_t block_size_;
+  std::vector<Block> blocks_;
+  char* current_{nullptr};
+  size_t left_{0};
+};
+
+}  // namespace coreutils
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <output.hpp>
+
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+// Collects small writes into one large buffer and hands it to the Output in
+// big blocks. Data still buffered is only written by flush(), which must be
+// called once the output is complete.
+class BufferedWriter final {
+ public:
+  static constexpr size_t kDefaultCapacity = 256 * 1024;
+
+  explicit BufferedWriter(const Output& out,
+                          size_t capacity = kDefaultCapacity)
+      : out_(out), buffer_(capacity) {}
+
+  void write(std::string_view data) {
+    if (used_ + data.size() > buffer_.size()) {
+      flush();
+      if (data.size() > buffer_.size()) {
+        out_.write(data.data(), data.size());
+        return;
+      }
+    }
+    std::memcpy(buffer_.data() + used_, data.data(), data.size());
+    used_ += data.size();
+  }
+
+  void put(char ch) {
+    if (used_ == buffer_.size()) {
+      flush();
+    }
+    buffer_[used_++] = ch;
+  }
+
+  void flush() {
+    if (used_ != 0) {
+      out_.write(buffer_.data(), used_);
+      used_ = 0;
+    }
+  }
+
+ private:
+  const Output& out_;
+  std::vector<char> buffer_;
+  size_t used_{0};
+};
+
+}  // namespace coreutils
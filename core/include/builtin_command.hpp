@@ -0,0 +1,24 @@
+#pragma once
+
+#include <builtin_registry.hpp>
+#include <command.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace coreutils {
+
+// builtin NAME [ARG...]: runs the builtin NAME, never a program of the same
+// name. Throws std::invalid_argument when NAME is not a builtin.
+class BuiltinCommand final : public Command {
+ public:
+  BuiltinCommand(std::vector<std::string> args, const BuiltinContext& context);
+
+  int run(Input& in, Output& out) override;
+
+ private:
+  std::unique_ptr<Command> command_;
+};
+
+}  // namespace coreutils
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <command.hpp>
+#include <history.hpp>
+#include <variable_store.hpp>
+
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+// What a builtin may need from the shell besides its arguments.
+struct BuiltinContext {
+  VariableStore& variables;
+  History& history;
+};
+
+// Builds a builtin from its arguments. Throws std::invalid_argument on bad
+// arguments, like the command constructors do.
+using BuiltinFactory = std::unique_ptr<Command> (*)(
+    std::vector<std::string> args, const BuiltinContext& context);
+
+struct Builtin {
+  std::string_view name;
+  BuiltinFactory factory;
+};
+
+// Name -> factory table of the builtins. Builtins add themselves from their
+// own source files during static initialization, so dispatch never has to
+// know about them. The table stays sorted by name: a lookup is a binary
+// search over a contiguous array, however many builtins there are.
+class BuiltinRegistry final {
+ public:
+  static BuiltinRegistry& instance();
+
+  // `name` must outlive the registry. Returns false when the name is
+  // already registered.
+  bool add(std::string_view name, BuiltinFactory factory);
+
+  [[nodiscard]] const Builtin* find(std::string_view name) const;
+  [[nodiscard]] std::span<const Builtin> builtins() const { return table_; }
+
+ private:
+  std::vector<Builtin> table_;
+};
+
+// Factory of the builtins that are constructed from their arguments alone.
+template <typename T>
+std::unique_ptr<Command> makeBuiltin(std::vector<std::string> args,
+                                     const BuiltinContext& /*context*/) {
+  return std::make_unique<T>(std::move(args));
+}
+
+// Registers a builtin when constructed; defined at namespace scope in the
+// builtin's source file.
+struct BuiltinRegistrar {
+  BuiltinRegistrar(std::string_view name, BuiltinFactory factory) {
+    BuiltinRegistry::instance().add(name, factory);
+  }
+};
+
+}  // namespace coreutils
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <unique_fd.hpp>
+
+#include <atomic>
+#include <exception>
+
+namespace coreutils {
+
+// Thrown by reads and writes of a pipeline stage whose output is no longer
+// wanted: the stage downstream has finished, or its pipe has no reader
+// left (EPIPE). It is deliberately not a std::system_error, so commands
+// that report their own I/O errors let it through to the executor, which
+// ends the stage quietly.
+class PipelineCancelled final : public std::exception {
+ public:
+  [[nodiscard]] const char* what() const noexcept override {
+    return "pipeline cancelled";
+  }
+};
+
+// Cancellation of one pipeline stage: a flag checked on every read and
+// write, and an eventfd for stages that sleep in poll() instead.
+class Cancellation final {
+ public:
+  Cancellation();
+  Cancellation(const Cancellation&) = delete;
+  Cancellation& operator=(const Cancellation&) = delete;
+
+  void cancel();
+  [[nodiscard]] bool cancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+  // Readable once cancelled.
+  [[nodiscard]] int fd() const { return event_.get(); }
+
+ private:
+  std::atomic<bool> cancelled_{false};
+  UniqueFd event_;
+};
+
+// Makes `cancellation` that of the calling thread while in scope. Worker
+// threads a stage fans out to take the stage's own, captured with
+// currentCancellation() before they start; nullptr means none.
+class CancellationScope final {
+ public:
+  explicit CancellationScope(const Cancellation& cancellation);
+  explicit CancellationScope(const Cancellation* cancellation);
+  ~CancellationScope();
+  CancellationScope(const CancellationScope&) = delete;
+  CancellationScope& operator=(const CancellationScope&) = delete;
+
+ private:
+  const Cancellation* previous_;
+};
+
+// Cancellation of the calling thread, or nullptr outside of a pipeline.
+[[nodiscard]] const Cancellation* currentCancellation();
+
+// Throws PipelineCancelled once the calling thread's stage is cancelled.
+void throwIfCancelled();
+
+// Reports a write that failed with EPIPE. In a stage with a cancellation,
+// the reader that went away is the downstream stage, which has finished,
+// so this is PipelineCancelled. Anywhere else, as for a lone command or
+// the last stage writing to a closed stdout, it is an ordinary
+// std::system_error.
+[[noreturn]] void throwBrokenPipe(const char* what);
+
+// Descriptor that becomes readable once the calling thread's stage is
+// cancelled, for waits in poll(); -1, which poll() skips, outside of a
+// pipeline.
+[[nodiscard]] int cancellationFd();
+
+}  // namespace coreutils
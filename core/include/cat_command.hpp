@@ -9,13 +9,31 @@ namespace coreutils {
 
 class CatCommand final : public Command {
  public:
-  explicit CatCommand(std::vector<std::string> files)
-      : files_(std::move(files)) {}
+  struct Options {
+    bool number{false};            // -n flag
+    bool number_nonblank{false};   // -b flag
+    bool squeeze_blank{false};     // -s flag
+    bool show_ends{false};         // -E flag
+    bool show_tabs{false};         // -T flag
+    bool show_nonprinting{false};  // -v flag
+
+    // False when the input is copied through unchanged.
+    [[nodiscard]] bool transforms() const {
+      return number || number_nonblank || squeeze_blank || show_ends ||
+             show_tabs || show_nonprinting;
+    }
+  };
+
+  explicit CatCommand(std::vector<std::string> args);
 
   int run(Input& in, Output& out) override;
 
  private:
+  int copyUnchanged(Input& in, Output& out) const;
+  int copyFormatted(Input& in, Output& out) const;
+
   std::vector<std::string> files_;
+  Options options_;
 };
 
 }  // namespace coreutils
@@ -13,6 +13,7 @@ class CdCommand final : public Command {
   explicit CdCommand(std::vector<std::string> args);
 
   int run(Input& in, Output& out) override;
+  [[nodiscard]] bool changesShellState() const override { return true; }
 
  private:
   std::optional<std::string> target_;
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <span>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include <arena.hpp>
 #include <executor.hpp>
+#include <history.hpp>
 #include <input.hpp>
 #include <output.hpp>
 #include <parser.hpp>
@@ -19,16 +23,29 @@ class CLI final {
  public:
   explicit CLI(Parser& parser);
 
-  void runCli(Input& in, Output& out);
+  // Reads command lines from `in` until EOF or exit. Returns the exit
+  // status of the last command.
+  int runCli(Input& in, Output& out);
+
+  // Runs each line of an in-memory script, as for -c and script files;
+  // `in` is the stdin of the commands.
+  int runScript(std::string_view script, Input& in, Output& out);
 
  private:
-  int process(std::string&& line, Output& out, Input& in);
-  std::vector<CommandPtr> splitIntoCommands(std::vector<std::string>&& tokens);
+  int process(std::string_view line, Output& out, Input& in);
+  void openHistory();
+  std::string substitute(std::string_view command);
+  std::vector<CommandPtr> splitIntoCommands(
+      std::span<const std::string_view> tokens);
 
-  static CommandPtr createCommand(std::vector<std::string>&& tokens);
+  CommandPtr createCommand(std::span<const std::string_view> tokens);
 
   Parser parser_;
   Executor executor_;
+  Arena arena_;            // tokens of the line being processed
+  Input* input_{nullptr};  // stdin of the line being processed
+  History history_;
+  bool record_history_{false};  // set while reading from a terminal
 };
 
 }  // namespace coreutils
@@ -10,6 +10,12 @@ class Command {
   virtual ~Command() = default;
 
   virtual int run(Input& in, Output& out) = 0;
+
+  // True for builtins that change the shell itself: its working directory,
+  // its variables or whether it exits. Only the last stage of a pipeline
+  // may do that; earlier ones run on worker threads and, like subshells,
+  // have no effect.
+  [[nodiscard]] virtual bool changesShellState() const { return false; }
 };
 
 }  // namespace coreutils
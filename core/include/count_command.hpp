@@ -0,0 +1,29 @@
+#pragma once
+
+#include <command.hpp>
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace coreutils {
+
+// count [-n K] [file...]
+//
+// Counts how often each distinct line occurs, without sorting the input
+// first, and prints the counts in the format of `uniq -c`, most frequent
+// first; lines with equal counts keep the order of their first occurrence.
+// -n keeps only the K most frequent lines.
+class CountCommand final : public Command {
+ public:
+  explicit CountCommand(std::vector<std::string> args);
+
+  int run(Input& in, Output& out) override;
+
+ private:
+  std::vector<std::string> files_;
+  size_t top_{std::numeric_limits<size_t>::max()};  // -n flag
+};
+
+}  // namespace coreutils
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string_view>
+
+namespace coreutils {
+
+// Widest vector instruction set usable by the text kernels, ordered so that
+// a level implies every lower one. Every vector level also implies POPCNT.
+enum class SimdLevel {
+  kScalar,
+  kSse2,
+  kAvx2,
+  kAvx512,
+};
+
+// Detected once through CPUID and cached for the lifetime of the process.
+[[nodiscard]] SimdLevel simdLevel();
+
+[[nodiscard]] std::string_view toString(SimdLevel level);
+
+}  // namespace coreutils
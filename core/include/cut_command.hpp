@@ -0,0 +1,52 @@
+#pragma once
+
+#include <command.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+class BufferedWriter;
+
+// cut -f list [-d delim] [-s] [file...]
+// cut -b list | -c list [file...]
+//
+// Prints the selected fields (separated by a tab, or by -d) or bytes of
+// every line. A list holds N, N-M, N- and -M, separated by commas; -c
+// counts bytes like -b. Lines without the delimiter are printed whole,
+// or dropped with -s.
+//
+// Fields are located from bitmasks of the delimiters and newlines of a
+// whole block, and written straight out of the read buffer, so no line
+// is copied on its own.
+class CutCommand final : public Command {
+ public:
+  explicit CutCommand(std::vector<std::string> args);
+
+  int run(Input& in, Output& out) override;
+
+ private:
+  // Positions `first` to `last` (1-based, inclusive) of a list.
+  struct Range {
+    size_t first;
+    size_t last;
+  };
+
+  void parseList(std::string_view list);
+  void cutFd(int fd, BufferedWriter& writer);
+  void cutFields(std::string_view lines, BufferedWriter& writer);
+  void cutBytes(std::string_view lines, BufferedWriter& writer) const;
+
+  std::vector<std::string> files_;
+  std::vector<Range> ranges_;    // sorted and merged
+  bool fields_{false};           // -f flag
+  char delimiter_{'\t'};         // -d flag
+  bool only_delimited_{false};   // -s flag
+  std::vector<uint64_t> masks_;  // delimiter and newline bits of a block
+};
+
+}  // namespace coreutils
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+// All entries of one directory, read up front in large getdents64 batches.
+// Names live back to back in a single arena, each NUL-terminated, and are
+// addressed through an offset array, so a listing costs a few bytes of
+// overhead per entry instead of one allocation per name.
+class DirListing final {
+ public:
+  static constexpr size_t kDefaultBatchSize = 1024 * 1024;
+
+  // Does not take ownership of dirfd. "." and ".." are only listed when
+  // `include_dots` is set. Throws std::system_error.
+  explicit DirListing(int dirfd, bool include_dots = false,
+                      size_t batch_size = kDefaultBatchSize);
+
+  [[nodiscard]] size_t size() const { return types_.size(); }
+
+  // NUL-terminated, valid for the lifetime of the listing.
+  [[nodiscard]] std::string_view name(size_t index) const {
+    return {arena_.data() + offsets_[index],
+            offsets_[index + 1] - offsets_[index] - 1};
+  }
+
+  // DT_* value as reported by the file system, may be DT_UNKNOWN.
+  [[nodiscard]] unsigned char type(size_t index) const {
+    return types_[index];
+  }
+
+  // Entry indices ordered by name in byte order.
+  [[nodiscard]] std::vector<size_t> sortedByName() const;
+
+ private:
+  void add(std::string_view name, unsigned char type);
+
+  std::vector<char> arena_;
+  std::vector<size_t> offsets_;  // size() + 1 entries, the last one is the end
+  std::vector<unsigned char> types_;
+};
+
+}  // namespace coreutils
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace coreutils {
+
+// Batched directory reader on top of getdents64 (readdir elsewhere).
+// "." and ".." are skipped. Entry names point into the internal buffer, are
+// NUL-terminated and stay valid until the next call to next().
+class DirReader final {
+ public:
+  struct Entry {
+    std::string_view name;
+    unsigned char type;  // DT_* value, may be DT_UNKNOWN
+    ino_t ino;
+  };
+
+  static constexpr size_t kDefaultBufferSize = 64 * 1024;
+
+  // Does not take ownership of dirfd.
+  explicit DirReader(int dirfd, size_t buffer_size = kDefaultBufferSize);
+  ~DirReader();
+  DirReader(const DirReader&) = delete;
+  DirReader(DirReader&&) = delete;
+  DirReader& operator=(const DirReader&) = delete;
+  DirReader& operator=(DirReader&&) = delete;
+
+  // Returns false at the end of the directory, throws std::system_error.
+  bool next(Entry& entry);
+
+ private:
+  bool fill();
+
+  int fd_;
+  size_t capacity_;
+  std::unique_ptr<char[]> buffer_;
+  size_t pos_{0};
+  size_t size_{0};
+  void* dir_{nullptr};  // DIR* for the readdir fallback
+};
+
+// Resolves DT_UNKNOWN through fstatat() without following symlinks.
+[[nodiscard]] unsigned char resolveDirentType(int dirfd, const char* name,
+                                              unsigned char type);
+
+[[nodiscard]] unsigned char direntTypeFromMode(mode_t mode);
+
+}  // namespace coreutils
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+struct WalkEntry {
+  static constexpr size_t kNoDirectory = std::numeric_limits<size_t>::max();
+
+  int dirfd;              // parent directory, AT_FDCWD for roots
+  std::string_view name;  // NUL-terminated, relative to dirfd
+  std::string_view path;  // root-relative path for printing
+  unsigned char type;     // DT_* value, DT_UNKNOWN only if lstat failed
+  ino_t ino;
+  size_t depth;   // 0 for roots
+  size_t worker;  // index of the walking thread
+  // Directories are numbered 0, 1, ... in discovery order, so a directory
+  // always has a smaller id than everything below it. `id` is kNoDirectory
+  // for other entries, `parent_id` is kNoDirectory for roots.
+  size_t id;
+  size_t parent_id;
+};
+
+enum class WalkAction {
+  kContinue,
+  kSkip,  // do not descend into this directory
+};
+
+// Parallel directory traversal. Every worker owns a deque of pending
+// directories: it pops from the back of its own deque and steals from the
+// front of the others when it runs dry. Subdirectories are opened with
+// openat() relative to their parent, read in large getdents64 batches, and
+// d_type is used to avoid stat calls. Symlinks are reported but never
+// followed. The visitor runs on the walking threads, so file processing
+// happens right where the file was discovered.
+class DirWalker final {
+ public:
+  using Visitor = std::function<WalkAction(const WalkEntry&)>;
+  using ErrorHandler = std::function<void(std::string_view path, int error)>;
+
+  explicit DirWalker(size_t threads);
+
+  void setMaxDepth(size_t depth) { max_depth_ = depth; }
+
+  // Returns the number of directory ids handed out.
+  size_t walk(const std::vector<std::string>& roots, const Visitor& visit,
+              const ErrorHandler& on_error = {});
+
+ private:
+  size_t threads_;
+  size_t max_depth_{std::numeric_limits<size_t>::max()};
+};
+
+}  // namespace coreutils
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <command.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace coreutils {
+
+// du [-s] [-h] [-d N] [--apparent-size] [path...]
+//
+// Sizes are gathered on the parallel DirWalker into per-thread
+// accumulators and summed bottom-up once the walk is done. Files with
+// several hard links are counted once.
+class DuCommand final : public Command {
+ public:
+  explicit DuCommand(std::vector<std::string> args);
+
+  int run(Input& in, Output& out) override;
+
+ private:
+  [[nodiscard]] std::string formatSize(uint64_t bytes) const;
+
+  std::vector<std::string> paths_;
+  size_t max_depth_{std::numeric_limits<size_t>::max()};  // -d, -s flags
+  bool human_readable_{false};                            // -h flag
+  bool apparent_size_{false};  // --apparent-size flag
+};
+
+}  // namespace coreutils
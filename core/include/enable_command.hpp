@@ -0,0 +1,29 @@
+#pragma once
+
+#include <command.hpp>
+
+#include <string>
+#include <vector>
+
+namespace coreutils {
+
+// enable -f FILE NAME...: loads the builtins NAME from the plugin FILE (see
+// plugin_api.hpp). A plugin is opened once per session, and enabling a
+// builtin it already provided again is a no-op. Without operands, lists
+// the builtins. Throws std::invalid_argument on bad arguments.
+class EnableCommand final : public Command {
+ public:
+  explicit EnableCommand(std::vector<std::string> args);
+
+  int run(Input& in, Output& out) override;
+  // Loading registers builtins for the whole session; listing only reads.
+  [[nodiscard]] bool changesShellState() const override {
+    return !file_.empty();
+  }
+
+ private:
+  std::string file_;  // -f flag
+  std::vector<std::string> names_;
+};
+
+}  // namespace coreutils
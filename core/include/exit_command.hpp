@@ -11,6 +11,7 @@ class ExitCommand final : public Command {
     IsExit = true;
     return 0;
   }
+  [[nodiscard]] bool changesShellState() const override { return true; }
 };
 
 }  // namespace coreutils
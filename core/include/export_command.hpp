@@ -0,0 +1,29 @@
+#pragma once
+
+#include <command.hpp>
+#include <variable_store.hpp>
+
+#include <string>
+#include <vector>
+
+namespace coreutils {
+
+// export [NAME[=value]...]: marks shell variables for the environment of
+// child processes. Without operands, lists the exported variables.
+class ExportCommand final : public Command {
+ public:
+  ExportCommand(std::vector<std::string> args, VariableStore& variables)
+      : args_(std::move(args)), variables_(variables) {}
+
+  int run(Input& in, Output& out) override;
+  // Listing the exported variables only reads them.
+  [[nodiscard]] bool changesShellState() const override {
+    return !args_.empty();
+  }
+
+ private:
+  std::vector<std::string> args_;
+  VariableStore& variables_;
+};
+
+}  // namespace coreutils
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <command.hpp>
+#include <variable_store.hpp>
 
 #include <unistd.h>
 
@@ -11,13 +12,21 @@ namespace coreutils {
 
 class ExternalCommand : public Command {
  public:
-  ExternalCommand(std::string command, std::vector<std::string> args)
-      : command_(std::move(command)), args_(std::move(args)) {}
+  // Without `variables` the child inherits the environment of this process;
+  // otherwise it gets the variables exported from the shell. They are
+  // snapshotted here, on the shell's thread, since pipeline stages run
+  // concurrently.
+  ExternalCommand(std::string command, std::vector<std::string> args,
+                  const VariableStore* variables = nullptr)
+      : command_(std::move(command)),
+        args_(std::move(args)),
+        envp_(variables != nullptr ? variables->envp() : nullptr) {}
   int run(Input& in, Output& out) override;
 
  private:
   std::string command_;
   std::vector<std::string> args_;
+  char* const* envp_;
   pid_t child_{};
 };
 
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+namespace coreutils {
+
+// read(2) that retries on EINTR. Returns 0 at the end of input and throws
+// std::system_error on failure, or PipelineCancelled once the calling
+// pipeline stage is cancelled.
+size_t readFd(int fd, char* data, size_t size);
+
+// Copies everything from `from` (starting at its current offset) to `to`.
+// The data stays in the kernel when it can: sendfile() for mappable
+// sources, splice() when either side is a pipe, and a read/write loop
+// otherwise. Throws std::system_error on failure, and PipelineCancelled
+// once the stage is cancelled or its downstream stage stopped reading.
+void copyFd(int from, int to);
+
+}  // namespace coreutils
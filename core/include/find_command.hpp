@@ -0,0 +1,30 @@
+#pragma once
+
+#include <command.hpp>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace coreutils {
+
+// find [-s] [path...] [expression]
+//
+// The expression is compiled into a FindProgram and evaluated on the
+// parallel DirWalker. Matches are streamed out in per-worker blocks, in
+// discovery order; -s collects them and prints them sorted by path instead.
+class FindCommand final : public Command {
+ public:
+  explicit FindCommand(std::vector<std::string> args);
+
+  int run(Input& in, Output& out) override;
+
+ private:
+  std::vector<std::string> paths_;
+  std::vector<std::string> expression_;
+  std::optional<size_t> max_depth_;  // -maxdepth option
+  bool sorted_{false};               // -s flag
+};
+
+}  // namespace coreutils
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <dir_walker.hpp>
+#include <glob.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace coreutils {
+
+// A find expression compiled once into a flat list of instructions. Every
+// test overwrites a single result register; -a and -o become conditional
+// jumps over the right operand, so evaluation short-circuits without any
+// recursion, and the stat() needed by -size and -mtime only happens when
+// such a test is actually reached.
+//
+// Grammar, loosest binding first:
+//   expr    := and ( ("-o" | "-or") and )*
+//   and     := unary ( ["-a" | "-and"] unary )*
+//   unary   := ("!" | "-not") unary | "(" expr ")" | test
+//   test    := -name GLOB | -type [fdlbcps] | -size [+-]N[cwbkMG]
+//            | -mtime [+-]N | -true | -false
+class FindProgram final {
+ public:
+  // `now` is the reference time for -mtime. Throws std::invalid_argument.
+  FindProgram(const std::vector<std::string>& tokens, int64_t now);
+
+  [[nodiscard]] bool matches(const WalkEntry& entry) const;
+
+ private:
+  enum class Op : uint8_t {
+    kName,
+    kType,
+    kSize,
+    kMtime,
+    kConstant,
+    kNot,
+    kJumpIfFalse,
+    kJumpIfTrue,
+  };
+
+  // How a numeric test compares its operand: -N, N or +N.
+  enum class Compare : uint8_t { kLess, kEqual, kGreater };
+
+  struct Instruction {
+    Op op;
+    Compare compare{Compare::kEqual};
+    unsigned char type{0};  // kType: DT_* value
+    uint32_t index{0};      // kName: glob index; jumps: target instruction
+    int64_t value{0};       // kSize, kMtime operand; kConstant result
+    int64_t unit{1};        // kSize: bytes per unit
+  };
+
+  void parseOr(const std::vector<std::string>& tokens, size_t& pos);
+  void parseAnd(const std::vector<std::string>& tokens, size_t& pos);
+  void parseUnary(const std::vector<std::string>& tokens, size_t& pos);
+  void parseTest(const std::vector<std::string>& tokens, size_t& pos);
+  void patchJumps(const std::vector<size_t>& jumps);
+
+  std::vector<Instruction> code_;
+  std::vector<GlobPattern> globs_;
+  int64_t now_;
+};
+
+}  // namespace coreutils
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+// Shell wildcard pattern supporting `*`, `?`, `[...]`/`[!...]` classes and
+// backslash escapes. The pattern is compiled once into literal-or-class
+// atoms split at `*`. Matching never backtracks: the first and last segments
+// are anchored, and every middle segment is taken at its leftmost match,
+// which is always sufficient for globs.
+class GlobPattern final {
+ public:
+  explicit GlobPattern(std::string_view pattern);
+
+  [[nodiscard]] bool match(std::string_view text) const;
+
+  // True when the pattern contains unescaped wildcards.
+  [[nodiscard]] bool hasWildcards() const { return has_wildcards_; }
+
+  // True when the pattern starts with a literal '.'.
+  [[nodiscard]] bool matchesLeadingDot() const { return leading_dot_; }
+
+ private:
+  struct Atom {
+    enum class Kind : uint8_t { kChar, kAny, kClass };
+    Kind kind;
+    char ch;
+    uint32_t class_index;
+  };
+
+  struct Segment {
+    size_t begin;  // index into atoms_
+    size_t end;
+    std::string literal;  // filled when every atom is a plain character
+    bool is_literal;
+  };
+
+  [[nodiscard]] bool atomMatches(const Atom& atom, char ch) const;
+  [[nodiscard]] bool segmentMatchesAt(const Segment& segment,
+                                      std::string_view text,
+                                      size_t pos) const;
+  [[nodiscard]] size_t findSegment(const Segment& segment,
+                                   std::string_view text, size_t from) const;
+
+  std::vector<Atom> atoms_;
+  std::vector<std::bitset<256>> classes_;
+  std::vector<Segment> segments_;
+  bool has_wildcards_{false};
+  bool leading_dot_{false};
+};
+
+}  // namespace coreutils
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <arena.hpp>
+#include <dir_listing.hpp>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace coreutils {
+
+// Pathname expansion of shell words. Each '/'-separated component with
+// wildcards is matched with GlobPattern against a DirListing of the
+// directories reached so far. Listings are cached until clear(), so globs
+// on one command line that hit the same directory read it only once.
+class GlobExpander final {
+ public:
+  // Appends the paths matching `pattern` to `out` in byte order, copied into
+  // `arena`. Backslash escapes a character in the pattern. Returns false
+  // and appends nothing when no path matches.
+  bool expand(std::string_view pattern, Arena& arena,
+              std::vector<std::string_view>& out);
+
+  void clear() { directories_.clear(); }
+
+ private:
+  struct Directory {
+    DirListing listing;
+    std::vector<size_t> order;  // entry indices sorted by name
+  };
+
+  // The listing of `path` ("" is the working directory), or nullptr when
+  // it cannot be read.
+  const Directory* list(const std::string& path);
+
+  std::unordered_map<std::string, std::optional<Directory>> directories_;
+  std::vector<std::string> prefixes_;
+  std::vector<std::string> next_prefixes_;
+};
+
+}  // namespace coreutils
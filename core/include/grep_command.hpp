@@ -1,9 +1,12 @@
 #pragma once
 
 #include <command.hpp>
+#include <glob.hpp>
 
+#include <optional>
 #include <regex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace coreutils {
@@ -15,22 +18,48 @@ class GrepCommand final : public Command {
   int run(Input& in, Output& out) override;
 
  private:
+  // Where the scan of an input stopped, so that it can go on in the next
+  // block of that input.
+  struct ScanState {
+    size_t line_number{1};  // number of the first line of the next block
+    size_t offset{0};       // byte offset of the next block
+    bool printed_any{false};
+    size_t printed_end{0};  // offset right after the last printed line
+    int context_left{0};
+  };
+
   void parseArgs(std::vector<std::string> args);
   [[nodiscard]] std::regex buildRegex() const;
-  [[nodiscard]] bool matchesLine(const std::string& line,
+  [[nodiscard]] bool matchesLine(std::string_view line,
                                  const std::regex& regex) const;
-  int processFile(const std::string& filename, Output& out);
-  int processInput(Input& in, Output& out);
-  void outputMatchingLines(const std::vector<std::string>& lines,
-                           const std::regex& regex, Output& out,
-                           const std::string& filename = "") const;
+  [[nodiscard]] bool findMatchingLine(std::string_view content, size_t from,
+                                      const std::regex& regex,
+                                      size_t& line_begin,
+                                      size_t& line_end) const;
+  void scanBuffer(std::string_view content, const std::regex& regex,
+                  std::string_view filename, std::string& result,
+                  ScanState& state) const;
+  int processInput(Input& in, Output& out, const std::regex& regex);
+  int processFiles(Output& out, const std::regex& regex);
+  int processRecursive(Output& out, const std::regex& regex);
+  [[nodiscard]] bool isFileSelected(std::string_view name) const;
+  [[nodiscard]] bool isDirectorySelected(std::string_view name) const;
 
   std::string pattern_;
   std::vector<std::string> files_;
   bool case_insensitive_{false};  // -i flag
   bool whole_word_{false};        // -w flag
   int after_context_{0};          // -A flag
+  bool recursive_{false};         // -r flag
+  bool line_numbers_{false};      // -n flag
+  bool byte_offsets_{false};      // -b flag
+  std::vector<GlobPattern> include_globs_;      // --include
+  std::vector<GlobPattern> exclude_globs_;      // --exclude
+  std::vector<GlobPattern> exclude_dir_globs_;  // --exclude-dir
+
+  // Set when the pattern has no regex metacharacters, so candidate lines
+  // can be located with memmem() instead of running the regex on each line.
+  std::optional<std::string> literal_;
 };
 
 }  // namespace coreutils
-
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <command.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace coreutils {
+
+// head [-n N | -c N | -N] [file...]
+//
+// Prints the first N lines (default 10), or with -c the first N bytes, of
+// each file. Reading stops as soon as they are out, which in a pipeline
+// cancels the stages feeding head. Input read past them is handed back on
+// seekable descriptors. Several files are introduced by "==> name <==".
+class HeadCommand final : public Command {
+ public:
+  explicit HeadCommand(std::vector<std::string> args);
+
+  int run(Input& in, Output& out) override;
+
+ private:
+  void parseCount(std::string_view value);
+  void copyHead(int fd, const Output& out) const;
+
+  std::vector<std::string> files_;
+  size_t count_{10};   // -n or -c flag
+  bool bytes_{false};  // -c flag
+};
+
+}  // namespace coreutils
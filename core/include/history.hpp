@@ -0,0 +1,91 @@
+#pragma once
+
+#include <arena.hpp>
+#include <mapped_file.hpp>
+#include <unique_fd.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+// Command history kept in an append-only file with one command per line.
+// Every command is appended with a single O_APPEND write, so concurrent
+// sessions interleave whole lines. Opening the file reads nothing: the
+// file is mapped and indexed on the first lookup.
+//
+// The index keeps every line of the file in order, and a hash table that
+// points each distinct command at its latest occurrence, so lookups see
+// every command once at its most recent position. Searches filter lines
+// through 64-bit trigram signatures before comparing any text. The
+// signatures are stored bit-sliced, one bitmap over all lines per
+// signature bit, so a search only reads the bitmaps of the bits its text
+// sets, 64 lines per word. They are computed on the first search and
+// extended as commands are added.
+class History final {
+ public:
+  // Without a file, the history lives in memory only.
+  History() = default;
+  History(const History&) = delete;
+  History& operator=(const History&) = delete;
+
+  // Appends to `path` from now on, creating it if needed. Throws
+  // std::system_error when the file cannot be opened.
+  void open(const std::string& path);
+  [[nodiscard]] bool isOpen() const { return fd_.get() >= 0; }
+
+  // Records a command line. Blank lines and repeats of the previous
+  // command are skipped.
+  void add(std::string_view line);
+
+  // Distinct commands, oldest first.
+  [[nodiscard]] std::vector<std::string_view> entries();
+
+  // Up to `limit` distinct commands containing `text`, most recent first.
+  [[nodiscard]] std::vector<std::string_view> search(std::string_view text,
+                                                     size_t limit);
+
+ private:
+  static constexpr uint32_t kEmptySlot = UINT32_MAX;
+  static constexpr size_t kInitialSlots = 64;
+  static constexpr size_t kSignatureBits = 64;
+
+  // Line id and the high half of its hash, which settles most probes
+  // without touching the text.
+  struct Slot {
+    uint32_t id{kEmptySlot};
+    uint32_t tag{0};
+  };
+
+  void load();
+  void index(std::string_view line);
+  void buildSignatures();
+  [[nodiscard]] bool isLatest(uint32_t id) const;
+  void reserve(size_t lines);
+  void rehash(size_t slot_count);
+
+  UniqueFd fd_;
+  std::string path_;
+  std::string last_;  // previous command, for skipping repeats
+
+  bool loaded_{false};
+  std::optional<MappedFile> file_;  // the file as it was when loaded
+  Arena added_;                     // commands added after loading
+
+  // Every command in order of addition, duplicates included.
+  std::vector<std::string_view> lines_;
+  // The latest occurrence of each distinct command, probed
+  // linearly; the size is a power of two and at least twice the count.
+  std::vector<Slot> slots_;
+  size_t distinct_{0};
+  // Bit b of the signature of line id is bit id % 64 of
+  // signature_bits_[b][id / 64]. Covers the first `signed_` lines.
+  std::vector<uint64_t> signature_bits_[kSignatureBits];
+  size_t signed_{0};
+};
+
+}  // namespace coreutils
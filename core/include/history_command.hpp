@@ -0,0 +1,31 @@
+#pragma once
+
+#include <command.hpp>
+#include <history.hpp>
+
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace coreutils {
+
+// history [-s TEXT] [N]
+//
+// Lists the distinct commands of the history, numbered and oldest first,
+// or with -s the commands containing TEXT, most recent first. N limits the
+// output to the last N commands, or to the N most recent matches.
+class HistoryCommand final : public Command {
+ public:
+  HistoryCommand(std::vector<std::string> args, History& history);
+
+  int run(Input& in, Output& out) override;
+
+ private:
+  History& history_;
+  std::optional<std::string> search_;                  // -s flag
+  size_t limit_{std::numeric_limits<size_t>::max()};  // N
+};
+
+}  // namespace coreutils
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <arena.hpp>
+#include <input.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+// Occurrence counts of distinct lines in a flat open-addressing table.
+// Lines are interned into an arena on first sight, so the input buffers
+// can be reused while counting goes on.
+class LineCounter final {
+ public:
+  struct Entry {
+    std::string_view line;
+    uint64_t count;
+    uint64_t first;  // position of the first occurrence
+    size_t hash;
+  };
+
+  LineCounter() = default;
+  LineCounter(const LineCounter&) = delete;
+  LineCounter& operator=(const LineCounter&) = delete;
+  LineCounter(LineCounter&&) = default;
+  LineCounter& operator=(LineCounter&&) = default;
+
+  // Counts one occurrence of `line` at `position`, any value that orders
+  // occurrences, such as the byte offset in the input.
+  void add(std::string_view line, uint64_t position);
+
+  // Adds the counts of `other`, keeping the earlier first occurrence.
+  void merge(const LineCounter& other);
+
+  // Distinct lines in no particular order.
+  [[nodiscard]] std::span<const Entry> entries() const { return entries_; }
+
+ private:
+  static constexpr uint32_t kEmptySlot = UINT32_MAX;
+  static constexpr size_t kInitialSlots = 1024;
+
+  Entry& findOrInsert(std::string_view line, size_t hash, uint64_t position);
+  void rehash(size_t slot_count);
+
+  // Behind a pointer so that the interned views survive moves.
+  std::unique_ptr<Arena> arena_{std::make_unique<Arena>(64 * 1024)};
+  std::vector<Entry> entries_;
+  // Indices into entries_, probed linearly; the size is a power of two and
+  // kept at least twice the number of entries.
+  std::vector<uint32_t> slots_;
+};
+
+// Counts the lines of each file, or of `in` when there are none, with one
+// partial table per worker merged at the end. A last line without a
+// newline still counts. Files that cannot be read are reported as
+// "name: file: error" and make the result false; the rest is counted.
+bool countLines(const std::vector<std::string>& files, Input& in,
+                std::string_view name, LineCounter& result);
+
+}  // namespace coreutils
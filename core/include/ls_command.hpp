@@ -10,13 +10,21 @@ namespace coreutils {
 
 class LsCommand final : public Command {
  public:
+  struct Options {
+    bool long_format{false};   // -l flag
+    bool all{false};           // -a flag
+    bool sort_by_size{false};  // -S flag
+    bool sort_by_time{false};  // -t flag
+    bool recursive{false};     // -R flag
+  };
+
   explicit LsCommand(std::vector<std::string> args);
 
   int run(Input& in, Output& out) override;
 
  private:
   std::optional<std::string> target_;
+  Options options_;
 };
 
 }  // namespace coreutils
-
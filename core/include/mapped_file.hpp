@@ -0,0 +1,34 @@
+#pragma once
+
+#include <fcntl.h>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace coreutils {
+
+// Read-only view of a whole file. Regular files are mmapped; anything else
+// (pipes, character devices, procfs entries reporting size 0) is read into
+// an owned buffer. Throws std::system_error when the file cannot be opened.
+class MappedFile final {
+ public:
+  explicit MappedFile(const std::string& path) : MappedFile(AT_FDCWD, path.c_str()) {}
+  MappedFile(int dirfd, const char* path);
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile& operator=(MappedFile&&) = delete;
+
+  [[nodiscard]] std::string_view view() const { return {data_, size_}; }
+
+ private:
+  int fd_{-1};
+  const char* data_{nullptr};
+  size_t size_{0};
+  bool mapped_{false};
+  std::string buffer_;
+};
+
+}  // namespace coreutils
@@ -14,7 +14,9 @@ class Output {
   Output& operator=(const Output&) noexcept = delete;
   Output& operator=(Output&&) noexcept = default;
 
-  void write(const char* data, size_t size) const;
+  // Writes everything to fd(); outputs that are not backed by a
+  // descriptor override this.
+  virtual void write(const char* data, size_t size) const;
   void write(const std::vector<char>& data) const;
   void write(const std::string& data) const;
   void setStdout() const;
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cancellation.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace coreutils {
+
+[[nodiscard]] inline size_t workerCount() {
+  return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+// Calls func(index, worker) for every index in [0, count) on up to `threads`
+// workers. Indices are handed out dynamically, so uneven items balance out.
+// The first exception thrown by func is rethrown on the calling thread, and
+// no more indices are handed out after it. Workers run under the caller's
+// cancellation, so a cancelled stage stops them too.
+template <typename Func>
+void parallelFor(size_t count, size_t threads, Func&& func) {
+  threads = std::min(threads, count);
+  if (threads <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      throwIfCancelled();
+      func(i, size_t{0});
+    }
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+
+  const Cancellation* cancellation = currentCancellation();
+  auto worker = [&](size_t worker_id) {
+    CancellationScope scope(cancellation);
+    try {
+      for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count;
+           i = next.fetch_add(1, std::memory_order_relaxed)) {
+        throwIfCancelled();
+        func(i, worker_id);
+      }
+    } catch (...) {
+      std::lock_guard lock(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+      next.store(count, std::memory_order_relaxed);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (size_t i = 1; i < threads; ++i) {
+    pool.emplace_back(worker, i);
+  }
+  worker(0);
+  for (auto& thread : pool) {
+    thread.join();
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace coreutils
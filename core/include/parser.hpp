@@ -1,23 +1,73 @@
 #pragma once
 
+#include <arena.hpp>
+#include <glob_expander.hpp>
+#include <shell_char_index.hpp>
+#include <variable_store.hpp>
+
+#include <functional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace coreutils {
 
 class Parser final {
  public:
+  // Seeds the shell variables from the process environment.
+  Parser();
+
+  // Splits a command line into tokens after applying its leading VAR=value
+  // assignments. Tokens that appear verbatim in `line` are views into it;
+  // only tokens assembled from quotes or variables are copied, into
+  // `arena`. The result stays valid while `line` is alive and the arena
+  // has not been reset.
+  std::vector<std::string_view> tokenize(std::string_view line, Arena& arena);
+
+  // tokenize() with every token copied out.
   std::vector<std::string> parseToTokens(std::string&& raw_input);
 
+  // Runs the command line of a $(...) or `...` substitution and returns
+  // its output. Without a runner, substitutions expand to nothing.
+  using SubstitutionRunner = std::function<std::string(std::string_view)>;
+  void setSubstitutionRunner(SubstitutionRunner runner) {
+    run_substitution_ = std::move(runner);
+  }
+
+  VariableStore& variables() { return variables_; }
+  [[nodiscard]] const VariableStore& variables() const { return variables_; }
+
  private:
-  std::string expandVariables(const std::string& str, bool expand);
-  bool tryParseAssignment(std::string_view input, size_t& pos);
-  void handleDollarSign(std::string_view input, size_t& pos,
-                        std::string& current_token);
+  // The word being assembled. Spans of `text` that came from quotes or
+  // expansions are recorded so that only unquoted wildcards glob.
+  struct Word {
+    std::string text;
+    std::vector<std::pair<size_t, size_t>> literal;  // [begin, end) spans
+    bool has_wildcards{false};
+
+    void appendLiteral(std::string_view part);
+    void appendPlain(std::string_view part, bool wildcards);
+    void clear();
+    [[nodiscard]] std::string globPattern() const;
+  };
+
+  [[nodiscard]] std::string_view lookupVariable(std::string_view name) const;
+  bool tryParseAssignment(std::string_view input, size_t& pos, Arena& arena);
+  std::string substitute(std::string_view command);
+  void finishWord(std::vector<std::string_view>& tokens, Arena& arena);
+  void appendFields(std::string_view text,
+                    std::vector<std::string_view>& tokens, Arena& arena);
+  size_t assembleWord(std::string_view input, size_t pos,
+                      std::vector<std::string_view>& tokens, Arena& arena,
+                      bool split_fields = true);
 
  private:
-  std::unordered_map<std::string, std::string> env_variables_;
+  VariableStore variables_;
+  SubstitutionRunner run_substitution_;
+  ShellCharIndex index_;  // special characters of the line being tokenized
+  GlobExpander globber_;  // caches directory listings for one line
+  Word word_;             // reused buffer for tokens that must be assembled
 };
 
 }  // namespace coreutils
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <builtin_registry.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace coreutils {
+
+// Builtins can be loaded at runtime from shared objects with
+// `enable -f lib.so NAME...`. A plugin implements Command against the
+// Input and Output interfaces and exports a table of factories through
+// COREUTILS_PLUGIN. The shell exports its own symbols (-rdynamic), so the
+// plugin resolves Input::read(), Output::write() and the rest against the
+// running shell instead of linking the core objects a second time.
+//
+// The ABI is the C++ ABI of these headers. kPluginAbiVersion has to be
+// bumped whenever Command, Input, Output, Builtin, BuiltinContext or
+// PluginInfo change, and the shell refuses plugins built for another one.
+constexpr uint32_t kPluginAbiVersion = 2;
+
+struct PluginInfo {
+  uint32_t abi_version;
+  const Builtin* builtins;
+  size_t count;
+};
+
+// Name of the extern "C" function that returns the PluginInfo.
+constexpr const char* kPluginEntryPoint = "coreutils_plugin";
+
+}  // namespace coreutils
+
+// Defines the entry point of a plugin; `builtins` is an array of Builtin
+// with static storage duration.
+#define COREUTILS_PLUGIN(builtins)                                   \
+  extern "C" const coreutils::PluginInfo* coreutils_plugin() {       \
+    static const coreutils::PluginInfo info{                         \
+        coreutils::kPluginAbiVersion, std::data(builtins),           \
+        std::size(builtins)};                                        \
+    return &info;                                                    \
+  }
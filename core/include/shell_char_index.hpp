@@ -0,0 +1,86 @@
+#pragma once
+
+#include <text_kernels.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+// Structural index of one command line: the bytes the tokenizer cares about
+// are classified 64 at a time into bitmasks, and the parser then jumps
+// between them with count-trailing-zeros instead of testing every byte.
+class ShellCharIndex final {
+ public:
+  // Indexes `text`, reusing the storage of the previous line.
+  void build(std::string_view text) {
+    size_ = text.size();
+    blocks_.resize((size_ + kBlock - 1) / kBlock);
+    classifyShellChars(text.data(), text.size(), blocks_.data());
+  }
+
+  // Each returns the first matching position at or after `pos`, or the
+  // size of the text when there is none.
+  [[nodiscard]] size_t nextSpace(size_t pos) const {
+    return next(pos, [](const ShellCharMasks& m) { return m.space; });
+  }
+  [[nodiscard]] size_t nextNonSpace(size_t pos) const {
+    return next(pos, [](const ShellCharMasks& m) { return ~m.space; });
+  }
+  [[nodiscard]] size_t nextBreak(size_t pos) const {
+    return next(pos, [](const ShellCharMasks& m) { return m.breaks; });
+  }
+  [[nodiscard]] size_t nextBreakOrEquals(size_t pos) const {
+    return next(pos,
+                [](const ShellCharMasks& m) { return m.breaks | m.equals; });
+  }
+
+  // True when [begin, end) holds a glob wildcard; only the blocks of the
+  // range are examined.
+  [[nodiscard]] bool hasWildcard(size_t begin, size_t end) const {
+    if (begin >= end) {
+      return false;
+    }
+    const size_t first = begin / kBlock;
+    const size_t last = (end - 1) / kBlock;
+    for (size_t block = first; block <= last; ++block) {
+      uint64_t mask = blocks_[block].wildcards;
+      if (block == first) {
+        mask &= ~uint64_t{0} << (begin % kBlock);
+      }
+      if (block == last && end % kBlock != 0) {
+        mask &= (uint64_t{1} << (end % kBlock)) - 1;
+      }
+      if (mask != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  static constexpr size_t kBlock = 64;
+
+  template <typename MaskFn>
+  size_t next(size_t pos, MaskFn mask_of) const {
+    for (size_t block = pos / kBlock; block < blocks_.size(); ++block) {
+      uint64_t mask = mask_of(blocks_[block]);
+      if (block == pos / kBlock) {
+        mask &= ~uint64_t{0} << (pos % kBlock);
+      }
+      if (mask != 0) {
+        return std::min(block * kBlock + std::countr_zero(mask), size_);
+      }
+    }
+    return size_;
+  }
+
+  std::vector<ShellCharMasks> blocks_;
+  size_t size_{0};
+};
+
+}  // namespace coreutils
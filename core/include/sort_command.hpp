@@ -0,0 +1,58 @@
+#pragma once
+
+#include <command.hpp>
+#include <unique_fd.hpp>
+
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+// sort [-n] [-r] [-u] [-t SEP] [-k POS1[,POS2]] [-S SIZE] [file...]
+//
+// Lines are read into chunks of at most SIZE bytes (default 256M), each
+// sorted in parallel slices that are then merged. Input that does not fit
+// in one chunk is written out as sorted runs to unlinked temporary files
+// and k-way merged. Keys compare bytewise, as in the C locale; lines with
+// equal keys are ordered by the whole line unless -u is given, which keeps
+// the first line of each group of equal keys.
+class SortCommand final : public Command {
+ public:
+  explicit SortCommand(std::vector<std::string> args);
+
+  int run(Input& in, Output& out) override;
+
+ private:
+  void parseKey(std::string_view spec);
+  void parseMemory(std::string_view size);
+  // A line with its key located and, for -n, parsed.
+  struct Record;
+
+  // Orders two lines; negative, zero or positive like strcmp. Zero only
+  // for lines that -u treats as duplicates, or identical lines.
+  [[nodiscard]] int compare(std::string_view lhs, std::string_view rhs) const;
+  [[nodiscard]] int compare(const Record& lhs, const Record& rhs) const;
+  [[nodiscard]] Record recordOf(std::string_view line) const;
+  [[nodiscard]] std::string_view keyOf(std::string_view line) const;
+  void sortLines(std::vector<std::string_view>& lines) const;
+  void writeLines(const std::vector<std::string_view>& lines,
+                  const Output& out) const;
+  [[nodiscard]] UniqueFd spill(const std::vector<std::string_view>& lines) const;
+  void mergeRuns(std::vector<UniqueFd>& runs, const Output& out) const;
+
+  std::vector<std::string> files_;
+  bool numeric_{false};                 // -n flag
+  bool reverse_{false};                 // -r flag
+  bool unique_{false};                  // -u flag
+  std::optional<char> separator_;       // -t flag
+  // -k flag: 0-based first and last field of the key.
+  size_t key_begin_{0};
+  size_t key_end_{std::numeric_limits<size_t>::max()};
+  size_t memory_{size_t{256} << 20};    // -S flag, in bytes
+};
+
+}  // namespace coreutils
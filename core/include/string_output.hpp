@@ -0,0 +1,28 @@
+#pragma once
+
+#include <output.hpp>
+
+#include <string>
+
+namespace coreutils {
+
+// Collects everything written into a string, so builtins can run without a
+// pipe. It has no descriptor: fd() is -1, and it cannot become the stdout
+// of a child process.
+class StringOutput final : public Output {
+ public:
+  using Output::write;
+  void write(const char* data, size_t size) const override {
+    str_.append(data, size);
+  }
+
+  [[nodiscard]] int fd() const override { return -1; }
+
+  [[nodiscard]] const std::string& str() const& { return str_; }
+  [[nodiscard]] std::string&& str() && { return std::move(str_); }
+
+ private:
+  mutable std::string str_;
+};
+
+}  // namespace coreutils
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace coreutils {
+
+namespace detail {
+
+// Ranges shorter than this are finished with std::sort.
+constexpr size_t kSmallSortSize = 32;
+constexpr size_t kKeyBytes = sizeof(uint64_t);
+
+// The 8 bytes of `value` starting at `depth`, zero-padded and loaded
+// big-endian, so that comparing keys as integers compares those bytes in
+// unsigned lexicographic order.
+inline uint64_t loadSortKey(std::string_view value, size_t depth) {
+  if (depth + kKeyBytes <= value.size()) {
+    uint64_t key = 0;
+    std::memcpy(&key, value.data() + depth, kKeyBytes);
+    return __builtin_bswap64(key);
+  }
+  uint64_t key = 0;
+  for (size_t i = depth; i < value.size(); ++i) {
+    key |= uint64_t{static_cast<unsigned char>(value[i])}
+           << (8 * (kKeyBytes - 1 - (i - depth)));
+  }
+  return key;
+}
+
+template <typename T>
+struct SortItem {
+  uint64_t key;
+  T value;
+};
+
+// MSD radix sort over the cached keys: each pass distributes the range by
+// one key byte in place (American flag sort), so the strings themselves
+// are only touched when a key is reloaded for the next 8 bytes.
+template <typename T, typename KeyFn>
+void sortItems(std::span<SortItem<T>> items, size_t byte, size_t depth,
+               KeyFn& key_of) {
+  while (items.size() > 1) {
+    if (items.size() < kSmallSortSize) {
+      std::sort(items.begin(), items.end(),
+                [&](const SortItem<T>& lhs, const SortItem<T>& rhs) {
+                  if (lhs.key != rhs.key) {
+                    return lhs.key < rhs.key;
+                  }
+                  const std::string_view left = key_of(lhs.value);
+                  const std::string_view right = key_of(rhs.value);
+                  return left.substr(std::min(depth, left.size())) <
+                         right.substr(std::min(depth, right.size()));
+                });
+      return;
+    }
+
+    if (byte == kKeyBytes) {
+      // All keys are equal. Strings that end within this key are prefixes
+      // of all the longer ones, so they go first, shortest first; the rest
+      // continue with the next 8 bytes.
+      const auto long_begin = std::partition(
+          items.begin(), items.end(), [&](const SortItem<T>& item) {
+            return key_of(item.value).size() <= depth + kKeyBytes;
+          });
+      std::sort(items.begin(), long_begin,
+                [&](const SortItem<T>& lhs, const SortItem<T>& rhs) {
+                  return key_of(lhs.value).size() < key_of(rhs.value).size();
+                });
+      items = items.subspan(static_cast<size_t>(long_begin - items.begin()));
+      depth += kKeyBytes;
+      for (auto& item : items) {
+        item.key = loadSortKey(key_of(item.value), depth);
+      }
+      byte = 0;
+      continue;
+    }
+
+    const unsigned shift = 8 * (kKeyBytes - 1 - byte);
+    auto digit = [shift](const SortItem<T>& item) {
+      return static_cast<size_t>((item.key >> shift) & 0xFF);
+    };
+
+    std::array<size_t, 256> counts{};
+    for (const auto& item : items) {
+      ++counts[digit(item)];
+    }
+    if (counts[digit(items[0])] == items.size()) {
+      ++byte;
+      continue;
+    }
+
+    std::array<size_t, 256> next{};
+    std::array<size_t, 256> end{};
+    size_t offset = 0;
+    for (size_t bucket = 0; bucket < counts.size(); ++bucket) {
+      next[bucket] = offset;
+      offset += counts[bucket];
+      end[bucket] = offset;
+    }
+    for (size_t bucket = 0; bucket < counts.size(); ++bucket) {
+      while (next[bucket] < end[bucket]) {
+        auto item = items[next[bucket]];
+        for (size_t target = digit(item); target != bucket;
+             target = digit(item)) {
+          std::swap(item, items[next[target]++]);
+        }
+        items[next[bucket]++] = item;
+      }
+    }
+
+    size_t begin = 0;
+    for (size_t bucket = 0; bucket < counts.size(); ++bucket) {
+      if (counts[bucket] > 1) {
+        sortItems(items.subspan(begin, counts[bucket]), byte + 1, depth,
+                  key_of);
+      }
+      begin += counts[bucket];
+    }
+    return;
+  }
+}
+
+}  // namespace detail
+
+// Sorts `values` by the string `key_of(value)` in unsigned byte order, the
+// same order as std::string's operator<. Not stable. `key_of` must be
+// cheap: it is called again whenever a tie needs more bytes.
+template <typename T, typename KeyFn>
+void radixSort(std::span<T> values, KeyFn key_of) {
+  std::vector<detail::SortItem<T>> items;
+  items.reserve(values.size());
+  for (const auto& value : values) {
+    items.push_back({detail::loadSortKey(key_of(value), 0), value});
+  }
+  detail::sortItems(std::span(items), 0, 0, key_of);
+  for (size_t i = 0; i < items.size(); ++i) {
+    values[i] = std::move(items[i].value);
+  }
+}
+
+}  // namespace coreutils
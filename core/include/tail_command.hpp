@@ -0,0 +1,42 @@
+#pragma once
+
+#include <command.hpp>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+// tail [-n N | -c N | -N] [-f | -F] [file...]
+//
+// Prints the last N lines (default 10), or with -c the last N bytes, of
+// each file. Regular files are read backwards from the end, so only the
+// printed part is read; other input streams through a ring of blocks that
+// keeps just enough of it. -f then waits for data appended to the files,
+// woken by inotify rather than polling; -F follows the names instead, so a
+// rotated file is picked up again once it is recreated. Following ends
+// when nothing reads the output any more. Standard input is not followed.
+class TailCommand final : public Command {
+ public:
+  explicit TailCommand(std::vector<std::string> args);
+
+  int run(Input& in, Output& out) override;
+
+ private:
+  struct Followed;
+
+  void parseCount(std::string_view value);
+  void writeTail(int fd, const Output& out) const;
+  void writeStreamTail(int fd, const Output& out) const;
+  void follow(std::vector<Followed>& files, const Output& out) const;
+
+  std::vector<std::string> files_;
+  size_t count_{10};     // -n or -c flag
+  bool bytes_{false};    // -c flag
+  bool follow_{false};   // -f or -F flag
+  bool by_name_{false};  // -F flag
+};
+
+}  // namespace coreutils
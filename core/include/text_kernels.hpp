@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cpu_features.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+// Number of occurrences of `byte` in [data, data + size), counted with the
+// widest SIMD variant the CPU supports.
+[[nodiscard]] size_t countByte(const char* data, size_t size, char byte);
+
+// Same, but forces a particular variant. The level must be supported by the
+// running CPU; used by tests to compare the variants against each other.
+[[nodiscard]] size_t countByte(SimdLevel level, const char* data, size_t size,
+                               char byte);
+
+// Counters produced by the wc kernels. A word is a maximal run of bytes
+// that are not C-locale whitespace (space, \t, \n, \v, \f, \r).
+struct TextCounts {
+  size_t lines{};
+  size_t words{};
+  size_t bytes{};
+  size_t chars{};            // only filled by countUtf8Text
+  size_t max_line_length{};  // only filled by countUtf8Text
+
+  TextCounts& operator+=(const TextCounts& other) {
+    lines += other.lines;
+    words += other.words;
+    bytes += other.bytes;
+    chars += other.chars;
+    max_line_length = std::max(max_line_length, other.max_line_length);
+    return *this;
+  }
+};
+
+// True for the bytes that separate words.
+[[nodiscard]] bool isWordSeparator(char ch);
+
+// Counts newlines, word starts and bytes of one buffer. `in_word` carries
+// whether the previous buffer ended inside a word and is updated on return,
+// so a stream can be fed in arbitrary pieces.
+[[nodiscard]] TextCounts countText(const char* data, size_t size,
+                                   bool& in_word);
+[[nodiscard]] TextCounts countText(SimdLevel level, const char* data,
+                                   size_t size, bool& in_word);
+
+// State carried between buffers by countUtf8Text.
+struct Utf8TextState {
+  bool in_word{false};
+  size_t line_length{0};  // columns of the current, unfinished line
+};
+
+// Like countText, and additionally counts UTF-8 characters and the length
+// of the longest line. A character is any byte that is not a continuation
+// byte (10xxxxxx), so a stray continuation byte is never counted and every
+// other invalid byte counts as one character. Line length is measured in
+// characters, excluding the newline, with tabs advancing to the next
+// multiple of 8. The longest line is only known once the input ends: call
+// finishUtf8Text to account for a final line without a newline.
+[[nodiscard]] TextCounts countUtf8Text(const char* data, size_t size,
+                                       Utf8TextState& state);
+[[nodiscard]] TextCounts countUtf8Text(SimdLevel level, const char* data,
+                                       size_t size, Utf8TextState& state);
+void finishUtf8Text(TextCounts& counts, const Utf8TextState& state);
+
+// Bitmasks over one 64-byte block of a command line; bit i describes byte i
+// of the block. `space` marks C-locale whitespace, `breaks` marks every
+// byte that ends a plain shell word (whitespace, quotes, backquote, '$',
+// '|' and '&'), `equals` marks '=' and `wildcards` marks the glob
+// characters '*', '?' and '['.
+struct ShellCharMasks {
+  uint64_t space{};
+  uint64_t breaks{};
+  uint64_t equals{};
+  uint64_t wildcards{};
+};
+
+// Classifies [data, data + size) into one ShellCharMasks per 64 bytes,
+// written to `out`, which must hold (size + 63) / 64 entries. Bits past
+// the end of the input are clear.
+void classifyShellChars(const char* data, size_t size, ShellCharMasks* out);
+void classifyShellChars(SimdLevel level, const char* data, size_t size,
+                        ShellCharMasks* out);
+
+// Marks the bytes equal to `first` or `second` in [data, data + size), one
+// uint64_t per 64 bytes written to `out`, which must hold (size + 63) / 64
+// entries. Bits past the end of the input are clear.
+void maskBytePair(const char* data, size_t size, char first, char second,
+                  uint64_t* out);
+void maskBytePair(SimdLevel level, const char* data, size_t size, char first,
+                  char second, uint64_t* out);
+
+// Consecutive byte values [first, last]. translateBytes adds `delta` to
+// them (modulo 256); in a ByteSet it is zero.
+struct ByteRun {
+  uint8_t first{};
+  uint8_t last{};
+  uint8_t delta{};
+};
+
+// The vector kernels test each byte against every run with one range
+// compare; tables and sets made of more runs take the scalar path.
+constexpr size_t kMaxVectorRuns = 8;
+
+// A byte-to-byte translation. `runs` lists the bytes the table changes,
+// grouped into runs shifted by the same amount, so that `a-z` to `A-Z`
+// is a single run.
+struct ByteMap {
+  std::array<uint8_t, 256> table{};
+  std::vector<ByteRun> runs;
+};
+
+[[nodiscard]] ByteMap makeByteMap(const std::array<uint8_t, 256>& table);
+
+// A set of byte values, with its members also grouped into runs.
+struct ByteSet {
+  std::bitset<256> members;
+  std::vector<ByteRun> runs;
+};
+
+[[nodiscard]] ByteSet makeByteSet(const std::bitset<256>& members);
+
+// Replaces every byte of [data, data + size) by its entry in the map.
+void translateBytes(const ByteMap& map, char* data, size_t size);
+void translateBytes(SimdLevel level, const ByteMap& map, char* data,
+                    size_t size);
+
+// Position of the first byte of [data, data + size) in the set, or `size`
+// when there is none.
+[[nodiscard]] size_t findByteInSet(const ByteSet& set, const char* data,
+                                   size_t size);
+[[nodiscard]] size_t findByteInSet(SimdLevel level, const ByteSet& set,
+                                   const char* data, size_t size);
+
+[[nodiscard]] inline size_t countNewlines(std::string_view text) {
+  return countByte(text.data(), text.size(), '\n');
+}
+
+}  // namespace coreutils
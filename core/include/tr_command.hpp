@@ -0,0 +1,40 @@
+#pragma once
+
+#include <command.hpp>
+#include <text_kernels.hpp>
+
+#include <string>
+#include <vector>
+
+namespace coreutils {
+
+// tr [-c] [-d] [-s] set1 [set2]
+//
+// Translates the bytes of set1 in the standard input to those of set2,
+// deletes them with -d, and with -s squeezes runs of a repeated byte of
+// the last set given into one. -c takes the complement of set1. Sets are
+// made of bytes, escapes (\n, \\, \NNN), ranges (a-z) and classes
+// ([:upper:]); a shorter set2 is padded with its last byte.
+//
+// Each block is rewritten in place: translation runs a vector kernel over
+// the whole block, deletion and squeezing jump between the bytes the set
+// kernel finds and move the spans in between.
+class TrCommand final : public Command {
+ public:
+  explicit TrCommand(std::vector<std::string> args);
+
+  int run(Input& in, Output& out) override;
+
+ private:
+  [[nodiscard]] size_t deleteBytes(char* data, size_t size) const;
+  [[nodiscard]] size_t squeezeBytes(char* data, size_t size,
+                                    int& previous) const;
+
+  ByteMap map_;          // set1 to set2; identity unless translating
+  ByteSet delete_set_;   // -d flag
+  ByteSet squeeze_set_;  // -s flag
+  bool delete_{false};   // -d flag
+  bool squeeze_{false};  // -s flag
+};
+
+}  // namespace coreutils
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <command.hpp>
+#include <variable_store.hpp>
+
+#include <string>
+#include <vector>
+
+namespace coreutils {
+
+// type NAME...: tells how each name would be run, as a builtin or as the
+// program found in PATH.
+class TypeCommand final : public Command {
+ public:
+  TypeCommand(std::vector<std::string> args, const VariableStore& variables)
+      : args_(std::move(args)), variables_(variables) {}
+
+  int run(Input& in, Output& out) override;
+
+ private:
+  std::vector<std::string> args_;
+  const VariableStore& variables_;
+};
+
+}  // namespace coreutils
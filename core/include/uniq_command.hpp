@@ -0,0 +1,43 @@
+#pragma once
+
+#include <command.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+class BufferedWriter;
+
+// uniq [-c] [-d] [-u] [--unsorted] [INPUT [OUTPUT]]
+//
+// Collapses each run of adjacent equal lines into one, streaming the input
+// with only the previous line kept. INPUT defaults to stdin and OUTPUT,
+// created or truncated, to stdout; "-" names either. -c prefixes lines
+// with their counts, -d prints only repeated lines and -u only unrepeated
+// ones. --unsorted treats equal lines as repeats wherever they occur,
+// counting them in a hash table, and prints them in order of first
+// occurrence.
+class UniqCommand final : public Command {
+ public:
+  explicit UniqCommand(std::vector<std::string> args);
+
+  int run(Input& in, Output& out) override;
+
+ private:
+  void writeGroup(BufferedWriter& writer, std::string_view line,
+                  uint64_t count) const;
+  int runStreaming(Input& in, Output& out) const;
+  int runUnsorted(Input& in, Output& out) const;
+
+  std::vector<std::string> files_;  // INPUT operand, if any
+  std::string output_;              // OUTPUT operand
+  bool show_counts_{false};     // -c flag
+  bool repeated_only_{false};   // -d flag
+  bool unique_only_{false};     // -u flag
+  bool unsorted_{false};        // --unsorted flag
+};
+
+}  // namespace coreutils
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+// Shell variables in a flat open-addressing table. Lookups take a
+// string_view and never build a key string. Variables marked for export
+// are passed to child processes through envp(), a snapshot that is only
+// re-serialized after the exported set or one of its values changes.
+class VariableStore final {
+ public:
+  VariableStore() = default;
+  // A copy builds its own envp() snapshot on first use; moves keep the
+  // strings, and with them the snapshot, where they are.
+  VariableStore(const VariableStore& other);
+  VariableStore& operator=(const VariableStore& other);
+  VariableStore(VariableStore&&) noexcept = default;
+  VariableStore& operator=(VariableStore&&) noexcept = default;
+  ~VariableStore() = default;
+
+  // Adds every NAME=value entry of a NULL-terminated environment block as
+  // an exported variable.
+  void importEnvironment(char* const* env);
+
+  // Value of `name`, or nullptr when it has not been assigned.
+  [[nodiscard]] const std::string* find(std::string_view name) const;
+
+  void set(std::string_view name, std::string_view value);
+
+  // Marks `name` for export. A variable that has not been assigned yet
+  // only reaches the environment of children once it is.
+  void exportVariable(std::string_view name);
+
+  [[nodiscard]] bool isExported(std::string_view name) const;
+
+  // NULL-terminated NAME=value array of the exported variables, valid
+  // until the next change to an exported variable.
+  [[nodiscard]] char* const* envp() const;
+
+ private:
+  struct Variable {
+    std::string name;
+    std::string value;
+    size_t hash;
+    bool assigned{false};
+    bool exported{false};
+  };
+
+  static constexpr uint32_t kEmptySlot = UINT32_MAX;
+  static constexpr size_t kInitialSlots = 64;
+
+  // Index of the variable called `name`, or kEmptySlot.
+  [[nodiscard]] uint32_t indexOf(std::string_view name, size_t hash) const;
+  [[nodiscard]] const Variable* lookup(std::string_view name) const;
+  Variable& findOrInsert(std::string_view name);
+  void rehash(size_t slot_count);
+
+  std::vector<Variable> variables_;
+  // Indices into variables_, probed linearly; the size is a power of two
+  // and kept at least twice the number of variables.
+  std::vector<uint32_t> slots_;
+
+  mutable std::vector<std::string> env_strings_;
+  mutable std::vector<char*> envp_;
+  mutable bool envp_stale_{true};
+};
+
+}  // namespace coreutils
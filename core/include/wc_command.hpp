@@ -1,6 +1,7 @@
 #pragma once
 
 #include <command.hpp>
+#include <text_kernels.hpp>
 
 #include <string>
 #include <vector>
@@ -9,15 +10,28 @@ namespace coreutils {
 
 class WcCommand final : public Command {
  public:
+  // Cheapest pass that still yields every requested counter.
+  enum class Kernel {
+    kBytes,  // -c alone: st_size for regular files, plain reads otherwise
+    kLines,  // no -w: newline counting only
+    kFull,   // word splitting
+    kUtf8,   // -m or -L: words plus UTF-8 characters and line lengths
+  };
+
   explicit WcCommand(std::vector<std::string> args);
 
   int run(Input& in, Output& out) override;
 
  private:
+  [[nodiscard]] std::string toString(const TextCounts& stats) const;
+
   std::vector<std::string> files_;
   bool count_lines_{false};
   bool count_words_{false};
   bool count_bytes_{false};
+  bool count_chars_{false};      // -m flag
+  bool max_line_length_{false};  // -L flag
+  Kernel kernel_{Kernel::kFull};
 };
 
 }  // namespace coreutils
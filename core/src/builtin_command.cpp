@@ -0,0 +1,37 @@
+#include <builtin_command.hpp>
+
+#include <stdexcept>
+
+namespace coreutils {
+
+BuiltinCommand::BuiltinCommand(std::vector<std::string> args,
+                               const BuiltinContext& context) {
+  if (args.empty()) {
+    return;
+  }
+
+  const Builtin* builtin = BuiltinRegistry::instance().find(args.front());
+  if (builtin == nullptr) {
+    throw std::invalid_argument("builtin: " + args.front() +
+                                ": not a shell builtin");
+  }
+  args.erase(args.begin());
+  command_ = builtin->factory(std::move(args), context);
+}
+
+int BuiltinCommand::run(Input& in, Output& out) {
+  return command_ ? command_->run(in, out) : 0;
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{
+    "builtin",
+    [](std::vector<std::string> args,
+       const BuiltinContext& context) -> std::unique_ptr<Command> {
+      return std::make_unique<BuiltinCommand>(std::move(args), context);
+    }};
+
+}  // namespace
+
+}  // namespace coreutils
@@ -0,0 +1,28 @@
+#include <builtin_registry.hpp>
+
+#include <algorithm>
+
+namespace coreutils {
+
+BuiltinRegistry& BuiltinRegistry::instance() {
+  // Function-local, so it exists before the first registrar runs whatever
+  // the initialization order of the translation units.
+  static BuiltinRegistry registry;
+  return registry;
+}
+
+bool BuiltinRegistry::add(std::string_view name, BuiltinFactory factory) {
+  auto it = std::ranges::lower_bound(table_, name, {}, &Builtin::name);
+  if (it != table_.end() && it->name == name) {
+    return false;
+  }
+  table_.insert(it, Builtin{name, factory});
+  return true;
+}
+
+const Builtin* BuiltinRegistry::find(std::string_view name) const {
+  auto it = std::ranges::lower_bound(table_, name, {}, &Builtin::name);
+  return it != table_.end() && it->name == name ? &*it : nullptr;
+}
+
+}  // namespace coreutils
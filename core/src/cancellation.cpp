@@ -0,0 +1,59 @@
+#include <cancellation.hpp>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+
+namespace coreutils {
+
+namespace {
+
+thread_local const Cancellation* current = nullptr;
+
+}  // namespace
+
+Cancellation::Cancellation()
+    : event_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) {
+  if (!event_) {
+    throw std::system_error(errno, std::generic_category(), "eventfd");
+  }
+}
+
+void Cancellation::cancel() {
+  if (!cancelled_.exchange(true, std::memory_order_relaxed)) {
+    const uint64_t one = 1;
+    [[maybe_unused]] auto res = ::write(event_.get(), &one, sizeof(one));
+  }
+}
+
+CancellationScope::CancellationScope(const Cancellation& cancellation)
+    : CancellationScope(&cancellation) {}
+
+CancellationScope::CancellationScope(const Cancellation* cancellation)
+    : previous_(current) {
+  current = cancellation;
+}
+
+CancellationScope::~CancellationScope() { current = previous_; }
+
+const Cancellation* currentCancellation() { return current; }
+
+void throwIfCancelled() {
+  if (current != nullptr && current->cancelled()) {
+    throw PipelineCancelled{};
+  }
+}
+
+void throwBrokenPipe(const char* what) {
+  if (current != nullptr) {
+    throw PipelineCancelled{};
+  }
+  throw std::system_error(EPIPE, std::generic_category(), what);
+}
+
+int cancellationFd() { return current != nullptr ? current->fd() : -1; }
+
+}  // namespace coreutils
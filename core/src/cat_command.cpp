@@ -1,48 +1,318 @@
 #include <cat_command.hpp>
 
-#include <fstream>
+#include <builtin_registry.hpp>
+#include <fd_io.hpp>
+#include <unique_fd.hpp>
+
+#include <fcntl.h>
+
+#include <array>
+#include <charconv>
+#include <cstring>
 #include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
 #include <vector>
 
 namespace coreutils {
 
 namespace {
 
-constexpr size_t kBufferSize = 4096;
+constexpr size_t kBlockSize = 128 * 1024;
+// Formatted output is staged in a buffer of this size and flushed whenever
+// the next piece might not fit, so no allocation happens per line.
+constexpr size_t kOutputCapacity = 4 * kBlockSize;
+// Longest decoration put around a line: the number field with its tab, or
+// "$\n" at the end.
+constexpr size_t kMaxDecoration = 32;
+// Line numbers are right-aligned in a field of this width, as in GNU cat.
+constexpr size_t kNumberWidth = 6;
 
+// Copies `from` into `out` in kernel space when `out` is a descriptor, and
+// through a buffer when it collects in memory.
+void copyTo(int from, const Output& out) {
+  if (out.fd() >= 0) {
+    copyFd(from, out.fd());
+    return;
+  }
+  std::vector<char> block(kBlockSize);
+  for (size_t size = readFd(from, block.data(), block.size()); size != 0;
+       size = readFd(from, block.data(), block.size())) {
+    out.write(block.data(), size);
+  }
 }
 
-int CatCommand::run(Input& in, Output& out) {
+// Applies -n, -b, -s, -E, -T and -v to a byte stream fed in arbitrary
+// blocks. Line state carries over between blocks and between files, so
+// numbering continues across all operands like GNU cat does.
+class CatFormatter final {
+ public:
+  CatFormatter(const CatCommand::Options& options, const Output& out)
+      : options_(options), out_(out), buffer_(kOutputCapacity) {
+    for (size_t byte = 0; byte < escaped_.size(); ++byte) {
+      if (byte == '\t') {
+        escaped_[byte] = options.show_tabs;
+      } else if (byte != '\n') {
+        escaped_[byte] =
+            options.show_nonprinting && (byte < ' ' || byte >= 0x7F);
+      }
+    }
+  }
+
+  void feed(const char* data, size_t size) {
+    const char* end = data + size;
+    while (data != end) {
+      if (line_start_) {
+        const bool blank = *data == '\n';
+        if (blank && previous_blank_ && options_.squeeze_blank) {
+          ++data;
+          continue;
+        }
+        previous_blank_ = blank;
+        if (options_.number_nonblank ? !blank : options_.number) {
+          appendNumber();
+        }
+        line_start_ = false;
+      }
+
+      const auto* newline = static_cast<const char*>(
+          std::memchr(data, '\n', static_cast<size_t>(end - data)));
+      const char* line_end = newline == nullptr ? end : newline;
+      appendBody(data, static_cast<size_t>(line_end - data));
+      if (newline == nullptr) {
+        break;
+      }
+
+      reserve(kMaxDecoration);
+      if (options_.show_ends) {
+        put('$');
+      }
+      put('\n');
+      line_start_ = true;
+      data = newline + 1;
+    }
+  }
+
+  void flush() {
+    out_.write(buffer_.data(), used_);
+    used_ = 0;
+  }
+
+ private:
+  void reserve(size_t size) {
+    if (used_ + size > buffer_.size()) {
+      flush();
+    }
+  }
+
+  void put(char ch) { buffer_[used_++] = ch; }
+
+  void append(const char* data, size_t size) {
+    reserve(size);
+    if (size > buffer_.size()) {
+      out_.write(data, size);
+      return;
+    }
+    std::memcpy(buffer_.data() + used_, data, size);
+    used_ += size;
+  }
+
+  void appendNumber() {
+    reserve(kMaxDecoration);
+    std::array<char, 24> digits{};
+    auto [end, ec] =
+        std::to_chars(digits.data(), digits.data() + digits.size(),
+                      ++line_number_);
+    const auto length = static_cast<size_t>(end - digits.data());
+    for (size_t i = length; i < kNumberWidth; ++i) {
+      put(' ');
+    }
+    std::memcpy(buffer_.data() + used_, digits.data(), length);
+    used_ += length;
+    put('\t');
+  }
+
+  void appendBody(const char* data, size_t size) {
+    if (!options_.show_tabs && !options_.show_nonprinting) {
+      append(data, size);
+      return;
+    }
+
+    // Copy runs of bytes that print as-is in one piece; escape the rest.
+    const char* end = data + size;
+    while (data != end) {
+      const char* run = data;
+      while (run != end && !escaped_[static_cast<unsigned char>(*run)]) {
+        ++run;
+      }
+      append(data, static_cast<size_t>(run - data));
+      if (run == end) {
+        break;
+      }
+      appendEscaped(static_cast<unsigned char>(*run));
+      data = run + 1;
+    }
+  }
+
+  // ^X for control characters, ^? for DEL and an M- prefix for bytes with
+  // the high bit set.
+  void appendEscaped(unsigned char byte) {
+    reserve(4);
+    if (byte == '\t') {
+      put('^');
+      put('I');
+      return;
+    }
+    if (byte >= 0x80) {
+      put('M');
+      put('-');
+      byte -= 0x80;
+    }
+    if (byte < ' ') {
+      put('^');
+      put(static_cast<char>(byte + '@'));
+    } else if (byte == 0x7F) {
+      put('^');
+      put('?');
+    } else {
+      put(static_cast<char>(byte));
+    }
+  }
+
+  const CatCommand::Options& options_;
+  const Output& out_;
+  std::vector<char> buffer_;
+  size_t used_{0};
+  std::array<bool, 256> escaped_{};
+  size_t line_number_{0};
+  bool line_start_{true};
+  bool previous_blank_{false};
+};
+
+UniqueFd openFile(const std::string& file) {
+  UniqueFd fd(open(file.c_str(), O_RDONLY | O_CLOEXEC));
+  if (!fd) {
+    std::cerr << "Unable to open file: " << file << '\n';
+  }
+  return fd;
+}
+
+}  // namespace
+
+CatCommand::CatCommand(std::vector<std::string> args) {
+  for (auto& arg : args) {
+    if (arg.size() < 2 || arg[0] != '-') {
+      files_.push_back(std::move(arg));
+      continue;
+    }
+    for (char flag : std::string_view(arg).substr(1)) {
+      switch (flag) {
+        case 'n':
+          options_.number = true;
+          break;
+        case 'b':
+          options_.number_nonblank = true;
+          break;
+        case 's':
+          options_.squeeze_blank = true;
+          break;
+        case 'E':
+          options_.show_ends = true;
+          break;
+        case 'T':
+          options_.show_tabs = true;
+          break;
+        case 'v':
+          options_.show_nonprinting = true;
+          break;
+        case 'A':
+          options_.show_nonprinting = true;
+          options_.show_ends = true;
+          options_.show_tabs = true;
+          break;
+        default:
+          throw std::invalid_argument("cat: invalid option -- '" +
+                                      std::string(1, flag) + "'");
+      }
+    }
+  }
+}
+
+int CatCommand::copyUnchanged(Input& in, Output& out) const {
   if (files_.empty()) {
-    auto buf = in.readVector(kBufferSize);
-    while (!buf.empty()) {
-      out.write(buf);
-      buf = in.readVector(kBufferSize);
+    try {
+      copyTo(in.fd(), out);
+    } catch (const std::system_error& e) {
+      std::cerr << "cat: " << e.code().message() << '\n';
+      return 1;
     }
     return 0;
   }
 
   int exit_code = 0;
   for (const auto& file : files_) {
-    std::ifstream stream(file, std::ios::binary);
-    if (!stream.is_open()) {
-      std::cerr << "Unable to open file: " << file << '\n';
+    auto fd = openFile(file);
+    if (!fd) {
       exit_code = 1;
       continue;
     }
-
-    std::vector<char> buffer(kBufferSize);
-    while (stream) {
-      stream.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
-      const auto read_count = stream.gcount();
-      if (read_count <= 0) {
-        break;
-      }
-      out.write(buffer.data(), read_count);
+    try {
+      copyTo(fd.get(), out);
+    } catch (const std::system_error& e) {
+      std::cerr << "cat: " << file << ": " << e.code().message() << '\n';
+      exit_code = 1;
     }
   }
+  return exit_code;
+}
 
+int CatCommand::copyFormatted(Input& in, Output& out) const {
+  CatFormatter formatter(options_, out);
+  std::vector<char> block(kBlockSize);
+  auto feed_from = [&](int fd) {
+    for (size_t size = readFd(fd, block.data(), block.size()); size != 0;
+         size = readFd(fd, block.data(), block.size())) {
+      formatter.feed(block.data(), size);
+    }
+  };
+
+  int exit_code = 0;
+  if (files_.empty()) {
+    try {
+      feed_from(in.fd());
+    } catch (const std::system_error& e) {
+      std::cerr << "cat: " << e.code().message() << '\n';
+      exit_code = 1;
+    }
+  }
+  for (const auto& file : files_) {
+    auto fd = openFile(file);
+    if (!fd) {
+      exit_code = 1;
+      continue;
+    }
+    try {
+      feed_from(fd.get());
+    } catch (const std::system_error& e) {
+      std::cerr << "cat: " << file << ": " << e.code().message() << '\n';
+      exit_code = 1;
+    }
+  }
+  formatter.flush();
   return exit_code;
 }
 
+int CatCommand::run(Input& in, Output& out) {
+  // Without formatting flags the bytes never need to reach user space.
+  return options_.transforms() ? copyFormatted(in, out)
+                               : copyUnchanged(in, out);
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{"cat", makeBuiltin<CatCommand>};
+
+}  // namespace
+
 }  // namespace coreutils
@@ -1,5 +1,7 @@
 #include <cd_command.hpp>
 
+#include <builtin_registry.hpp>
+
 #include <cstdlib>
 #include <filesystem>
 #include <iostream>
@@ -79,4 +81,10 @@ int CdCommand::run(Input&, Output&) {
   return 1;
 }
 
+namespace {
+
+const BuiltinRegistrar kRegistrar{"cd", makeBuiltin<CdCommand>};
+
+}  // namespace
+
 }  // namespace coreutils
@@ -2,60 +2,166 @@
 
 #include <unistd.h>
 #include <algorithm>
+#include <cstring>
+#include <csignal>
+#include <filesystem>
 #include <iostream>
-#include <sstream>
 #include <stdexcept>
+#include <system_error>
 
-#include <cat_command.hpp>
-#include <cd_command.hpp>
+#include <builtin_registry.hpp>
 #include <command.hpp>
-#include <echo_command.hpp>
-#include <exit_command.hpp>
 #include <external_command.hpp>
 #include <global_state.hpp>
-#include <ls_command.hpp>
-#include <grep_command.hpp>
-#include <pwd_command.hpp>
-#include <wc_command.hpp>
+#include <string_output.hpp>
+#include <text_output.hpp>
 
 namespace coreutils {
 
-CLI::CLI(Parser& parser) : parser_(parser) {}
+namespace {
+
+// Makes a command substitution behave like a subshell: the working
+// directory, the variables and the exit flag its builtins change are
+// restored once it is done.
+class SubshellState final {
+ public:
+  explicit SubshellState(VariableStore& variables)
+      : variables_(variables), saved_variables_(variables), exit_(IsExit) {
+    std::error_code ec;
+    cwd_ = std::filesystem::current_path(ec);
+  }
+  SubshellState(const SubshellState&) = delete;
+  SubshellState& operator=(const SubshellState&) = delete;
+  SubshellState(SubshellState&&) = delete;
+  SubshellState& operator=(SubshellState&&) = delete;
+
+  ~SubshellState() {
+    variables_ = std::move(saved_variables_);
+    IsExit = exit_;
+    if (!cwd_.empty()) {
+      std::error_code ec;
+      std::filesystem::current_path(cwd_, ec);
+    }
+  }
+
+ private:
+  VariableStore& variables_;
+  VariableStore saved_variables_;
+  bool exit_;
+  std::filesystem::path cwd_;
+};
+
+}  // namespace
+
+CLI::CLI(Parser& parser) : parser_(parser) {
+  // A write to a pipe or terminal that nobody reads any more fails with
+  // EPIPE instead of killing the shell. Child processes put SIGPIPE back to
+  // its default before exec.
+  std::signal(SIGPIPE, SIG_IGN);
+  parser_.setSubstitutionRunner(
+      [this](std::string_view command) { return substitute(command); });
+}
+
+int CLI::runCli(Input& in, Output& out) {
+  // Pipes and redirected files are drained in large blocks. A terminal
+  // returns one line per read anyway, and only it is shown a prompt.
+  constexpr size_t kReadSize = 64 * 1024;
+  const bool interactive = isatty(in.fd()) != 0;
+  if (interactive && !history_.isOpen()) {
+    openHistory();
+  }
+  record_history_ = interactive;
 
-void CLI::runCli(Input& in, Output& out) {
-  constexpr size_t kBatchSize = 1024;
+  std::string pending;
+  std::vector<char> block(kReadSize);
+  int status = 0;
 
   while (!IsExit) {
-    std::cout << "-> ";
-    std::cout.flush();
+    if (interactive && pending.empty()) {
+      std::cout << "-> ";
+      std::cout.flush();
+    }
 
-    auto data = in.readVector(kBatchSize);
-    if (data.empty()) {
+    const size_t size = in.read(block.data(), block.size());
+    if (size == 0) {
       break;
     }
-    std::string str_data{data.begin(), data.end()};
-    std::istringstream input_steam{std::move(str_data)};
+    pending.append(block.data(), size);
+
+    // Only complete lines are run; the tail of the block is carried over
+    // until the rest of its line arrives. The carried-over tail holds no
+    // newline, so only the block just read is searched.
+    const void* newline = memrchr(block.data(), '\n', size);
+    if (newline == nullptr) {
+      continue;
+    }
+    const size_t tail =
+        block.data() + size - static_cast<const char*>(newline) - 1;
+    const size_t complete = pending.size() - tail;
+    status = runScript(std::string_view(pending).substr(0, complete), in, out);
+    pending.erase(0, complete);
+  }
 
-    std::string line;
-    while (std::getline(input_steam, line)) {
-      auto res = process(std::move(line), out, in);
+  if (!IsExit && !pending.empty()) {
+    status = runScript(pending, in, out);
+  }
+  record_history_ = false;
+  return status;
+}
 
-      if (res < 0) {
-        throw std::runtime_error{
-            "Error has occured during the last process call"};
-      }
+int CLI::runScript(std::string_view script, Input& in, Output& out) {
+  int status = 0;
+  size_t pos = 0;
+  while (pos < script.size() && !IsExit) {
+    size_t end = script.find('\n', pos);
+    if (end == std::string_view::npos) {
+      end = script.size();
     }
+
+    const std::string_view line = script.substr(pos, end - pos);
+    if (record_history_) {
+      history_.add(line);
+    }
+    status = process(line, out, in);
+    if (status < 0) {
+      throw std::runtime_error{
+          "Error has occured during the last process call"};
+    }
+    pos = end + 1;
   }
+  return status;
 }
 
-int CLI::process(std::string&& line, Output& out, Input& in) {
-  auto tokens = parser_.parseToTokens(std::move(line));
+void CLI::openHistory() {
+  std::string path;
+  if (const std::string* file = parser_.variables().find("HISTFILE")) {
+    path = *file;
+  } else if (const std::string* home = parser_.variables().find("HOME")) {
+    path = *home + "/.cli_history";
+  }
+  if (path.empty()) {
+    return;
+  }
 
-  if (tokens.empty()) return 0;
+  try {
+    history_.open(path);
+  } catch (const std::system_error& ex) {
+    std::cerr << "CLI: history: " << ex.what() << '\n';
+  }
+}
+
+int CLI::process(std::string_view line, Output& out, Input& in) {
+  // Tokens only have to outlive command construction, which copies them
+  // into each command's arguments, so the arena is recycled per line.
+  arena_.reset();
+  input_ = &in;
+  const auto tokens = parser_.tokenize(line, arena_);
 
-  auto commands = splitIntoCommands(std::move(tokens));
+  if (tokens.empty()) return 0;
 
   try {
+    // Builtins reject bad arguments while being constructed.
+    auto commands = splitIntoCommands(tokens);
     return executor_.runCommands(std::move(commands), in, out);
   } catch (const std::exception& ex) {
     std::cerr << ex.what() << '\n';
@@ -63,17 +169,52 @@ int CLI::process(std::string&& line, Output& out, Input& in) {
   }
 }
 
+std::string CLI::substitute(std::string_view command) {
+  // Assignments take effect while tokenizing, so the subshell starts here.
+  SubshellState subshell(parser_.variables());
+
+  // Called while the enclosing line is being tokenized, so its tokens stay
+  // in arena_ and this command line gets an arena of its own.
+  Arena arena;
+  const auto tokens = parser_.tokenize(command, arena);
+  if (tokens.empty()) {
+    return {};
+  }
+
+  try {
+    auto commands = splitIntoCommands(tokens);
+
+    // Builtins write straight into memory. Only a pipeline with an external
+    // command needs a descriptor for the child's stdout, drained by the
+    // reader thread of TextOutput.
+    const bool needs_child =
+        std::ranges::any_of(commands, [](const CommandPtr& cmd) {
+          return dynamic_cast<const ExternalCommand*>(cmd.get()) != nullptr;
+        });
+    if (!needs_child) {
+      StringOutput output;
+      executor_.runCommands(std::move(commands), *input_, output);
+      return std::move(output).str();
+    }
+
+    TextOutput output;
+    executor_.runCommands(std::move(commands), *input_, output);
+    return std::move(output).read();
+  } catch (const std::exception& ex) {
+    std::cerr << ex.what() << '\n';
+    return {};
+  }
+}
+
 std::vector<CLI::CommandPtr> CLI::splitIntoCommands(
-    std::vector<std::string>&& tokens) {
+    std::span<const std::string_view> tokens) {
   std::vector<CLI::CommandPtr> result;
 
   auto it = tokens.begin();
   while (it != tokens.end()) {
     auto sep = std::find(it, tokens.end(), "|");
-    std::vector<std::string> part;
-    std::move(it, sep, std::back_inserter(part));
 
-    if (!part.empty()) result.push_back(createCommand(std::move(part)));
+    if (sep != it) result.push_back(createCommand({it, sep}));
 
     it = (sep == tokens.end()) ? sep : std::next(sep);
   }
@@ -81,52 +222,18 @@ std::vector<CLI::CommandPtr> CLI::splitIntoCommands(
   return result;
 }
 
-CLI::CommandPtr CLI::createCommand(std::vector<std::string>&& tokens) {
-  std::string cmd_name = std::move(tokens[0]);
-
-  std::vector<std::string> rest(std::make_move_iterator(tokens.begin() + 1),
-                                std::make_move_iterator(tokens.end()));
-
-  if (cmd_name == "echo") {
-    return std::make_unique<EchoCommand>(std::move(rest));
-  }
-
-  if (cmd_name == "cat") {
-    // Cat reads from stdin
-    return std::make_unique<CatCommand>(std::move(rest));
-  }
-
-  if (cmd_name == "wc") {
-    // Wc reads from stdin
-    return std::make_unique<WcCommand>(std::move(rest));
-  }
-
-  if (cmd_name == "ls") {
-    return std::make_unique<LsCommand>(std::move(rest));
-  }
-
-  if (cmd_name == "cd") {
-    return std::make_unique<CdCommand>(std::move(rest));
-  }
-
-  if (cmd_name == "pwd") {
-    if (!rest.empty()) {
-      throw std::invalid_argument("pwd does not accept arguments");
-    }
-    return std::make_unique<PwdCommand>();
-  }
+CLI::CommandPtr CLI::createCommand(std::span<const std::string_view> tokens) {
+  const std::string_view cmd_name = tokens.front();
 
-  if (cmd_name == "exit") {
-    // Exit command ignores arguments
-    return std::make_unique<ExitCommand>();
-  }
+  std::vector<std::string> rest(tokens.begin() + 1, tokens.end());
 
-  if (cmd_name == "grep") {
-    return std::make_unique<GrepCommand>(std::move(rest));
+  if (const Builtin* builtin = BuiltinRegistry::instance().find(cmd_name)) {
+    return builtin->factory(std::move(rest),
+                            BuiltinContext{parser_.variables(), history_});
   }
 
-  return std::make_unique<ExternalCommand>(std::move(cmd_name),
-                                           std::move(rest));
+  return std::make_unique<ExternalCommand>(
+      std::string(cmd_name), std::move(rest), &parser_.variables());
 }
 
 }  // namespace coreutils
@@ -0,0 +1,91 @@
+#include <count_command.hpp>
+
+#include <buffered_writer.hpp>
+#include <builtin_registry.hpp>
+#include <line_counter.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <stdexcept>
+#include <string_view>
+
+namespace coreutils {
+
+CountCommand::CountCommand(std::vector<std::string> args) {
+  for (size_t i = 0; i < args.size(); ++i) {
+    const std::string& arg = args[i];
+    if (arg.size() < 2 || arg[0] != '-') {
+      files_.push_back(arg);
+      continue;
+    }
+    if (arg[1] != 'n') {
+      throw std::invalid_argument("count: invalid option -- '" +
+                                  arg.substr(1, 1) + "'");
+    }
+    // The value is the rest of the argument or the next argument.
+    std::string_view value = std::string_view(arg).substr(2);
+    if (value.empty()) {
+      if (i + 1 == args.size()) {
+        throw std::invalid_argument(
+            "count: option requires an argument -- 'n'");
+      }
+      value = args[++i];
+    }
+    auto [end, ec] =
+        std::from_chars(value.data(), value.data() + value.size(), top_);
+    if (value.empty() || ec != std::errc{} ||
+        end != value.data() + value.size()) {
+      throw std::invalid_argument("count: invalid number of lines: '" +
+                                  std::string(value) + "'");
+    }
+  }
+}
+
+int CountCommand::run(Input& in, Output& out) {
+  LineCounter counter;
+  const bool ok = countLines(files_, in, "count", counter);
+
+  // Keeps the `top_` most frequent lines in a heap whose root is the least
+  // of them, so a line only goes in when it beats the root.
+  using Entry = LineCounter::Entry;
+  auto before = [](const Entry* lhs, const Entry* rhs) {
+    return lhs->count != rhs->count ? lhs->count > rhs->count
+                                    : lhs->first < rhs->first;
+  };
+  std::vector<const Entry*> heap;
+  heap.reserve(std::min(top_, counter.entries().size()));
+  for (const Entry& entry : counter.entries()) {
+    if (heap.size() < top_) {
+      heap.push_back(&entry);
+      std::ranges::push_heap(heap, before);
+    } else if (top_ != 0 && before(&entry, heap.front())) {
+      std::ranges::pop_heap(heap, before);
+      heap.back() = &entry;
+      std::ranges::push_heap(heap, before);
+    }
+  }
+  std::ranges::sort_heap(heap, before);
+
+  BufferedWriter writer(out);
+  for (const Entry* entry : heap) {
+    std::array<char, 32> count{};
+    const int size =
+        std::snprintf(count.data(), count.size(), "%7llu ",
+                      static_cast<unsigned long long>(entry->count));
+    writer.write({count.data(), static_cast<size_t>(size)});
+    writer.write(entry->line);
+    writer.put('\n');
+  }
+  writer.flush();
+  return ok ? 0 : 1;
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{"count", makeBuiltin<CountCommand>};
+
+}  // namespace
+
+}  // namespace coreutils
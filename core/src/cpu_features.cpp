@@ -0,0 +1,49 @@
+#include <cpu_features.hpp>
+
+namespace coreutils {
+
+namespace {
+
+SimdLevel detectSimdLevel() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  // The vector kernels count mask bits with POPCNT, which every AVX CPU
+  // has; the rare SSE2-only CPUs without it take the scalar path.
+  if (!__builtin_cpu_supports("popcnt")) {
+    return SimdLevel::kScalar;
+  }
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+    return SimdLevel::kAvx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::kAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return SimdLevel::kSse2;
+  }
+#endif
+  return SimdLevel::kScalar;
+}
+
+}  // namespace
+
+SimdLevel simdLevel() {
+  static const SimdLevel level = detectSimdLevel();
+  return level;
+}
+
+std::string_view toString(SimdLevel level) {
+  switch (level) {
+    case SimdLevel::kScalar:
+      return "scalar";
+    case SimdLevel::kSse2:
+      return "sse2";
+    case SimdLevel::kAvx2:
+      return "avx2";
+    case SimdLevel::kAvx512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+}  // namespace coreutils
@@ -0,0 +1,302 @@
+#include <cut_command.hpp>
+
+#include <buffered_writer.hpp>
+#include <builtin_registry.hpp>
+#include <fd_io.hpp>
+#include <text_kernels.hpp>
+#include <unique_fd.hpp>
+
+#include <fcntl.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+namespace coreutils {
+
+namespace {
+
+constexpr size_t kBlockSize = 128 * 1024;
+constexpr size_t kOpenEnd = std::numeric_limits<size_t>::max();
+
+size_t parsePosition(std::string_view value) {
+  size_t position = 0;
+  auto [end, ec] =
+      std::from_chars(value.data(), value.data() + value.size(), position);
+  if (value.empty() || ec != std::errc{} ||
+      end != value.data() + value.size()) {
+    throw std::invalid_argument(
+        "cut: invalid byte, character or field list");
+  }
+  if (position == 0) {
+    throw std::invalid_argument(
+        "cut: fields and positions are numbered from 1");
+  }
+  return position;
+}
+
+}  // namespace
+
+CutCommand::CutCommand(std::vector<std::string> args) {
+  bool has_list = false;
+  bool has_delimiter = false;
+  for (size_t i = 0; i < args.size(); ++i) {
+    const std::string& arg = args[i];
+    if (arg.size() < 2 || arg[0] != '-') {
+      files_.push_back(arg);
+      continue;
+    }
+    for (size_t j = 1; j < arg.size(); ++j) {
+      const char flag = arg[j];
+      if (flag == 's') {
+        only_delimited_ = true;
+        continue;
+      }
+      if (flag != 'f' && flag != 'd' && flag != 'b' && flag != 'c') {
+        throw std::invalid_argument(std::string("cut: invalid option -- '") +
+                                    flag + "'");
+      }
+      // The value is the rest of the argument or the next argument.
+      std::string_view value = std::string_view(arg).substr(j + 1);
+      if (value.empty()) {
+        if (i + 1 == args.size()) {
+          throw std::invalid_argument(
+              std::string("cut: option requires an argument -- '") + flag +
+              "'");
+        }
+        value = args[++i];
+      }
+      if (flag == 'd') {
+        if (value.size() != 1) {
+          throw std::invalid_argument(
+              "cut: the delimiter must be a single character");
+        }
+        delimiter_ = value[0];
+        has_delimiter = true;
+      } else {
+        if (has_list) {
+          throw std::invalid_argument(
+              "cut: only one type of list may be specified");
+        }
+        has_list = true;
+        fields_ = flag == 'f';
+        parseList(value);
+      }
+      break;
+    }
+  }
+
+  if (!has_list) {
+    throw std::invalid_argument(
+        "cut: you must specify a list of bytes, characters, or fields");
+  }
+  if (has_delimiter && !fields_) {
+    throw std::invalid_argument(
+        "cut: an input delimiter may be specified only when operating on "
+        "fields");
+  }
+  if (only_delimited_ && !fields_) {
+    throw std::invalid_argument(
+        "cut: suppressing non-delimited lines makes sense only when "
+        "operating on fields");
+  }
+}
+
+void CutCommand::parseList(std::string_view list) {
+  while (true) {
+    const size_t comma = list.find(',');
+    const std::string_view item = list.substr(0, comma);
+    const size_t dash = item.find('-');
+    Range range{};
+    if (dash == std::string_view::npos) {
+      range.first = range.last = parsePosition(item);
+    } else {
+      if (item.size() == 1) {
+        throw std::invalid_argument("cut: invalid range with no endpoint: -");
+      }
+      range.first = dash == 0 ? 1 : parsePosition(item.substr(0, dash));
+      range.last = dash + 1 == item.size()
+                       ? kOpenEnd
+                       : parsePosition(item.substr(dash + 1));
+      if (range.last < range.first) {
+        throw std::invalid_argument("cut: invalid decreasing range");
+      }
+    }
+    ranges_.push_back(range);
+    if (comma == std::string_view::npos) {
+      break;
+    }
+    list.remove_prefix(comma + 1);
+  }
+
+  std::ranges::sort(ranges_, {}, &Range::first);
+  std::vector<Range> merged;
+  for (const Range& range : ranges_) {
+    if (!merged.empty() && (merged.back().last == kOpenEnd ||
+                            range.first <= merged.back().last + 1)) {
+      merged.back().last = std::max(merged.back().last, range.last);
+    } else {
+      merged.push_back(range);
+    }
+  }
+  ranges_ = std::move(merged);
+}
+
+// `lines` holds whole lines, each ending with a newline. Every delimiter
+// or newline ends a field; the range cursor only moves forward along a
+// line, since fields come in increasing order.
+void CutCommand::cutFields(std::string_view lines, BufferedWriter& writer) {
+  constexpr size_t kBlock = 64;
+  masks_.resize((lines.size() + kBlock - 1) / kBlock);
+  maskBytePair(lines.data(), lines.size(), delimiter_, '\n', masks_.data());
+
+  size_t line_start = 0;
+  size_t field_start = 0;
+  size_t field = 1;
+  size_t range = 0;
+  bool delimited = false;
+  bool printed = false;
+  for (size_t block = 0; block < masks_.size(); ++block) {
+    for (uint64_t bits = masks_[block]; bits != 0; bits &= bits - 1) {
+      const size_t pos = block * kBlock + std::countr_zero(bits);
+      const bool newline = lines[pos] == '\n';
+      if (newline && !delimited) {
+        if (!only_delimited_) {
+          writer.write(lines.substr(line_start, pos + 1 - line_start));
+        }
+      } else {
+        while (range < ranges_.size() && ranges_[range].last < field) {
+          ++range;
+        }
+        if (range < ranges_.size() && ranges_[range].first <= field) {
+          if (printed) {
+            writer.put(delimiter_);
+          }
+          writer.write(lines.substr(field_start, pos - field_start));
+          printed = true;
+        }
+        if (newline) {
+          writer.put('\n');
+        }
+      }
+
+      field_start = pos + 1;
+      if (newline) {
+        line_start = pos + 1;
+        field = 1;
+        range = 0;
+        delimited = false;
+        printed = false;
+      } else {
+        ++field;
+        delimited = true;
+      }
+    }
+  }
+}
+
+void CutCommand::cutBytes(std::string_view lines,
+                          BufferedWriter& writer) const {
+  size_t line_start = 0;
+  while (line_start < lines.size()) {
+    const size_t length = lines.find('\n', line_start) - line_start;
+    for (const Range& range : ranges_) {
+      if (range.first > length) {
+        break;
+      }
+      const size_t last = std::min(range.last, length);
+      writer.write(
+          lines.substr(line_start + range.first - 1, last - range.first + 1));
+    }
+    writer.put('\n');
+    line_start += length + 1;
+  }
+}
+
+// Cuts the whole lines of each block and carries the partial last line
+// into the next one; the buffer grows only for lines longer than itself.
+void CutCommand::cutFd(int fd, BufferedWriter& writer) {
+  std::vector<char> buffer(kBlockSize);
+  size_t used = 0;
+  auto cut_lines = [&](size_t size) {
+    const std::string_view lines(buffer.data(), size);
+    if (fields_) {
+      cutFields(lines, writer);
+    } else {
+      cutBytes(lines, writer);
+    }
+  };
+
+  while (true) {
+    if (used == buffer.size()) {
+      buffer.resize(buffer.size() * 2);
+    }
+    const size_t size = readFd(fd, buffer.data() + used, buffer.size() - used);
+    if (size == 0) {
+      break;
+    }
+    const void* newline = memrchr(buffer.data() + used, '\n', size);
+    used += size;
+    if (newline == nullptr) {
+      continue;
+    }
+    const size_t complete =
+        static_cast<const char*>(newline) - buffer.data() + 1;
+    cut_lines(complete);
+    std::memmove(buffer.data(), buffer.data() + complete, used - complete);
+    used -= complete;
+  }
+
+  // A last line without a newline is cut as if it had one.
+  if (used != 0) {
+    if (used == buffer.size()) {
+      buffer.push_back('\n');
+    } else {
+      buffer[used] = '\n';
+    }
+    cut_lines(used + 1);
+  }
+}
+
+int CutCommand::run(Input& in, Output& out) {
+  BufferedWriter writer(out);
+  int status = 0;
+  try {
+    if (files_.empty()) {
+      cutFd(in.fd(), writer);
+    }
+    for (const auto& file : files_) {
+      if (file == "-") {
+        cutFd(in.fd(), writer);
+        continue;
+      }
+      UniqueFd fd(open(file.c_str(), O_RDONLY | O_CLOEXEC));
+      if (!fd) {
+        std::cerr << "cut: " << file << ": " << std::strerror(errno) << '\n';
+        status = 1;
+        continue;
+      }
+      cutFd(fd.get(), writer);
+    }
+  } catch (const std::system_error& e) {
+    std::cerr << "cut: " << e.what() << '\n';
+    status = 1;
+  }
+  writer.flush();
+  return status;
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{"cut", makeBuiltin<CutCommand>};
+
+}  // namespace
+
+}  // namespace coreutils
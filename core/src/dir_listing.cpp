@@ -0,0 +1,41 @@
+#include <dir_listing.hpp>
+
+#include <dir_reader.hpp>
+#include <string_sort.hpp>
+
+#include <dirent.h>
+
+#include <numeric>
+#include <span>
+
+namespace coreutils {
+
+DirListing::DirListing(int dirfd, bool include_dots, size_t batch_size) {
+  offsets_.push_back(0);
+  if (include_dots) {
+    add(".", DT_DIR);
+    add("..", DT_DIR);
+  }
+
+  DirReader reader(dirfd, batch_size);
+  DirReader::Entry entry{};
+  while (reader.next(entry)) {
+    add(entry.name, entry.type);
+  }
+}
+
+void DirListing::add(std::string_view name, unsigned char type) {
+  arena_.insert(arena_.end(), name.begin(), name.end());
+  arena_.push_back('\0');
+  offsets_.push_back(arena_.size());
+  types_.push_back(type);
+}
+
+std::vector<size_t> DirListing::sortedByName() const {
+  std::vector<size_t> order(size());
+  std::iota(order.begin(), order.end(), size_t{0});
+  radixSort(std::span(order), [this](size_t index) { return name(index); });
+  return order;
+}
+
+}  // namespace coreutils
@@ -0,0 +1,148 @@
+#include <dir_reader.hpp>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <system_error>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+namespace coreutils {
+
+namespace {
+
+#ifdef __linux__
+// Fixed-size header of the kernel's struct linux_dirent64; the
+// NUL-terminated name follows d_type.
+struct LinuxDirent64 {
+  ino64_t d_ino;
+  off64_t d_off;
+  unsigned short d_reclen;
+  unsigned char d_type;
+};
+
+constexpr size_t kDirentNameOffset = offsetof(LinuxDirent64, d_type) + 1;
+#endif
+
+bool isDotOrDotDot(const char* name) {
+  return name[0] == '.' &&
+         (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'));
+}
+
+}  // namespace
+
+DirReader::DirReader(int dirfd, size_t buffer_size)
+    : fd_(dirfd),
+      capacity_(buffer_size),
+      buffer_(std::make_unique<char[]>(buffer_size)) {}
+
+DirReader::~DirReader() {
+  if (dir_ != nullptr) {
+    closedir(static_cast<DIR*>(dir_));
+  }
+}
+
+bool DirReader::fill() {
+#ifdef __linux__
+  auto res = syscall(SYS_getdents64, fd_, buffer_.get(), capacity_);
+  if (res < 0) {
+    throw std::system_error(errno, std::generic_category(), "getdents64");
+  }
+  pos_ = 0;
+  size_ = static_cast<size_t>(res);
+  return size_ != 0;
+#else
+  if (dir_ == nullptr) {
+    int dup_fd = dup(fd_);
+    if (dup_fd < 0 || (dir_ = fdopendir(dup_fd)) == nullptr) {
+      throw std::system_error(errno, std::generic_category(), "fdopendir");
+    }
+  }
+  return true;
+#endif
+}
+
+bool DirReader::next(Entry& entry) {
+#ifdef __linux__
+  while (true) {
+    if (pos_ >= size_ && !fill()) {
+      return false;
+    }
+    const auto* dirent =
+        reinterpret_cast<const LinuxDirent64*>(buffer_.get() + pos_);
+    const char* name = buffer_.get() + pos_ + kDirentNameOffset;
+    pos_ += dirent->d_reclen;
+    if (isDotOrDotDot(name)) {
+      continue;
+    }
+    entry.name = name;
+    entry.type = dirent->d_type;
+    entry.ino = dirent->d_ino;
+    return true;
+  }
+#else
+  if (dir_ == nullptr) {
+    fill();
+  }
+  while (true) {
+    errno = 0;
+    const dirent* ent = readdir(static_cast<DIR*>(dir_));
+    if (ent == nullptr) {
+      if (errno != 0) {
+        throw std::system_error(errno, std::generic_category(), "readdir");
+      }
+      return false;
+    }
+    if (isDotOrDotDot(ent->d_name)) {
+      continue;
+    }
+    entry.name = ent->d_name;
+    entry.type = ent->d_type;
+    entry.ino = ent->d_ino;
+    return true;
+  }
+#endif
+}
+
+unsigned char resolveDirentType(int dirfd, const char* name,
+                                unsigned char type) {
+  if (type != DT_UNKNOWN) {
+    return type;
+  }
+
+  struct stat st {};
+  if (fstatat(dirfd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+    return DT_UNKNOWN;
+  }
+  return direntTypeFromMode(st.st_mode);
+}
+
+unsigned char direntTypeFromMode(mode_t mode) {
+  switch (mode & S_IFMT) {
+    case S_IFREG:
+      return DT_REG;
+    case S_IFDIR:
+      return DT_DIR;
+    case S_IFLNK:
+      return DT_LNK;
+    case S_IFIFO:
+      return DT_FIFO;
+    case S_IFSOCK:
+      return DT_SOCK;
+    case S_IFCHR:
+      return DT_CHR;
+    case S_IFBLK:
+      return DT_BLK;
+    default:
+      return DT_UNKNOWN;
+  }
+}
+
+}  // namespace coreutils
@@ -0,0 +1,285 @@
+#include <dir_walker.hpp>
+
+#include <cancellation.hpp>
+#include <dir_reader.hpp>
+#include <unique_fd.hpp>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <thread>
+
+namespace coreutils {
+
+namespace {
+
+struct DirTask {
+  // Open parent directory, shared by all of its pending subdirectories so
+  // that they can be opened with openat() instead of a full path lookup.
+  // Null for roots.
+  std::shared_ptr<const UniqueFd> parent;
+  std::string path;
+  size_t name_offset;  // start of the directory's own name in `path`
+  size_t depth;
+  size_t id;
+};
+
+struct WorkerQueue {
+  std::mutex mutex;
+  std::deque<DirTask> tasks;
+};
+
+class WalkState {
+ public:
+  WalkState(size_t threads, size_t max_depth, const DirWalker::Visitor& visit,
+            const DirWalker::ErrorHandler& on_error)
+      : queues_(threads),
+        max_depth_(max_depth),
+        visit_(visit),
+        on_error_(on_error) {}
+
+  void push(size_t worker, DirTask task) {
+    pending_.fetch_add(1, std::memory_order_relaxed);
+    {
+      std::lock_guard lock(queues_[worker].mutex);
+      queues_[worker].tasks.push_back(std::move(task));
+    }
+    if (idle_.load(std::memory_order_relaxed) != 0) {
+      idle_cv_.notify_one();
+    }
+  }
+
+  void run(size_t worker) {
+    try {
+      DirTask task;
+      while (!failed_.load(std::memory_order_relaxed)) {
+        throwIfCancelled();
+        if (popLocal(worker, task) || steal(worker, task)) {
+          processDirectory(worker, task);
+          if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            idle_cv_.notify_all();
+          }
+          continue;
+        }
+        if (pending_.load(std::memory_order_acquire) == 0) {
+          return;
+        }
+        waitForWork();
+      }
+    } catch (...) {
+      {
+        std::lock_guard lock(error_mutex_);
+        if (!error_) {
+          error_ = std::current_exception();
+        }
+      }
+      failed_.store(true, std::memory_order_relaxed);
+      idle_cv_.notify_all();
+    }
+  }
+
+  void rethrowIfFailed() {
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+  void reportError(std::string_view path, int error) {
+    if (on_error_) {
+      on_error_(path, error);
+    }
+  }
+
+  // Numbers directories before they are visited; see WalkEntry::id.
+  WalkAction visit(WalkEntry& entry) {
+    entry.id = entry.type == DT_DIR
+                   ? next_id_.fetch_add(1, std::memory_order_relaxed)
+                   : WalkEntry::kNoDirectory;
+    return visit_(entry);
+  }
+
+  [[nodiscard]] size_t directoryCount() const {
+    return next_id_.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] size_t maxDepth() const { return max_depth_; }
+
+ private:
+  bool popLocal(size_t worker, DirTask& task) {
+    auto& queue = queues_[worker];
+    std::lock_guard lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+  }
+
+  bool steal(size_t worker, DirTask& task) {
+    for (size_t i = 1; i < queues_.size(); ++i) {
+      auto& queue = queues_[(worker + i) % queues_.size()];
+      std::lock_guard lock(queue.mutex);
+      if (!queue.tasks.empty()) {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void waitForWork() {
+    constexpr auto kIdleTimeout = std::chrono::milliseconds(1);
+    idle_.fetch_add(1, std::memory_order_relaxed);
+    std::unique_lock lock(idle_mutex_);
+    idle_cv_.wait_for(lock, kIdleTimeout);
+    idle_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void processDirectory(size_t worker, const DirTask& task) {
+    constexpr int kFlags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+    auto dir = std::make_shared<const UniqueFd>(
+        task.parent ? openat(task.parent->get(),
+                             task.path.c_str() + task.name_offset,
+                             kFlags | O_NOFOLLOW)
+                    : open(task.path.c_str(), kFlags));
+    if (!*dir) {
+      reportError(task.path, errno);
+      return;
+    }
+    const int fd = dir->get();
+
+    std::string child_path = task.path;
+    if (child_path.empty() || child_path.back() != '/') {
+      child_path.push_back('/');
+    }
+    const size_t prefix_size = child_path.size();
+
+    // Only reading the directory is its error; whatever the visitor throws
+    // goes to the caller.
+    std::optional<DirReader> reader;
+    DirReader::Entry dirent{};
+    while (true) {
+      try {
+        if (!reader) {
+          reader.emplace(fd);
+        }
+        if (!reader->next(dirent)) {
+          return;
+        }
+      } catch (const std::system_error& err) {
+        reportError(task.path, err.code().value());
+        return;
+      }
+      throwIfCancelled();
+      child_path.resize(prefix_size);
+      child_path.append(dirent.name);
+
+      WalkEntry entry{};
+      entry.dirfd = fd;
+      entry.name = dirent.name;
+      entry.path = child_path;
+      entry.type = resolveDirentType(fd, dirent.name.data(), dirent.type);
+      entry.ino = dirent.ino;
+      entry.depth = task.depth + 1;
+      entry.worker = worker;
+      entry.parent_id = task.id;
+
+      if (visit(entry) == WalkAction::kContinue && entry.type == DT_DIR &&
+          entry.depth < max_depth_) {
+        push(worker,
+             DirTask{dir, child_path, prefix_size, entry.depth, entry.id});
+      }
+    }
+  }
+
+  std::vector<WorkerQueue> queues_;
+  size_t max_depth_;
+  const DirWalker::Visitor& visit_;
+  const DirWalker::ErrorHandler& on_error_;
+
+  std::atomic<size_t> pending_{0};
+  std::atomic<size_t> next_id_{0};
+  std::atomic<size_t> idle_{0};
+  std::atomic<bool> failed_{false};
+  std::mutex idle_mutex_;
+  std::condition_variable idle_cv_;
+
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+};
+
+}  // namespace
+
+DirWalker::DirWalker(size_t threads) : threads_(std::max<size_t>(1, threads)) {}
+
+size_t DirWalker::walk(const std::vector<std::string>& roots,
+                       const Visitor& visit, const ErrorHandler& on_error) {
+  WalkState state(threads_, max_depth_, visit, on_error);
+
+  size_t next_queue = 0;
+  for (const auto& root : roots) {
+    struct stat st {};
+    if (lstat(root.c_str(), &st) != 0) {
+      state.reportError(root, errno);
+      continue;
+    }
+
+    WalkEntry entry{};
+    entry.dirfd = AT_FDCWD;
+    entry.name = root;
+    entry.path = root;
+    entry.type = direntTypeFromMode(st.st_mode);
+    entry.ino = st.st_ino;
+    entry.depth = 0;
+    entry.worker = 0;
+    entry.parent_id = WalkEntry::kNoDirectory;
+
+    // Roots given explicitly are followed even when they are symlinks.
+    if (entry.type == DT_LNK && stat(root.c_str(), &st) == 0 &&
+        S_ISDIR(st.st_mode)) {
+      entry.type = DT_DIR;
+    }
+
+    if (state.visit(entry) == WalkAction::kContinue && entry.type == DT_DIR &&
+        max_depth_ > 0) {
+      state.push(next_queue++ % threads_,
+                 DirTask{nullptr, root, 0, 0, entry.id});
+    }
+  }
+
+  // Workers share the stage's cancellation, so a finished downstream stops
+  // the whole walk rather than the calling thread alone.
+  const Cancellation* cancellation = currentCancellation();
+  std::vector<std::thread> workers;
+  workers.reserve(threads_ - 1);
+  for (size_t i = 1; i < threads_; ++i) {
+    workers.emplace_back([&state, cancellation, i] {
+      CancellationScope scope(cancellation);
+      state.run(i);
+    });
+  }
+  state.run(0);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  state.rethrowIfFailed();
+  return state.directoryCount();
+}
+
+}  // namespace coreutils
@@ -0,0 +1,343 @@
+#include <du_command.hpp>
+
+#include <buffered_writer.hpp>
+#include <builtin_registry.hpp>
+#include <dir_walker.hpp>
+#include <parallel.hpp>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+
+namespace coreutils {
+
+namespace {
+
+constexpr uint64_t kBlockSize = 512;  // unit of st_blocks
+constexpr uint64_t kKiB = 1024;
+constexpr size_t kInodeShards = 64;
+
+struct FileUsage {
+  uint64_t bytes;
+  dev_t dev;
+  nlink_t nlink;
+};
+
+// Requests only the fields du needs: the allocated blocks or the apparent
+// size, and the link count to spot hard links. Returns 0 or an errno value.
+int statUsage(const WalkEntry& entry, bool apparent, FileUsage& usage) {
+  // Roots that resolved to a directory through a symlink are measured as
+  // the directory they point to.
+  const bool follow = entry.depth == 0 && entry.type == DT_DIR;
+#ifdef STATX_BASIC_STATS
+  const unsigned mask = (apparent ? STATX_SIZE : STATX_BLOCKS) | STATX_NLINK;
+  struct statx stx {};
+  const int flags = AT_NO_AUTOMOUNT | (follow ? 0 : AT_SYMLINK_NOFOLLOW);
+  if (statx(entry.dirfd, entry.name.data(), flags, mask, &stx) != 0) {
+    return errno;
+  }
+  usage.bytes = apparent ? stx.stx_size : stx.stx_blocks * kBlockSize;
+  usage.dev = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+  usage.nlink = stx.stx_nlink;
+#else
+  struct stat st {};
+  if (fstatat(entry.dirfd, entry.name.data(), &st,
+              follow ? 0 : AT_SYMLINK_NOFOLLOW) != 0) {
+    return errno;
+  }
+  usage.bytes = apparent ? static_cast<uint64_t>(st.st_size)
+                         : static_cast<uint64_t>(st.st_blocks) * kBlockSize;
+  usage.dev = st.st_dev;
+  usage.nlink = st.st_nlink;
+#endif
+  return 0;
+}
+
+// Concurrent set of (device, inode) pairs, sharded by inode so that
+// workers rarely contend for the same lock.
+class InodeSet final {
+ public:
+  // Returns false when the pair was already present.
+  bool insert(dev_t dev, ino_t ino) {
+    auto& shard = shards_[std::hash<ino_t>{}(ino) % shards_.size()];
+    std::lock_guard lock(shard.mutex);
+    return shard.keys.emplace(dev, ino).second;
+  }
+
+ private:
+  struct KeyHash {
+    size_t operator()(const std::pair<dev_t, ino_t>& key) const {
+      return std::hash<ino_t>{}(key.second) * 31 +
+             std::hash<dev_t>{}(key.first);
+    }
+  };
+
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    std::unordered_set<std::pair<dev_t, ino_t>, KeyHash> keys;
+  };
+
+  std::array<Shard, kInodeShards> shards_;
+};
+
+struct DirRecord {
+  size_t id;
+  size_t parent_id;
+  size_t depth;
+  std::string path;  // only kept for directories that get printed
+};
+
+// Everything one walking thread learns; merged after the walk.
+struct alignas(64) WorkerState {
+  std::vector<DirRecord> dirs;
+  // (directory id, bytes) pairs. A worker visits the entries of one
+  // directory at a time, so consecutive additions usually share the id and
+  // are folded into the last pair.
+  std::vector<std::pair<size_t, uint64_t>> usage;
+
+  void add(size_t id, uint64_t bytes) {
+    if (!usage.empty() && usage.back().first == id) {
+      usage.back().second += bytes;
+    } else {
+      usage.emplace_back(id, bytes);
+    }
+  }
+};
+
+// A command-line operand, in argument order.
+struct Operand {
+  std::string path;
+  size_t id;       // directory id, kNoDirectory for files
+  uint64_t bytes;  // size of a non-directory operand
+};
+
+std::string_view formatNumber(uint64_t value, std::array<char, 24>& digits) {
+  auto [end, ec] =
+      std::to_chars(digits.data(), digits.data() + digits.size(), value);
+  return {digits.data(), static_cast<size_t>(end - digits.data())};
+}
+
+}  // namespace
+
+DuCommand::DuCommand(std::vector<std::string> args) {
+  for (size_t pos = 0; pos < args.size(); ++pos) {
+    const std::string_view arg = args[pos];
+    if (arg == "--apparent-size") {
+      apparent_size_ = true;
+      continue;
+    }
+    if (arg.size() < 2 || arg[0] != '-') {
+      paths_.emplace_back(arg);
+      continue;
+    }
+    for (size_t i = 1; i < arg.size(); ++i) {
+      switch (arg[i]) {
+        case 's':
+          max_depth_ = 0;
+          break;
+        case 'h':
+          human_readable_ = true;
+          break;
+        case 'd': {
+          // The depth is the rest of this argument or the next one.
+          std::string_view value = arg.substr(i + 1);
+          if (value.empty()) {
+            if (pos + 1 == args.size()) {
+              throw std::invalid_argument(
+                  "du: option requires an argument -- 'd'");
+            }
+            value = args[++pos];
+          }
+          auto [end, ec] =
+              std::from_chars(value.data(), value.data() + value.size(),
+                              max_depth_);
+          if (ec != std::errc{} || end != value.data() + value.size()) {
+            throw std::invalid_argument("du: invalid maximum depth '" +
+                                        std::string(value) + "'");
+          }
+          i = arg.size();
+          break;
+        }
+        default:
+          throw std::invalid_argument("du: invalid option -- '" +
+                                      std::string(1, arg[i]) + "'");
+      }
+    }
+  }
+}
+
+// Without -h sizes are in 1 KiB units, rounded up. With -h they are
+// rounded up to one decimal below 10 and to whole units above, like GNU du.
+std::string DuCommand::formatSize(uint64_t bytes) const {
+  std::array<char, 24> digits{};
+  if (!human_readable_) {
+    return std::string(formatNumber((bytes + kKiB - 1) / kKiB, digits));
+  }
+  if (bytes < kKiB) {
+    return std::string(formatNumber(bytes, digits));
+  }
+
+  static constexpr std::string_view kUnits = "KMGTPE";
+  auto round_up = [](double value) {
+    return value < 10 ? std::ceil(value * 10) / 10 : std::ceil(value);
+  };
+  double value = static_cast<double>(bytes) / kKiB;
+  size_t unit = 0;
+  while (round_up(value) >= kKiB && unit + 1 < kUnits.size()) {
+    value /= kKiB;
+    ++unit;
+  }
+  value = round_up(value);
+
+  std::array<char, 32> buffer{};
+  const int length = std::snprintf(buffer.data(), buffer.size(),
+                                   value < 10 ? "%.1f%c" : "%.0f%c", value,
+                                   kUnits[unit]);
+  return {buffer.data(), static_cast<size_t>(length)};
+}
+
+int DuCommand::run(Input&, Output& out) {
+  const std::vector<std::string> roots =
+      paths_.empty() ? std::vector<std::string>{"."} : paths_;
+
+  const size_t threads = workerCount();
+  std::vector<WorkerState> workers(threads);
+  std::vector<Operand> operands;
+  InodeSet seen_inodes;
+  std::atomic<bool> failed{false};
+
+  // Walking threads report concurrently, so each message is a single write.
+  auto report_error = [&failed](std::string_view path, int error) {
+    std::cerr << ("du: '" + std::string(path) + "': " + std::strerror(error) +
+                  '\n');
+    failed.store(true, std::memory_order_relaxed);
+  };
+
+  auto visit = [&](const WalkEntry& entry) {
+    FileUsage usage{};
+    if (int error = statUsage(entry, apparent_size_, usage); error != 0) {
+      report_error(entry.path, error);
+      return WalkAction::kSkip;
+    }
+    if (entry.type != DT_DIR && usage.nlink > 1 &&
+        !seen_inodes.insert(usage.dev, entry.ino)) {
+      return WalkAction::kContinue;
+    }
+
+    // Roots are visited on the calling thread before the workers start.
+    if (entry.depth == 0) {
+      operands.push_back({std::string(entry.path), entry.id, usage.bytes});
+    }
+
+    auto& state = workers[entry.worker];
+    if (entry.type == DT_DIR) {
+      const bool printed = entry.depth <= max_depth_;
+      state.dirs.push_back({entry.id, entry.parent_id, entry.depth,
+                            printed ? std::string(entry.path) : std::string()});
+      state.add(entry.id, usage.bytes);
+    } else if (entry.parent_id != WalkEntry::kNoDirectory) {
+      state.add(entry.parent_id, usage.bytes);
+    }
+    return WalkAction::kContinue;
+  };
+
+  size_t dir_count = 0;
+  try {
+    DirWalker walker(threads);
+    dir_count = walker.walk(roots, visit, report_error);
+  } catch (const std::runtime_error& err) {
+    std::cerr << "du: " << err.what() << '\n';
+    return 1;
+  }
+
+  // Parents always have smaller ids than their children, so one pass from
+  // the highest id down folds every subtree into its root.
+  std::vector<uint64_t> totals(dir_count);
+  std::vector<size_t> parents(dir_count, WalkEntry::kNoDirectory);
+  std::vector<const DirRecord*> records(dir_count);
+  for (const auto& state : workers) {
+    for (const auto& record : state.dirs) {
+      parents[record.id] = record.parent_id;
+      records[record.id] = &record;
+    }
+    for (const auto& [id, bytes] : state.usage) {
+      totals[id] += bytes;
+    }
+  }
+  for (size_t id = dir_count; id-- > 0;) {
+    if (parents[id] != WalkEntry::kNoDirectory) {
+      totals[parents[id]] += totals[id];
+    }
+  }
+
+  // Printed directories, children sorted by name, emitted in post-order
+  // like GNU du does.
+  std::vector<std::vector<size_t>> children(dir_count);
+  for (size_t id = 0; id < dir_count; ++id) {
+    if (records[id] != nullptr && records[id]->depth <= max_depth_ &&
+        parents[id] != WalkEntry::kNoDirectory) {
+      children[parents[id]].push_back(id);
+    }
+  }
+  for (auto& list : children) {
+    std::sort(list.begin(), list.end(), [&](size_t a, size_t b) {
+      return records[a]->path < records[b]->path;
+    });
+  }
+
+  BufferedWriter writer(out);
+  auto print = [&](uint64_t bytes, std::string_view path) {
+    writer.write(formatSize(bytes));
+    writer.put('\t');
+    writer.write(path);
+    writer.put('\n');
+  };
+
+  for (const auto& operand : operands) {
+    if (operand.id == WalkEntry::kNoDirectory) {
+      print(operand.bytes, operand.path);
+      continue;
+    }
+    // Iterative post-order: a directory is printed once all of its
+    // children have been.
+    std::vector<std::pair<size_t, size_t>> stack = {{operand.id, 0}};
+    while (!stack.empty()) {
+      auto& [id, next_child] = stack.back();
+      if (next_child < children[id].size()) {
+        const size_t child = children[id][next_child++];
+        stack.emplace_back(child, 0);
+        continue;
+      }
+      print(totals[id], records[id]->path);
+      stack.pop_back();
+    }
+  }
+  writer.flush();
+
+  return failed ? 1 : 0;
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{"du", makeBuiltin<DuCommand>};
+
+}  // namespace
+
+}  // namespace coreutils
@@ -1,5 +1,7 @@
 #include <echo_command.hpp>
 
+#include <builtin_registry.hpp>
+
 #include <sstream>
 
 namespace coreutils {
@@ -20,4 +22,10 @@ int EchoCommand::run(Input& /*in*/, Output& out) {
   return 0;
 }
 
+namespace {
+
+const BuiltinRegistrar kRegistrar{"echo", makeBuiltin<EchoCommand>};
+
+}  // namespace
+
 }  // namespace coreutils
@@ -0,0 +1,109 @@
+#include <enable_command.hpp>
+
+#include <builtin_registry.hpp>
+#include <plugin_api.hpp>
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace coreutils {
+
+namespace {
+
+constexpr std::string_view kUsage = "enable: usage: enable [-f FILE NAME...]";
+
+// Opens each plugin once per session. Handles are never closed: the
+// registry keeps pointers to the names and factories inside the plugin.
+const PluginInfo* loadPlugin(const std::string& file) {
+  static std::unordered_map<std::string, const PluginInfo*> loaded;
+  if (auto it = loaded.find(file); it != loaded.end()) {
+    return it->second;
+  }
+
+  void* handle = dlopen(file.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle == nullptr) {
+    std::cerr << "enable: " << dlerror() << '\n';
+    return nullptr;
+  }
+
+  using EntryPoint = const PluginInfo* (*)();
+  auto entry =
+      reinterpret_cast<EntryPoint>(dlsym(handle, kPluginEntryPoint));
+  const PluginInfo* plugin = entry != nullptr ? entry() : nullptr;
+  if (plugin == nullptr || plugin->abi_version != kPluginAbiVersion) {
+    std::cerr << "enable: " << file << ": not a plugin for this shell\n";
+    dlclose(handle);
+    return nullptr;
+  }
+
+  loaded.emplace(file, plugin);
+  return plugin;
+}
+
+}  // namespace
+
+EnableCommand::EnableCommand(std::vector<std::string> args) {
+  if (args.empty()) {
+    return;
+  }
+  if (args.size() < 3 || args.front() != "-f") {
+    throw std::invalid_argument(std::string(kUsage));
+  }
+  file_ = std::move(args[1]);
+  names_.assign(std::make_move_iterator(args.begin() + 2),
+                std::make_move_iterator(args.end()));
+}
+
+int EnableCommand::run(Input& /*in*/, Output& out) {
+  auto& registry = BuiltinRegistry::instance();
+  if (file_.empty()) {
+    std::string result;
+    for (const Builtin& builtin : registry.builtins()) {
+      result.append("enable ").append(builtin.name).push_back('\n');
+    }
+    out.write(result);
+    return 0;
+  }
+
+  const PluginInfo* plugin = loadPlugin(file_);
+  if (plugin == nullptr) {
+    return 1;
+  }
+
+  const std::span<const Builtin> provided(plugin->builtins, plugin->count);
+  int status = 0;
+  for (const auto& name : names_) {
+    auto builtin = std::ranges::find(provided, name, &Builtin::name);
+    if (builtin == provided.end()) {
+      std::cerr << "enable: " << name << ": not found in " << file_ << '\n';
+      status = 1;
+      continue;
+    }
+
+    const Builtin* existing = registry.find(name);
+    if (existing != nullptr && existing->factory == builtin->factory) {
+      continue;
+    }
+    if (!registry.add(builtin->name, builtin->factory)) {
+      std::cerr << "enable: " << name << ": a builtin of that name exists\n";
+      status = 1;
+    }
+  }
+  return status;
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{"enable", makeBuiltin<EnableCommand>};
+
+}  // namespace
+
+}  // namespace coreutils
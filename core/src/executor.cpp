@@ -1,13 +1,32 @@
 #include <executor.hpp>
 
 #include <cassert>
+#include <csignal>
+#include <exception>
+#include <optional>
+#include <thread>
 #include <vector>
 
+#include <cancellation.hpp>
 #include <command.hpp>
 #include <pipe.hpp>
 
 namespace coreutils {
 
+namespace {
+
+// Status of a stage ended by a cancelled pipeline, as if killed by SIGPIPE.
+constexpr int kCancelledStatus = 128 + SIGPIPE;
+
+}  // namespace
+
+// Every stage but the last runs on a thread of its own, so stages stream
+// into each other through the pipes. A stage that finishes cancels the
+// stages before it, since nothing is left to read what they produce, and
+// then closes both of its pipe ends: the next stage sees the end of input,
+// the previous one EPIPE on its next write. The shell ignores SIGPIPE, so
+// that write fails instead of killing it. The last stage has nothing
+// downstream and is never cancelled.
 int Executor::runCommands(std::vector<CommandPtr> cmds, Input& in,
                           Output& out) {
   assert(!cmds.empty());
@@ -16,29 +35,74 @@ int Executor::runCommands(std::vector<CommandPtr> cmds, Input& in,
     return cmds[0]->run(in, out);
   }
 
-  std::unique_ptr<Input> current_input;
-  Input* in_ptr = &in;
-
-  int exit_code = 0;
+  const size_t count = cmds.size();
+  // inputs[i] and outputs[i] are the pipe ends of stage i; the first
+  // stage reads `in` and the last one writes `out`.
+  std::vector<std::unique_ptr<Input>> inputs(count);
+  std::vector<std::unique_ptr<Output>> outputs(count);
+  for (size_t i = 0; i + 1 < count; ++i) {
+    auto [pipe_in, pipe_out] = createPipe();
+    outputs[i] = std::move(pipe_out);
+    inputs[i + 1] = std::move(pipe_in);
+  }
 
-  for (size_t i = 0; i < cmds.size(); ++i) {
-    const bool is_last_cmd = (i + 1 == cmds.size());
+  std::vector<Cancellation> cancellations(count);
+  std::vector<int> statuses(count, 0);
+  std::vector<std::exception_ptr> errors(count);
 
-    if (!is_last_cmd) {
-      // Пайп между cmd[i] и cmd[i+1]
-      auto [pipe_in, pipe_out] = createPipe();
-      exit_code = cmds[i]->run(*in_ptr, *pipe_out);
+  auto run_stage = [&](size_t i) {
+    // cd, exit and export before the last stage are skipped, as if run in
+    // a subshell, instead of changing the shell from a worker thread.
+    if (i + 1 == count || !cmds[i]->changesShellState()) {
+      std::optional<CancellationScope> scope;
+      if (i + 1 != count) {
+        scope.emplace(cancellations[i]);
+      }
+      try {
+        statuses[i] = cmds[i]->run(inputs[i] ? *inputs[i] : in,
+                                   outputs[i] ? *outputs[i] : out);
+      } catch (const PipelineCancelled&) {
+        statuses[i] = kCancelledStatus;
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }
+    for (size_t j = 0; j < i; ++j) {
+      cancellations[j].cancel();
+    }
+    outputs[i].reset();
+    inputs[i].reset();
+  };
 
-      // cmd[i+1] будет читать из pipe_in
-      current_input = std::move(pipe_in);
-      in_ptr = current_input.get();
-    } else {
-      // Последняя команда пишет в out
-      exit_code = cmds[i]->run(*in_ptr, out);
+  std::vector<std::thread> threads;
+  threads.reserve(count - 1);
+  try {
+    for (size_t i = 0; i + 1 < count; ++i) {
+      threads.emplace_back(run_stage, i);
+    }
+  } catch (...) {
+    // The stages that did not start close their pipe ends, which lets the
+    // running ones finish.
+    for (size_t i = threads.size(); i < count; ++i) {
+      outputs[i].reset();
+      inputs[i].reset();
+    }
+    for (auto& thread : threads) {
+      thread.join();
     }
+    throw;
+  }
+  run_stage(count - 1);
+  for (auto& thread : threads) {
+    thread.join();
   }
 
-  return exit_code;
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  return statuses.back();
 }
 
 }  // namespace coreutils
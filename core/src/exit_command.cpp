@@ -0,0 +1,19 @@
+#include <exit_command.hpp>
+
+#include <builtin_registry.hpp>
+
+namespace coreutils {
+
+namespace {
+
+// Exit command ignores arguments
+const BuiltinRegistrar kRegistrar{
+    "exit",
+    [](std::vector<std::string> /*args*/,
+       const BuiltinContext& /*context*/) -> std::unique_ptr<Command> {
+      return std::make_unique<ExitCommand>();
+    }};
+
+}  // namespace
+
+}  // namespace coreutils
@@ -0,0 +1,74 @@
+#include <export_command.hpp>
+
+#include <builtin_registry.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils {
+
+namespace {
+
+bool isValidName(std::string_view name) {
+  if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+    return false;
+  }
+  return std::ranges::all_of(name, [](char ch) {
+    return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_';
+  });
+}
+
+}  // namespace
+
+int ExportCommand::run(Input& /*in*/, Output& out) {
+  if (args_.empty()) {
+    std::vector<std::string_view> entries;
+    for (char* const* entry = variables_.envp(); *entry != nullptr; ++entry) {
+      entries.emplace_back(*entry);
+    }
+    std::ranges::sort(entries);
+
+    std::string result;
+    for (auto entry : entries) {
+      result.append("export ").append(entry).push_back('\n');
+    }
+    out.write(result);
+    return 0;
+  }
+
+  int status = 0;
+  for (const auto& arg : args_) {
+    const size_t eq_pos = arg.find('=');
+    const std::string_view name = std::string_view(arg).substr(0, eq_pos);
+    if (!isValidName(name)) {
+      std::cerr << "export: '" << arg << "': not a valid identifier\n";
+      status = 1;
+      continue;
+    }
+
+    if (eq_pos != std::string::npos) {
+      variables_.set(name, std::string_view(arg).substr(eq_pos + 1));
+    }
+    variables_.exportVariable(name);
+  }
+  return status;
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{
+    "export",
+    [](std::vector<std::string> args,
+       const BuiltinContext& context) -> std::unique_ptr<Command> {
+      return std::make_unique<ExportCommand>(std::move(args),
+                                             context.variables);
+    }};
+
+}  // namespace
+
+}  // namespace coreutils
@@ -4,6 +4,7 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <csignal>
 #include <iostream>
 #include <stdexcept>
 #include <vector>
@@ -17,6 +18,9 @@ int ExternalCommand::run(Input& in, Output& out) {
   }
 
   if (pid == 0) {
+    // The shell ignores SIGPIPE; a producer whose reader is gone should die
+    // of it as usual.
+    std::signal(SIGPIPE, SIG_DFL);
     in.setStdin();
     out.setStdout();
     std::vector<char*> argvs;
@@ -26,6 +30,10 @@ int ExternalCommand::run(Input& in, Output& out) {
       argvs.push_back(arg.data());
     }
     argvs.push_back(nullptr);
+    if (envp_ != nullptr) {
+      // execvp() searches the PATH of the environment it runs in.
+      environ = const_cast<char**>(envp_);
+    }
     execvp(command_.data(), argvs.data());
     std::cerr << command_ << ": command not found\n";
     _exit(127);
@@ -33,7 +41,8 @@ int ExternalCommand::run(Input& in, Output& out) {
     child_ = pid;
     int status = 0;
     waitpid(pid, &status, 0);
-    return WEXITSTATUS(status);
+    return WIFSIGNALED(status) ? 128 + WTERMSIG(status)
+                               : WEXITSTATUS(status);
   }
 }
 
@@ -0,0 +1,107 @@
+#include <fd_io.hpp>
+
+#include <cancellation.hpp>
+
+#include <unistd.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#endif
+
+#include <cerrno>
+#include <system_error>
+#include <vector>
+
+namespace coreutils {
+
+namespace {
+
+constexpr size_t kCopyBufferSize = 128 * 1024;
+// Upper bound for a single sendfile()/splice() call; both return short
+// counts anyway, this only keeps the request within ssize_t.
+constexpr size_t kTransferSize = 1U << 30;
+
+void writeAll(int fd, const char* data, size_t size) {
+  throwIfCancelled();
+  while (size != 0) {
+    auto res = ::write(fd, data, size);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EPIPE) {
+        throwBrokenPipe("write");
+      }
+      throw std::system_error(errno, std::generic_category(), "write");
+    }
+    data += res;
+    size -= static_cast<size_t>(res);
+  }
+}
+
+#ifdef __linux__
+// Runs `transfer()` until the end of input. Returns false without having
+// moved any data when the kernel refuses this kind of descriptor pair, so
+// that the caller can try the next method.
+bool transferAll(auto transfer) {
+  bool moved_any = false;
+  while (true) {
+    throwIfCancelled();
+    auto res = transfer();
+    if (res > 0) {
+      moved_any = true;
+      continue;
+    }
+    if (res == 0) {
+      return true;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EPIPE) {
+      throwBrokenPipe("copy");
+    }
+    if (!moved_any && (errno == EINVAL || errno == ENOSYS)) {
+      return false;
+    }
+    throw std::system_error(errno, std::generic_category(), "copy");
+  }
+}
+#endif
+
+}  // namespace
+
+size_t readFd(int fd, char* data, size_t size) {
+  throwIfCancelled();
+  while (true) {
+    auto res = ::read(fd, data, size);
+    if (res >= 0) {
+      return static_cast<size_t>(res);
+    }
+    if (errno != EINTR) {
+      throw std::system_error(errno, std::generic_category(), "read");
+    }
+  }
+}
+
+void copyFd(int from, int to) {
+#ifdef __linux__
+  if (transferAll([&] { return sendfile(to, from, nullptr, kTransferSize); })) {
+    return;
+  }
+  if (transferAll([&] {
+        return splice(from, nullptr, to, nullptr, kTransferSize, SPLICE_F_MOVE);
+      })) {
+    return;
+  }
+#endif
+
+  std::vector<char> buffer(kCopyBufferSize);
+  for (size_t size = readFd(from, buffer.data(), buffer.size()); size != 0;
+       size = readFd(from, buffer.data(), buffer.size())) {
+    writeAll(to, buffer.data(), size);
+  }
+}
+
+}  // namespace coreutils
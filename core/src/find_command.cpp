@@ -0,0 +1,150 @@
+#include <find_command.hpp>
+
+#include <buffered_writer.hpp>
+#include <builtin_registry.hpp>
+#include <dir_walker.hpp>
+#include <find_program.hpp>
+#include <parallel.hpp>
+#include <string_sort.hpp>
+
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+
+namespace coreutils {
+
+namespace {
+
+// Each worker hands its matches to the output once this much has piled up,
+// so the output lock is taken once per block rather than once per path.
+constexpr size_t kFlushSize = 64 * 1024;
+
+bool startsExpression(std::string_view arg) {
+  return arg.starts_with('-') || arg == "(" || arg == "!";
+}
+
+}  // namespace
+
+FindCommand::FindCommand(std::vector<std::string> args) {
+  size_t pos = 0;
+  while (pos < args.size() && args[pos] == "-s") {
+    sorted_ = true;
+    ++pos;
+  }
+  while (pos < args.size() && !startsExpression(args[pos])) {
+    paths_.push_back(std::move(args[pos++]));
+  }
+
+  // -maxdepth is an option, not a test: it may appear anywhere in the
+  // expression and applies to the whole walk.
+  while (pos < args.size()) {
+    if (args[pos] != "-maxdepth") {
+      expression_.push_back(std::move(args[pos++]));
+      continue;
+    }
+    if (pos + 1 == args.size()) {
+      throw std::invalid_argument("find: missing argument to '-maxdepth'");
+    }
+    const std::string_view value = args[pos + 1];
+    size_t depth = 0;
+    auto [end, ec] =
+        std::from_chars(value.data(), value.data() + value.size(), depth);
+    if (value.empty() || ec != std::errc{} ||
+        end != value.data() + value.size()) {
+      throw std::invalid_argument("find: invalid argument '" +
+                                  std::string(value) + "' to -maxdepth");
+    }
+    max_depth_ = depth;
+    pos += 2;
+  }
+
+  // Compile once up front so that syntax errors surface at parse time.
+  static_cast<void>(FindProgram(expression_, 0));
+}
+
+int FindCommand::run(Input&, Output& out) {
+  const FindProgram program(expression_,
+                            static_cast<int64_t>(std::time(nullptr)));
+  const std::vector<std::string> roots =
+      paths_.empty() ? std::vector<std::string>{"."} : paths_;
+
+  const size_t threads = workerCount();
+  DirWalker walker(threads);
+  if (max_depth_) {
+    walker.setMaxDepth(*max_depth_);
+  }
+
+  // Matches collect in the walking worker's own buffer, which doubles as
+  // the arena of paths for -s.
+  std::vector<std::string> buffers(threads);
+  std::mutex out_mutex;
+  std::atomic<bool> failed{false};
+
+  // Walking threads report concurrently, so each message is a single write.
+  auto report_error = [&failed](std::string_view path, int error) {
+    std::cerr << ("find: '" + std::string(path) +
+                  "': " + std::strerror(error) + '\n');
+    failed.store(true, std::memory_order_relaxed);
+  };
+
+  auto visit = [&](const WalkEntry& entry) {
+    if (!program.matches(entry)) {
+      return WalkAction::kContinue;
+    }
+    auto& buffer = buffers[entry.worker];
+    buffer.append(entry.path);
+    buffer.push_back('\n');
+    if (!sorted_ && buffer.size() >= kFlushSize) {
+      std::lock_guard lock(out_mutex);
+      out.write(buffer);
+      buffer.clear();
+    }
+    return WalkAction::kContinue;
+  };
+
+  try {
+    walker.walk(roots, visit, report_error);
+
+    if (!sorted_) {
+      for (const auto& buffer : buffers) {
+        out.write(buffer);
+      }
+    } else {
+      std::vector<std::string_view> paths;
+      for (std::string_view buffer : buffers) {
+        for (size_t begin = 0; begin < buffer.size();) {
+          const size_t end = buffer.find('\n', begin);
+          paths.push_back(buffer.substr(begin, end - begin));
+          begin = end + 1;
+        }
+      }
+      radixSort(std::span(paths), [](std::string_view path) { return path; });
+
+      BufferedWriter writer(out);
+      for (auto path : paths) {
+        writer.write(path);
+        writer.put('\n');
+      }
+      writer.flush();
+    }
+  } catch (const std::runtime_error& err) {
+    std::cerr << "find: " << err.what() << '\n';
+    return 1;
+  }
+
+  return failed ? 1 : 0;
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{"find", makeBuiltin<FindCommand>};
+
+}  // namespace
+
+}  // namespace coreutils
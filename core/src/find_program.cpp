@@ -0,0 +1,262 @@
+#include <find_program.hpp>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <charconv>
+#include <stdexcept>
+#include <string_view>
+
+namespace coreutils {
+
+namespace {
+
+constexpr int64_t kSecondsPerDay = 24 * 60 * 60;
+constexpr int64_t kDefaultSizeUnit = 512;
+
+std::invalid_argument parseError(const std::string& message) {
+  return std::invalid_argument("find: " + message);
+}
+
+// Name a test like -name sees: the last path component, also for roots
+// given as "dir/" or "a/b".
+std::string_view baseName(const WalkEntry& entry) {
+  if (entry.depth != 0) {
+    return entry.name;
+  }
+  std::string_view path = entry.path;
+  while (path.size() > 1 && path.back() == '/') {
+    path.remove_suffix(1);
+  }
+  const size_t slash = path.rfind('/');
+  if (slash != std::string_view::npos && path.size() > 1) {
+    path.remove_prefix(slash + 1);
+  }
+  return path;
+}
+
+int64_t ceilDiv(int64_t value, int64_t unit) {
+  return (value + unit - 1) / unit;
+}
+
+// Floor division, so that files from the future land in negative days.
+int64_t floorDiv(int64_t value, int64_t unit) {
+  const int64_t quotient = value / unit;
+  return (value % unit != 0 && value < 0) ? quotient - 1 : quotient;
+}
+
+}  // namespace
+
+FindProgram::FindProgram(const std::vector<std::string>& tokens, int64_t now)
+    : now_(now) {
+  size_t pos = 0;
+  if (tokens.empty()) {
+    return;
+  }
+  parseOr(tokens, pos);
+  if (pos != tokens.size()) {
+    throw parseError("unexpected '" + tokens[pos] + "'");
+  }
+}
+
+void FindProgram::patchJumps(const std::vector<size_t>& jumps) {
+  for (size_t jump : jumps) {
+    code_[jump].index = static_cast<uint32_t>(code_.size());
+  }
+}
+
+void FindProgram::parseOr(const std::vector<std::string>& tokens,
+                          size_t& pos) {
+  std::vector<size_t> jumps;
+  parseAnd(tokens, pos);
+  while (pos < tokens.size() &&
+         (tokens[pos] == "-o" || tokens[pos] == "-or")) {
+    ++pos;
+    jumps.push_back(code_.size());
+    code_.push_back({.op = Op::kJumpIfTrue});
+    parseAnd(tokens, pos);
+  }
+  patchJumps(jumps);
+}
+
+void FindProgram::parseAnd(const std::vector<std::string>& tokens,
+                           size_t& pos) {
+  std::vector<size_t> jumps;
+  parseUnary(tokens, pos);
+  while (pos < tokens.size() && tokens[pos] != "-o" && tokens[pos] != "-or" &&
+         tokens[pos] != ")") {
+    if (tokens[pos] == "-a" || tokens[pos] == "-and") {
+      ++pos;
+    }
+    jumps.push_back(code_.size());
+    code_.push_back({.op = Op::kJumpIfFalse});
+    parseUnary(tokens, pos);
+  }
+  patchJumps(jumps);
+}
+
+void FindProgram::parseUnary(const std::vector<std::string>& tokens,
+                             size_t& pos) {
+  if (pos == tokens.size()) {
+    throw parseError("expected an expression");
+  }
+  const auto& token = tokens[pos];
+  if (token == "!" || token == "-not") {
+    ++pos;
+    parseUnary(tokens, pos);
+    code_.push_back({.op = Op::kNot});
+    return;
+  }
+  if (token == "(") {
+    ++pos;
+    parseOr(tokens, pos);
+    if (pos == tokens.size() || tokens[pos] != ")") {
+      throw parseError("missing ')'");
+    }
+    ++pos;
+    return;
+  }
+  parseTest(tokens, pos);
+}
+
+void FindProgram::parseTest(const std::vector<std::string>& tokens,
+                            size_t& pos) {
+  const auto& test = tokens[pos++];
+  if (test == "-true" || test == "-false") {
+    code_.push_back({.op = Op::kConstant, .value = test == "-true" ? 1 : 0});
+    return;
+  }
+
+  if (pos == tokens.size()) {
+    throw parseError("missing argument to '" + test + "'");
+  }
+  const std::string_view argument = tokens[pos++];
+
+  if (test == "-name") {
+    code_.push_back(
+        {.op = Op::kName, .index = static_cast<uint32_t>(globs_.size())});
+    globs_.emplace_back(argument);
+    return;
+  }
+
+  if (test == "-type") {
+    static constexpr std::string_view kLetters = "fdlbcps";
+    static constexpr unsigned char kTypes[] = {DT_REG, DT_DIR,  DT_LNK, DT_BLK,
+                                               DT_CHR, DT_FIFO, DT_SOCK};
+    const size_t letter = kLetters.find(argument);
+    if (argument.size() != 1 || letter == std::string_view::npos) {
+      throw parseError("unknown argument to -type: " + std::string(argument));
+    }
+    code_.push_back({.op = Op::kType, .type = kTypes[letter]});
+    return;
+  }
+
+  if (test == "-size" || test == "-mtime") {
+    Instruction instruction{.op = test == "-size" ? Op::kSize : Op::kMtime};
+    std::string_view number = argument;
+    if (number.starts_with('+')) {
+      instruction.compare = Compare::kGreater;
+      number.remove_prefix(1);
+    } else if (number.starts_with('-')) {
+      instruction.compare = Compare::kLess;
+      number.remove_prefix(1);
+    }
+
+    if (instruction.op == Op::kSize) {
+      instruction.unit = kDefaultSizeUnit;
+      static constexpr std::string_view kSuffixes = "cwbkMG";
+      static constexpr int64_t kUnits[] = {1, 2, 512, 1 << 10, 1 << 20,
+                                           1 << 30};
+      const size_t suffix =
+          number.empty() ? std::string_view::npos
+                         : kSuffixes.find(number.back());
+      if (suffix != std::string_view::npos) {
+        instruction.unit = kUnits[suffix];
+        number.remove_suffix(1);
+      }
+    }
+
+    auto [end, ec] = std::from_chars(number.data(),
+                                     number.data() + number.size(),
+                                     instruction.value);
+    if (number.empty() || ec != std::errc{} ||
+        end != number.data() + number.size()) {
+      throw parseError("invalid argument '" + std::string(argument) +
+                       "' to " + test);
+    }
+    code_.push_back(instruction);
+    return;
+  }
+
+  throw parseError("unknown predicate '" + test + "'");
+}
+
+bool FindProgram::matches(const WalkEntry& entry) const {
+  struct stat st {};
+  bool stat_done = false;
+  bool stat_ok = false;
+  auto lazy_stat = [&] {
+    if (!stat_done) {
+      stat_done = true;
+      stat_ok = fstatat(entry.dirfd, entry.name.data(), &st,
+                        AT_SYMLINK_NOFOLLOW) == 0;
+    }
+    return stat_ok;
+  };
+  auto compare = [](Compare how, int64_t actual, int64_t expected) {
+    switch (how) {
+      case Compare::kLess:
+        return actual < expected;
+      case Compare::kEqual:
+        return actual == expected;
+      case Compare::kGreater:
+        return actual > expected;
+    }
+    return false;
+  };
+
+  bool result = true;
+  for (size_t pc = 0; pc < code_.size();) {
+    const Instruction& instruction = code_[pc++];
+    switch (instruction.op) {
+      case Op::kName:
+        result = globs_[instruction.index].match(baseName(entry));
+        break;
+      case Op::kType:
+        result = entry.type == instruction.type;
+        break;
+      case Op::kSize:
+        result = lazy_stat() &&
+                 compare(instruction.compare,
+                         ceilDiv(st.st_size, instruction.unit),
+                         instruction.value);
+        break;
+      case Op::kMtime:
+        result = lazy_stat() &&
+                 compare(instruction.compare,
+                         floorDiv(now_ - st.st_mtime, kSecondsPerDay),
+                         instruction.value);
+        break;
+      case Op::kConstant:
+        result = instruction.value != 0;
+        break;
+      case Op::kNot:
+        result = !result;
+        break;
+      case Op::kJumpIfFalse:
+        if (!result) {
+          pc = instruction.index;
+        }
+        break;
+      case Op::kJumpIfTrue:
+        if (result) {
+          pc = instruction.index;
+        }
+        break;
+    }
+  }
+  return result;
+}
+
+}  // namespace coreutils
@@ -0,0 +1,170 @@
+#include <glob.hpp>
+
+namespace coreutils {
+
+namespace {
+
+size_t segmentLength(size_t begin, size_t end) { return end - begin; }
+
+}  // namespace
+
+GlobPattern::GlobPattern(std::string_view pattern) {
+  leading_dot_ = !pattern.empty() && pattern[0] == '.';
+
+  size_t segment_begin = 0;
+  auto close_segment = [&]() {
+    Segment segment{segment_begin, atoms_.size(), {}, true};
+    for (size_t i = segment.begin; i < segment.end; ++i) {
+      if (atoms_[i].kind != Atom::Kind::kChar) {
+        segment.is_literal = false;
+        segment.literal.clear();
+        break;
+      }
+      segment.literal.push_back(atoms_[i].ch);
+    }
+    segments_.push_back(std::move(segment));
+    segment_begin = atoms_.size();
+  };
+
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    char ch = pattern[i];
+    if (ch == '\\' && i + 1 < pattern.size()) {
+      atoms_.push_back({Atom::Kind::kChar, pattern[++i], 0});
+    } else if (ch == '*') {
+      has_wildcards_ = true;
+      close_segment();
+      while (i + 1 < pattern.size() && pattern[i + 1] == '*') {
+        ++i;
+      }
+    } else if (ch == '?') {
+      has_wildcards_ = true;
+      atoms_.push_back({Atom::Kind::kAny, 0, 0});
+    } else if (ch == '[') {
+      // Find the closing bracket; a ']' right after '[' or '[!' is literal.
+      size_t j = i + 1;
+      bool negate = false;
+      if (j < pattern.size() && (pattern[j] == '!' || pattern[j] == '^')) {
+        negate = true;
+        ++j;
+      }
+      size_t body = j;
+      if (j < pattern.size() && pattern[j] == ']') {
+        ++j;
+      }
+      while (j < pattern.size() && pattern[j] != ']') {
+        ++j;
+      }
+      if (j >= pattern.size()) {
+        atoms_.push_back({Atom::Kind::kChar, '[', 0});
+        continue;
+      }
+
+      std::bitset<256> set;
+      for (size_t k = body; k < j; ++k) {
+        auto lo = static_cast<unsigned char>(pattern[k]);
+        if (k + 2 < j && pattern[k + 1] == '-') {
+          auto hi = static_cast<unsigned char>(pattern[k + 2]);
+          for (unsigned c = lo; c <= hi; ++c) {
+            set.set(c);
+          }
+          k += 2;
+        } else {
+          set.set(lo);
+        }
+      }
+      if (negate) {
+        set.flip();
+      }
+
+      has_wildcards_ = true;
+      atoms_.push_back({Atom::Kind::kClass, 0,
+                        static_cast<uint32_t>(classes_.size())});
+      classes_.push_back(set);
+      i = j;
+    } else {
+      atoms_.push_back({Atom::Kind::kChar, ch, 0});
+    }
+  }
+  close_segment();
+}
+
+bool GlobPattern::atomMatches(const Atom& atom, char ch) const {
+  switch (atom.kind) {
+    case Atom::Kind::kChar:
+      return atom.ch == ch;
+    case Atom::Kind::kAny:
+      return true;
+    case Atom::Kind::kClass:
+      return classes_[atom.class_index].test(static_cast<unsigned char>(ch));
+  }
+  return false;
+}
+
+bool GlobPattern::segmentMatchesAt(const Segment& segment,
+                                   std::string_view text, size_t pos) const {
+  if (segmentLength(segment.begin, segment.end) > text.size() - pos) {
+    return false;
+  }
+  if (segment.is_literal) {
+    return text.compare(pos, segment.literal.size(), segment.literal) == 0;
+  }
+  for (size_t i = segment.begin; i < segment.end; ++i, ++pos) {
+    if (!atomMatches(atoms_[i], text[pos])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t GlobPattern::findSegment(const Segment& segment, std::string_view text,
+                                size_t from) const {
+  if (segment.is_literal) {
+    return text.find(segment.literal, from);
+  }
+  const size_t length = segmentLength(segment.begin, segment.end);
+  for (size_t pos = from; pos + length <= text.size(); ++pos) {
+    if (segmentMatchesAt(segment, text, pos)) {
+      return pos;
+    }
+  }
+  return std::string_view::npos;
+}
+
+bool GlobPattern::match(std::string_view text) const {
+  const auto& first = segments_.front();
+  const size_t first_length = segmentLength(first.begin, first.end);
+
+  // No '*' at all: the single segment has to cover the whole text.
+  if (segments_.size() == 1) {
+    return first_length == text.size() && segmentMatchesAt(first, text, 0);
+  }
+
+  if (!segmentMatchesAt(first, text, 0)) {
+    return false;
+  }
+
+  const auto& last = segments_.back();
+  const size_t last_length = segmentLength(last.begin, last.end);
+  if (first_length + last_length > text.size()) {
+    return false;
+  }
+  const size_t tail = text.size() - last_length;
+  if (!segmentMatchesAt(last, text, tail)) {
+    return false;
+  }
+
+  // Middle segments must fit, in order, between the anchored ends.
+  size_t pos = first_length;
+  std::string_view middle = text.substr(0, tail);
+  for (size_t i = 1; i + 1 < segments_.size(); ++i) {
+    const auto& segment = segments_[i];
+    size_t found = findSegment(segment, middle, pos);
+    if (found == std::string_view::npos) {
+      return false;
+    }
+    pos = found + segmentLength(segment.begin, segment.end);
+  }
+  return true;
+}
+
+}  // namespace coreutils
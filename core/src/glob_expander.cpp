@@ -0,0 +1,150 @@
+#include <glob_expander.hpp>
+
+#include <glob.hpp>
+#include <string_sort.hpp>
+#include <unique_fd.hpp>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <cstring>
+#include <span>
+#include <system_error>
+
+namespace coreutils {
+
+namespace {
+
+std::string unescape(std::string_view component) {
+  std::string result;
+  result.reserve(component.size());
+  for (size_t i = 0; i < component.size(); ++i) {
+    if (component[i] == '\\' && i + 1 < component.size()) {
+      ++i;
+    }
+    result.push_back(component[i]);
+  }
+  return result;
+}
+
+bool isDirectory(const std::string& path, unsigned char type) {
+  if (type == DT_DIR) {
+    return true;
+  }
+  if (type != DT_LNK && type != DT_UNKNOWN) {
+    return false;
+  }
+  struct stat st {};
+  return ::stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool exists(const std::string& path) {
+  struct stat st {};
+  return ::lstat(path.c_str(), &st) == 0;
+}
+
+std::string_view concat(Arena& arena, std::string_view prefix,
+                        std::string_view name) {
+  char* data = arena.allocate(prefix.size() + name.size());
+  std::memcpy(data, prefix.data(), prefix.size());
+  std::memcpy(data + prefix.size(), name.data(), name.size());
+  return {data, prefix.size() + name.size()};
+}
+
+}  // namespace
+
+const GlobExpander::Directory* GlobExpander::list(const std::string& path) {
+  auto [it, inserted] = directories_.try_emplace(path);
+  if (inserted) {
+    UniqueFd fd(::open(path.empty() ? "." : path.c_str(),
+                       O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (fd) {
+      try {
+        DirListing listing(fd.get());
+        auto order = listing.sortedByName();
+        it->second.emplace(Directory{std::move(listing), std::move(order)});
+      } catch (const std::system_error&) {
+        // Unreadable directories match nothing, like in other shells.
+      }
+    }
+  }
+  return it->second ? &*it->second : nullptr;
+}
+
+bool GlobExpander::expand(std::string_view pattern, Arena& arena,
+                          std::vector<std::string_view>& out) {
+  const size_t first = out.size();
+  prefixes_.assign(1, pattern.starts_with('/') ? "/" : "");
+  size_t pos = pattern.find_first_not_of('/');
+  bool matched_last = false;
+  size_t searched_directories = 0;
+
+  while (pos < pattern.size() && !prefixes_.empty()) {
+    const size_t end = std::min(pattern.find('/', pos), pattern.size());
+    const std::string_view component = pattern.substr(pos, end - pos);
+    const bool last = end == pattern.size();
+    pos = pattern.find_first_not_of('/', end);
+
+    const GlobPattern glob(component);
+    if (!glob.hasWildcards()) {
+      const std::string literal = unescape(component);
+      for (auto& prefix : prefixes_) {
+        prefix.append(literal);
+        if (!last) {
+          prefix.push_back('/');
+        }
+      }
+      continue;
+    }
+
+    next_prefixes_.clear();
+    searched_directories = prefixes_.size();
+    for (const auto& prefix : prefixes_) {
+      const Directory* directory = list(prefix);
+      if (directory == nullptr) {
+        continue;
+      }
+      for (const size_t index : directory->order) {
+        const std::string_view name = directory->listing.name(index);
+        if ((name.front() == '.' && !glob.matchesLeadingDot()) ||
+            !glob.match(name)) {
+          continue;
+        }
+        if (last) {
+          out.push_back(concat(arena, prefix, name));
+          continue;
+        }
+        std::string path = prefix;
+        path.append(name);
+        if (isDirectory(path, directory->listing.type(index))) {
+          path.push_back('/');
+          next_prefixes_.push_back(std::move(path));
+        }
+      }
+    }
+    prefixes_.swap(next_prefixes_);
+    matched_last = last;
+  }
+
+  // A pattern ending in literal components, or in '/', only names paths
+  // that exist.
+  if (!matched_last) {
+    searched_directories = prefixes_.size();
+    for (const auto& prefix : prefixes_) {
+      if (exists(prefix)) {
+        out.push_back(arena.copy(prefix));
+      }
+    }
+  }
+
+  // Entries come out sorted per directory; paths through several
+  // directories need a merge into global byte order.
+  const std::span<std::string_view> matches(out.begin() + first, out.end());
+  if (searched_directories > 1) {
+    radixSort(matches, [](std::string_view path) { return path; });
+  }
+  return !matches.empty();
+}
+
+}  // namespace coreutils
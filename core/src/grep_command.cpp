@@ -1,49 +1,60 @@
 #include <grep_command.hpp>
 
+#include <builtin_registry.hpp>
+#include <dir_walker.hpp>
+#include <mapped_file.hpp>
+#include <parallel.hpp>
+#include <text_kernels.hpp>
+
 #include <CLI11.hpp>
 
+#include <dirent.h>
+
 #include <algorithm>
-#include <fstream>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstring>
 #include <iostream>
-#include <set>
-#include <sstream>
+#include <limits>
+#include <mutex>
 #include <string>
+#include <system_error>
 #include <vector>
 
 namespace coreutils {
 
 namespace {
 
-constexpr size_t kBufferSize = 4096;
+constexpr size_t kReadSize = 64 * 1024;
+// A NUL byte in the first block marks a file as binary, like GNU grep does.
+constexpr size_t kBinaryProbeSize = 32 * 1024;
+constexpr std::string_view kRegexMetachars = "\\^$.|?*+()[]{}\n";
+
+size_t lineEnd(std::string_view content, size_t pos) {
+  const void* found =
+      std::memchr(content.data() + pos, '\n', content.size() - pos);
+  return found == nullptr
+             ? content.size()
+             : static_cast<const char*>(found) - content.data();
+}
 
-std::vector<std::string> splitIntoLines(const std::string& text) {
-  std::vector<std::string> lines;
-  std::istringstream stream(text);
-  std::string line;
-  while (std::getline(stream, line)) {
-    lines.push_back(line);
-  }
-  return lines;
+bool looksBinary(std::string_view content) {
+  const size_t probe = std::min(content.size(), kBinaryProbeSize);
+  return std::memchr(content.data(), '\0', probe) != nullptr;
 }
 
-std::string readAllFromInput(Input& in) {
-  std::string result;
-  auto buffer = in.readVector(kBufferSize);
-  while (!buffer.empty()) {
-    result.append(buffer.begin(), buffer.end());
-    buffer = in.readVector(kBufferSize);
-  }
-  return result;
+void appendNumber(std::string& out, size_t value, char separator) {
+  std::array<char, std::numeric_limits<size_t>::digits10 + 1> digits{};
+  auto [end, ec] =
+      std::to_chars(digits.data(), digits.data() + digits.size(), value);
+  out.append(digits.data(), end);
+  out.push_back(separator);
 }
 
-std::string readAllFromFile(const std::string& filename) {
-  std::ifstream stream(filename, std::ios::binary);
-  if (!stream.is_open()) {
-    throw std::runtime_error("Unable to open file: " + filename);
-  }
-  std::ostringstream content;
-  content << stream.rdbuf();
-  return content.str();
+bool matchesAny(const std::vector<GlobPattern>& globs, std::string_view name) {
+  return std::ranges::any_of(
+      globs, [name](const GlobPattern& glob) { return glob.match(name); });
 }
 
 }  // namespace
@@ -53,6 +64,10 @@ GrepCommand::GrepCommand(std::vector<std::string> args) { parseArgs(std::move(ar
 void GrepCommand::parseArgs(std::vector<std::string> args) {
   CLI::App app{"grep - search for patterns in files"};
 
+  std::vector<std::string> include_globs;
+  std::vector<std::string> exclude_globs;
+  std::vector<std::string> exclude_dir_globs;
+
   app.add_flag("-i,--ignore-case", case_insensitive_,
                "Ignore case distinctions in patterns and data");
   app.add_flag("-w,--word-regexp", whole_word_,
@@ -61,6 +76,21 @@ void GrepCommand::parseArgs(std::vector<std::string> args) {
                  "Print NUM lines of trailing context after matching lines")
       ->default_val(0)
       ->check(CLI::NonNegativeNumber);
+  app.add_flag("-n,--line-number", line_numbers_,
+               "Prefix each output line with its 1-based line number");
+  app.add_flag("-b,--byte-offset", byte_offsets_,
+               "Prefix each output line with the 0-based byte offset of the line");
+  app.add_flag("-r,--recursive", recursive_,
+               "Read all files under each directory, recursively");
+  app.add_option("--include", include_globs,
+                 "Search only files whose base name matches GLOB")
+      ->allow_extra_args(false);
+  app.add_option("--exclude", exclude_globs,
+                 "Skip files whose base name matches GLOB")
+      ->allow_extra_args(false);
+  app.add_option("--exclude-dir", exclude_dir_globs,
+                 "Skip directories whose base name matches GLOB")
+      ->allow_extra_args(false);
 
   app.add_option("pattern", pattern_, "The pattern to search for")->required();
 
@@ -83,6 +113,21 @@ void GrepCommand::parseArgs(std::vector<std::string> args) {
   } catch (const CLI::ParseError& e) {
     throw std::invalid_argument(app.help());
   }
+
+  for (const auto& glob : include_globs) {
+    include_globs_.emplace_back(glob);
+  }
+  for (const auto& glob : exclude_globs) {
+    exclude_globs_.emplace_back(glob);
+  }
+  for (const auto& glob : exclude_dir_globs) {
+    exclude_dir_globs_.emplace_back(glob);
+  }
+
+  if (!case_insensitive_ && !pattern_.empty() &&
+      pattern_.find_first_of(kRegexMetachars) == std::string::npos) {
+    literal_ = pattern_;
+  }
 }
 
 std::regex GrepCommand::buildRegex() const {
@@ -99,91 +144,291 @@ std::regex GrepCommand::buildRegex() const {
   return std::regex(regex_pattern, flags);
 }
 
-bool GrepCommand::matchesLine(const std::string& line,
+bool GrepCommand::matchesLine(std::string_view line,
                               const std::regex& regex) const {
-  return std::regex_search(line, regex);
+  return std::regex_search(line.begin(), line.end(), regex);
 }
 
-void GrepCommand::outputMatchingLines(const std::vector<std::string>& lines,
-                                       const std::regex& regex, Output& out,
-                                       const std::string& filename) const {
-  std::set<size_t> lines_to_print;
-  for (size_t i = 0; i < lines.size(); ++i) {
-    if (matchesLine(lines[i], regex)) {
-      lines_to_print.insert(i);
-      for (int j = 1; j <= after_context_ && (i + j) < lines.size(); ++j) {
-        lines_to_print.insert(i + j);
+bool GrepCommand::findMatchingLine(std::string_view content, size_t from,
+                                   const std::regex& regex, size_t& line_begin,
+                                   size_t& line_end) const {
+  if (!literal_) {
+    for (size_t pos = from; pos < content.size(); pos = line_end + 1) {
+      line_end = lineEnd(content, pos);
+      if (matchesLine(content.substr(pos, line_end - pos), regex)) {
+        line_begin = pos;
+        return true;
       }
     }
+    return false;
   }
 
-  size_t last_printed = static_cast<size_t>(-1);
-  bool need_separator = false;
-
-  for (size_t idx : lines_to_print) {
-    if (last_printed != static_cast<size_t>(-1) && idx > last_printed + 1) {
-      if (need_separator && after_context_ > 0) {
-        out.write("--\n");
-      }
+  // Jump straight to the next occurrence of the literal and widen it to
+  // its line; only -w still needs the regex to confirm word boundaries.
+  for (size_t pos = from; pos < content.size();) {
+    const void* hit = memmem(content.data() + pos, content.size() - pos,
+                             literal_->data(), literal_->size());
+    if (hit == nullptr) {
+      return false;
+    }
+    const size_t hit_pos = static_cast<const char*>(hit) - content.data();
+    const size_t newline = content.rfind('\n', hit_pos);
+    line_begin =
+        (newline == std::string_view::npos || newline < pos) ? pos : newline + 1;
+    line_end = lineEnd(content, hit_pos);
+    if (!whole_word_ ||
+        matchesLine(content.substr(line_begin, line_end - line_begin), regex)) {
+      return true;
     }
+    pos = line_end + 1;
+  }
+  return false;
+}
 
-    std::string output_line;
+void GrepCommand::scanBuffer(std::string_view content, const std::regex& regex,
+                             std::string_view filename, std::string& result,
+                             ScanState& state) const {
+  // Line numbers are only materialized for printed lines: the newlines
+  // skipped since the previous printed line are counted in one bulk pass.
+  size_t counted_pos = 0;
+
+  // Like GNU grep, matching lines use ':' after each prefix field and
+  // context lines use '-'.
+  auto emit = [&](size_t begin, size_t end, char separator) {
     if (!filename.empty()) {
-      output_line = filename + ":" + lines[idx] + "\n";
+      result.append(filename);
+      result.push_back(separator);
+    }
+    if (line_numbers_) {
+      state.line_number +=
+          countNewlines(content.substr(counted_pos, begin - counted_pos));
+      counted_pos = begin;
+      appendNumber(result, state.line_number, separator);
+    }
+    if (byte_offsets_) {
+      appendNumber(result, state.offset + begin, separator);
+    }
+    result.append(content.substr(begin, end - begin));
+    result.push_back('\n');
+  };
+
+  size_t pos = 0;
+  while (pos < content.size()) {
+    size_t line_begin = pos;
+    size_t line_end = 0;
+    char separator = ':';
+
+    if (state.context_left > 0) {
+      line_end = lineEnd(content, pos);
+      if (matchesLine(content.substr(pos, line_end - pos), regex)) {
+        state.context_left = after_context_;
+      } else {
+        --state.context_left;
+        separator = '-';
+      }
     } else {
-      output_line = lines[idx] + "\n";
+      if (!findMatchingLine(content, pos, regex, line_begin, line_end)) {
+        break;
+      }
+      if (state.printed_any &&
+          state.offset + line_begin != state.printed_end &&
+          after_context_ > 0) {
+        result.append("--\n");
+      }
+      state.context_left = after_context_;
     }
-    out.write(output_line);
 
-    last_printed = idx;
-    need_separator = true;
+    emit(line_begin, line_end, separator);
+    state.printed_any = true;
+    state.printed_end = state.offset + line_end + 1;
+    pos = line_end + 1;
+  }
+
+  if (line_numbers_) {
+    state.line_number += countNewlines(content.substr(counted_pos));
   }
+  state.offset += content.size();
 }
 
-int GrepCommand::processInput(Input& in, Output& out) {
-  try {
-    std::regex regex = buildRegex();
-    std::string content = readAllFromInput(in);
-    auto lines = splitIntoLines(content);
-    outputMatchingLines(lines, regex, out);
-    return 0;
-  } catch (const std::regex_error& e) {
-    std::cerr << "grep: Invalid regular expression: " << e.what() << '\n';
-    return 2;
+// Scans the input block by block, up to the last complete line of each,
+// so that matches reach the next stage of a pipeline as they are found
+// and a cancelled pipeline stops the scan.
+int GrepCommand::processInput(Input& in, Output& out, const std::regex& regex) {
+  ScanState state;
+  std::string content;
+  std::string result;
+  while (true) {
+    const size_t used = content.size();
+    content.resize(used + kReadSize);
+    const size_t size = in.read(content.data() + used, kReadSize);
+    content.resize(used + size);
+    if (size == 0) {
+      break;
+    }
+    // Whatever was carried over holds no newline, so only the new bytes
+    // are searched; a long line is not rescanned on every read.
+    const void* newline = memrchr(content.data() + used, '\n', size);
+    if (newline == nullptr) {
+      continue;
+    }
+    const size_t complete =
+        static_cast<const char*>(newline) - content.data() + 1;
+    scanBuffer(std::string_view(content).substr(0, complete), regex, "",
+               result, state);
+    content.erase(0, complete);
+    if (!result.empty()) {
+      out.write(result);
+      result.clear();
+    }
+  }
+
+  // A last line without a newline is still a line.
+  scanBuffer(content, regex, "", result, state);
+  out.write(result);
+  return 0;
+}
+
+int GrepCommand::processFiles(Output& out, const std::regex& regex) {
+  const bool with_filenames = files_.size() > 1;
+
+  struct FileResult {
+    std::string text;
+    bool done{false};
+    bool failed{false};
+  };
+  std::vector<FileResult> results(files_.size());
+  std::mutex mutex;
+  size_t next_to_write = 0;
+
+  // Files are scanned concurrently, but their output is flushed strictly in
+  // argument order as soon as every earlier file has finished.
+  parallelFor(files_.size(), workerCount(), [&](size_t index, size_t) {
+    FileResult result;
+    try {
+      MappedFile file(files_[index]);
+      ScanState state;
+      scanBuffer(file.view(), regex, with_filenames ? files_[index] : "",
+                 result.text, state);
+    } catch (const std::system_error& e) {
+      // One write per message, so those of concurrent workers stay whole.
+      std::cerr << ("grep: " + files_[index] + ": " + e.code().message() +
+                    '\n');
+      result.failed = true;
+    }
+    result.done = true;
+
+    std::lock_guard lock(mutex);
+    results[index] = std::move(result);
+    while (next_to_write < results.size() && results[next_to_write].done) {
+      out.write(results[next_to_write].text);
+      results[next_to_write].text = {};
+      ++next_to_write;
+    }
+  });
+
+  return std::ranges::any_of(results, &FileResult::failed) ? 2 : 0;
+}
+
+bool GrepCommand::isFileSelected(std::string_view name) const {
+  if (!include_globs_.empty() && !matchesAny(include_globs_, name)) {
+    return false;
   }
+  return !matchesAny(exclude_globs_, name);
+}
+
+bool GrepCommand::isDirectorySelected(std::string_view name) const {
+  return !matchesAny(exclude_dir_globs_, name);
 }
 
-int GrepCommand::processFile(const std::string& filename, Output& out) {
+int GrepCommand::processRecursive(Output& out, const std::regex& regex) {
+  // Without operands grep -r searches the working directory and prints
+  // paths relative to it.
+  const bool implicit_root = files_.empty();
+  const std::vector<std::string> roots =
+      implicit_root ? std::vector<std::string>{"."} : files_;
+  const bool single_operand = roots.size() == 1;
+
+  std::mutex out_mutex;
+  std::atomic<bool> failed{false};
+
+  // Called from the walking threads; see processFiles.
+  auto report_error = [&failed](std::string_view path, int error) {
+    std::cerr << ("grep: " + std::string(path) + ": " + std::strerror(error) +
+                  '\n');
+    failed.store(true, std::memory_order_relaxed);
+  };
+
+  auto visit = [&](const WalkEntry& entry) {
+    const bool is_root = entry.depth == 0;
+    if (entry.type == DT_DIR) {
+      return is_root || isDirectorySelected(entry.name) ? WalkAction::kContinue
+                                                        : WalkAction::kSkip;
+    }
+    if (entry.type != DT_REG && !is_root) {
+      return WalkAction::kContinue;
+    }
+    if (!is_root && !isFileSelected(entry.name)) {
+      return WalkAction::kContinue;
+    }
+
+    std::string result;
+    try {
+      MappedFile file(entry.dirfd, entry.name.data());
+      auto content = file.view();
+      if (looksBinary(content)) {
+        return WalkAction::kContinue;
+      }
+
+      std::string_view filename = entry.path;
+      if (implicit_root && filename.starts_with("./")) {
+        filename.remove_prefix(2);
+      }
+      if (is_root && single_operand) {
+        filename = {};
+      }
+      ScanState state;
+      scanBuffer(content, regex, filename, result, state);
+    } catch (const std::system_error& e) {
+      report_error(entry.path, e.code().value());
+      return WalkAction::kContinue;
+    }
+
+    if (!result.empty()) {
+      std::lock_guard lock(out_mutex);
+      out.write(result);
+    }
+    return WalkAction::kContinue;
+  };
+
+  DirWalker walker(workerCount());
+  walker.walk(roots, visit, report_error);
+  return failed ? 2 : 0;
+}
+
+int GrepCommand::run(Input& in, Output& out) {
+  std::regex regex;
   try {
-    std::string content = readAllFromFile(filename);
-    std::regex regex = buildRegex();
-    auto lines = splitIntoLines(content);
-    outputMatchingLines(lines, regex, out, files_.size() > 1 ? filename : "");
-    return 0;
+    regex = buildRegex();
   } catch (const std::regex_error& e) {
     std::cerr << "grep: Invalid regular expression: " << e.what() << '\n';
     return 2;
-  } catch (const std::runtime_error& e) {
-    std::cerr << "grep: " << filename << ": No such file or directory\n";
-    return 2;
   }
-}
 
-int GrepCommand::run(Input& in, Output& out) {
-  if (files_.empty()) {
-    return processInput(in, out);
+  if (recursive_) {
+    return processRecursive(out, regex);
   }
 
-  int exit_code = 0;
-  for (const auto& file : files_) {
-    int result = processFile(file, out);
-    if (result != 0) {
-      exit_code = result;
-    }
+  if (files_.empty()) {
+    return processInput(in, out, regex);
   }
 
-  return exit_code;
+  return processFiles(out, regex);
 }
 
-}  // namespace coreutils
+namespace {
 
+const BuiltinRegistrar kRegistrar{"grep", makeBuiltin<GrepCommand>};
+
+}  // namespace
+
+}  // namespace coreutils
@@ -0,0 +1,158 @@
+#include <head_command.hpp>
+
+#include <builtin_registry.hpp>
+#include <fd_io.hpp>
+#include <unique_fd.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+namespace coreutils {
+
+namespace {
+
+constexpr size_t kBlockSize = 64 * 1024;
+
+bool isDigit(char ch) { return ch >= '0' && ch <= '9'; }
+
+}  // namespace
+
+HeadCommand::HeadCommand(std::vector<std::string> args) {
+  for (size_t i = 0; i < args.size(); ++i) {
+    const std::string& arg = args[i];
+    if (arg.size() < 2 || arg[0] != '-') {
+      files_.push_back(arg);
+      continue;
+    }
+    // The traditional -N means -n N.
+    if (isDigit(arg[1])) {
+      bytes_ = false;
+      parseCount(std::string_view(arg).substr(1));
+      continue;
+    }
+    if (arg[1] != 'n' && arg[1] != 'c') {
+      throw std::invalid_argument("head: invalid option -- '" +
+                                  arg.substr(1, 1) + "'");
+    }
+    bytes_ = arg[1] == 'c';
+    // The value is the rest of the argument or the next argument.
+    std::string_view value = std::string_view(arg).substr(2);
+    if (value.empty()) {
+      if (i + 1 == args.size()) {
+        throw std::invalid_argument(
+            "head: option requires an argument -- '" + arg.substr(1, 1) +
+            "'");
+      }
+      value = args[++i];
+    }
+    parseCount(value);
+  }
+}
+
+void HeadCommand::parseCount(std::string_view value) {
+  auto [end, ec] =
+      std::from_chars(value.data(), value.data() + value.size(), count_);
+  if (value.empty() || ec != std::errc{} ||
+      end != value.data() + value.size()) {
+    throw std::invalid_argument(
+        std::string("head: invalid number of ") +
+        (bytes_ ? "bytes" : "lines") + ": '" + std::string(value) + "'");
+  }
+}
+
+// Reads no further than the block holding the last wanted byte; with -c
+// not even that.
+void HeadCommand::copyHead(int fd, const Output& out) const {
+  std::vector<char> block(kBlockSize);
+  size_t left = count_;
+  while (left != 0) {
+    const size_t wanted = bytes_ ? std::min(left, block.size()) : block.size();
+    const size_t size = readFd(fd, block.data(), wanted);
+    if (size == 0) {
+      return;
+    }
+
+    size_t taken = size;
+    if (bytes_) {
+      left -= size;
+    } else {
+      const char* pos = block.data();
+      const char* end = block.data() + size;
+      while (left != 0 && pos != end) {
+        const void* newline = std::memchr(pos, '\n', end - pos);
+        if (newline == nullptr) {
+          pos = end;
+          break;
+        }
+        pos = static_cast<const char*>(newline) + 1;
+        --left;
+      }
+      taken = static_cast<size_t>(pos - block.data());
+    }
+    out.write(block.data(), taken);
+
+    if (taken != size) {
+      // Fails harmlessly on pipes and terminals.
+      lseek(fd, -static_cast<off_t>(size - taken), SEEK_CUR);
+    }
+  }
+}
+
+int HeadCommand::run(Input& in, Output& out) {
+  if (files_.empty()) {
+    try {
+      copyHead(in.fd(), out);
+    } catch (const std::system_error& e) {
+      std::cerr << "head: error reading: " << e.code().message() << '\n';
+      return 1;
+    }
+    return 0;
+  }
+
+  int exit_code = 0;
+  bool first = true;
+  for (const auto& file : files_) {
+    UniqueFd opened;
+    int fd = in.fd();
+    if (file != "-") {
+      opened = UniqueFd(open(file.c_str(), O_RDONLY | O_CLOEXEC));
+      if (!opened) {
+        std::cerr << "head: cannot open '" << file
+                  << "' for reading: " << std::strerror(errno) << '\n';
+        exit_code = 1;
+        continue;
+      }
+      fd = opened.get();
+    }
+
+    if (files_.size() > 1) {
+      out.write((first ? "==> " : "\n==> ") + file + " <==\n");
+    }
+    first = false;
+    try {
+      copyHead(fd, out);
+    } catch (const std::system_error& e) {
+      std::cerr << "head: error reading '" << file
+                << "': " << e.code().message() << '\n';
+      exit_code = 1;
+    }
+  }
+  return exit_code;
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{"head", makeBuiltin<HeadCommand>};
+
+}  // namespace
+
+}  // namespace coreutils
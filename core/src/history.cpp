@@ -0,0 +1,256 @@
+#include <history.hpp>
+
+#include <text_kernels.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <system_error>
+
+namespace coreutils {
+
+namespace {
+
+size_t hashOf(std::string_view line) {
+  return std::hash<std::string_view>{}(line);
+}
+
+// One bit per trigram: a line can only contain a text if its signature has
+// every bit of the text's signature. Texts shorter than three characters
+// have an empty signature and match every line.
+uint64_t signatureOf(std::string_view text) {
+  uint64_t signature = 0;
+  for (size_t i = 2; i < text.size(); ++i) {
+    const uint32_t trigram =
+        static_cast<unsigned char>(text[i - 2]) |
+        static_cast<unsigned char>(text[i - 1]) << 8 |
+        static_cast<uint32_t>(static_cast<unsigned char>(text[i])) << 16;
+    signature |= uint64_t{1} << ((trigram * 0x9E3779B1u) >> 26);
+  }
+  return signature;
+}
+
+bool contains(std::string_view line, std::string_view text) {
+  return memmem(line.data(), line.size(), text.data(), text.size()) !=
+         nullptr;
+}
+
+bool isBlank(std::string_view line) {
+  return std::ranges::all_of(line, [](char ch) {
+    return std::isspace(static_cast<unsigned char>(ch)) != 0;
+  });
+}
+
+}  // namespace
+
+void History::open(const std::string& path) {
+  UniqueFd fd(::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC,
+                     0600));
+  if (!fd) {
+    throw std::system_error(errno, std::generic_category(), path);
+  }
+  fd_ = std::move(fd);
+  path_ = path;
+}
+
+void History::add(std::string_view line) {
+  if (isBlank(line) || line == last_) {
+    return;
+  }
+  last_ = line;
+
+  if (isOpen()) {
+    // One write per line keeps appends of concurrent sessions whole. A
+    // failed write only loses history, so it is not reported.
+    std::string record(line);
+    record.push_back('\n');
+    [[maybe_unused]] auto written =
+        ::write(fd_.get(), record.data(), record.size());
+  }
+
+  // Until the file is loaded it is the only copy, and it will be indexed
+  // along with the rest of the file.
+  if (loaded_ || !isOpen()) {
+    loaded_ = true;
+    index(added_.copy(line));
+  }
+}
+
+std::vector<std::string_view> History::entries() {
+  load();
+  // Every distinct command has one slot, holding its latest line.
+  std::vector<bool> latest(lines_.size());
+  for (const Slot& slot : slots_) {
+    if (slot.id != kEmptySlot) {
+      latest[slot.id] = true;
+    }
+  }
+
+  std::vector<std::string_view> result;
+  result.reserve(distinct_);
+  for (size_t id = 0; id < lines_.size(); ++id) {
+    if (latest[id]) {
+      result.push_back(lines_[id]);
+    }
+  }
+  return result;
+}
+
+std::vector<std::string_view> History::search(std::string_view text,
+                                              size_t limit) {
+  load();
+  buildSignatures();
+
+  std::vector<const uint64_t*> bitmaps;
+  for (uint64_t wanted = signatureOf(text); wanted != 0;
+       wanted &= wanted - 1) {
+    bitmaps.push_back(signature_bits_[std::countr_zero(wanted)].data());
+  }
+
+  // Walks 64 lines at a time from the newest, keeping the lines whose
+  // signature has all the wanted bits.
+  std::vector<std::string_view> result;
+  for (size_t word = (lines_.size() + 63) / 64;
+       word-- > 0 && result.size() < limit;) {
+    uint64_t candidates = ~uint64_t{0};
+    for (const uint64_t* bitmap : bitmaps) {
+      candidates &= bitmap[word];
+    }
+    if (word == lines_.size() / 64) {
+      candidates &= (uint64_t{1} << (lines_.size() % 64)) - 1;
+    }
+
+    while (candidates != 0 && result.size() < limit) {
+      const int bit = 63 - std::countl_zero(candidates);
+      candidates &= ~(uint64_t{1} << bit);
+      const auto id = static_cast<uint32_t>(word * 64 + bit);
+      if (contains(lines_[id], text) && isLatest(id)) {
+        result.push_back(lines_[id]);
+      }
+    }
+  }
+  return result;
+}
+
+void History::load() {
+  if (loaded_) {
+    return;
+  }
+  loaded_ = true;
+
+  try {
+    file_.emplace(path_);
+  } catch (const std::system_error&) {
+    return;
+  }
+
+  std::string_view rest = file_->view();
+  reserve(countNewlines(rest) + 1);
+  while (!rest.empty()) {
+    const void* newline = std::memchr(rest.data(), '\n', rest.size());
+    const size_t size = newline == nullptr
+                            ? rest.size()
+                            : static_cast<const char*>(newline) - rest.data();
+    if (size != 0) {
+      index(rest.substr(0, size));
+    }
+    rest.remove_prefix(std::min(size + 1, rest.size()));
+  }
+}
+
+void History::index(std::string_view line) {
+  if (slots_.empty()) {
+    slots_.resize(kInitialSlots);
+  }
+
+  const auto id = static_cast<uint32_t>(lines_.size());
+  lines_.push_back(line);
+
+  const size_t hash = hashOf(line);
+  const auto tag = static_cast<uint32_t>(hash >> 32);
+  const size_t mask = slots_.size() - 1;
+  for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+    Slot& current = slots_[slot];
+    if (current.id == kEmptySlot) {
+      current = {id, tag};
+      break;
+    }
+    if (current.tag == tag && lines_[current.id] == line) {
+      current.id = id;
+      return;
+    }
+  }
+
+  if (++distinct_ * 2 > slots_.size()) {
+    rehash(slots_.size() * 2);
+  }
+}
+
+void History::buildSignatures() {
+  const size_t words = (lines_.size() + 63) / 64;
+  for (auto& bitmap : signature_bits_) {
+    bitmap.resize(words);
+  }
+
+  // Transposes 64 signatures at a time in a local block, so that each
+  // bitmap word is written once.
+  while (signed_ < lines_.size()) {
+    const size_t word = signed_ / 64;
+    const size_t end = std::min(lines_.size(), (word + 1) * 64);
+    uint64_t block[kSignatureBits] = {};
+    for (; signed_ < end; ++signed_) {
+      const uint64_t line_bit = uint64_t{1} << (signed_ % 64);
+      for (uint64_t signature = signatureOf(lines_[signed_]); signature != 0;
+           signature &= signature - 1) {
+        block[std::countr_zero(signature)] |= line_bit;
+      }
+    }
+    for (size_t bit = 0; bit < kSignatureBits; ++bit) {
+      signature_bits_[bit][word] |= block[bit];
+    }
+  }
+}
+
+bool History::isLatest(uint32_t id) const {
+  const std::string_view line = lines_[id];
+  const size_t hash = hashOf(line);
+  const auto tag = static_cast<uint32_t>(hash >> 32);
+  const size_t mask = slots_.size() - 1;
+  for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+    const Slot& current = slots_[slot];
+    if (current.tag == tag && lines_[current.id] == line) {
+      return current.id == id;
+    }
+  }
+}
+
+void History::reserve(size_t lines) {
+  lines_.reserve(lines);
+  if (slots_.size() < lines * 2) {
+    rehash(std::bit_ceil(lines * 2));
+  }
+}
+
+void History::rehash(size_t slot_count) {
+  std::vector<Slot> slots(slot_count);
+  const size_t mask = slot_count - 1;
+  for (const Slot& current : slots_) {
+    if (current.id == kEmptySlot) {
+      continue;
+    }
+    size_t slot = hashOf(lines_[current.id]) & mask;
+    while (slots[slot].id != kEmptySlot) {
+      slot = (slot + 1) & mask;
+    }
+    slots[slot] = current;
+  }
+  slots_ = std::move(slots);
+}
+
+}  // namespace coreutils
@@ -0,0 +1,78 @@
+#include <history_command.hpp>
+
+#include <builtin_registry.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+
+namespace coreutils {
+
+HistoryCommand::HistoryCommand(std::vector<std::string> args,
+                               History& history)
+    : history_(history) {
+  size_t i = 0;
+  if (i < args.size() && args[i] == "-s") {
+    if (i + 1 == args.size()) {
+      throw std::invalid_argument("history: -s: option requires an argument");
+    }
+    search_ = std::move(args[i + 1]);
+    i += 2;
+  }
+
+  if (i < args.size()) {
+    const std::string_view value = args[i];
+    auto [end, ec] =
+        std::from_chars(value.data(), value.data() + value.size(), limit_);
+    if (value.empty() || ec != std::errc{} ||
+        end != value.data() + value.size()) {
+      throw std::invalid_argument("history: " + args[i] +
+                                  ": numeric argument required");
+    }
+    ++i;
+  }
+
+  if (i < args.size()) {
+    throw std::invalid_argument("history: too many arguments");
+  }
+}
+
+int HistoryCommand::run(Input& /*in*/, Output& out) {
+  std::string result;
+  if (search_) {
+    for (auto line : history_.search(*search_, limit_)) {
+      result.append(line).push_back('\n');
+    }
+    out.write(result);
+    return 0;
+  }
+
+  const auto entries = history_.entries();
+  const size_t first = entries.size() - std::min(limit_, entries.size());
+  for (size_t i = first; i < entries.size(); ++i) {
+    std::array<char, 32> number{};
+    const int size =
+        std::snprintf(number.data(), number.size(), "%5zu  ", i + 1);
+    result.append(number.data(), size).append(entries[i]).push_back('\n');
+  }
+  out.write(result);
+  return 0;
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{
+    "history",
+    [](std::vector<std::string> args,
+       const BuiltinContext& context) -> std::unique_ptr<Command> {
+      return std::make_unique<HistoryCommand>(std::move(args),
+                                              context.history);
+    }};
+
+}  // namespace
+
+}  // namespace coreutils
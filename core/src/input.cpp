@@ -1,5 +1,7 @@
 #include <input.hpp>
 
+#include <cancellation.hpp>
+
 #include <array>
 #include <stdexcept>
 
@@ -8,6 +10,7 @@
 namespace coreutils {
 
 size_t Input::read(char* data, size_t size) const {
+  throwIfCancelled();
   auto res = ::read(fd(), data, size);
   if (res == -1) {
     throw std::runtime_error("Read failed");
@@ -0,0 +1,165 @@
+#include <line_counter.hpp>
+
+#include <fd_io.hpp>
+#include <mapped_file.hpp>
+#include <parallel.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <system_error>
+
+namespace coreutils {
+
+namespace {
+
+constexpr size_t kReadSize = 4 * 1024 * 1024;
+// Slices smaller than this are not worth a thread of their own.
+constexpr size_t kMinSliceBytes = 256 * 1024;
+
+// Splits whole lines of `text` across the worker tables. `base` is the
+// offset of `text` in the input, so positions order lines of all blocks.
+void countText(std::string_view text, uint64_t base,
+               std::vector<LineCounter>& tables) {
+  const size_t slices =
+      std::clamp<size_t>(text.size() / kMinSliceBytes, 1, tables.size());
+  std::vector<size_t> bounds(slices + 1, text.size());
+  bounds[0] = 0;
+  for (size_t i = 1; i < slices; ++i) {
+    // Each slice starts right after a newline.
+    const size_t newline =
+        text.find('\n', std::max(bounds[i - 1], text.size() * i / slices));
+    bounds[i] = newline == std::string_view::npos ? text.size() : newline + 1;
+  }
+
+  parallelFor(slices, tables.size(), [&](size_t slice, size_t worker) {
+    LineCounter& table = tables[worker];
+    size_t pos = bounds[slice];
+    const size_t end = bounds[slice + 1];
+    while (pos < end) {
+      const void* newline = std::memchr(text.data() + pos, '\n', end - pos);
+      const size_t line_end =
+          newline == nullptr ? end
+                             : static_cast<const char*>(newline) - text.data();
+      table.add(text.substr(pos, line_end - pos), base + pos);
+      pos = line_end + 1;
+    }
+  });
+}
+
+}  // namespace
+
+void LineCounter::add(std::string_view line, uint64_t position) {
+  ++findOrInsert(line, std::hash<std::string_view>{}(line), position).count;
+}
+
+void LineCounter::merge(const LineCounter& other) {
+  for (const Entry& entry : other.entries_) {
+    Entry& own = findOrInsert(entry.line, entry.hash, entry.first);
+    own.count += entry.count;
+    own.first = std::min(own.first, entry.first);
+  }
+}
+
+LineCounter::Entry& LineCounter::findOrInsert(std::string_view line,
+                                              size_t hash,
+                                              uint64_t position) {
+  if (slots_.empty()) {
+    slots_.assign(kInitialSlots, kEmptySlot);
+  }
+
+  const size_t mask = slots_.size() - 1;
+  size_t slot = hash & mask;
+  for (; slots_[slot] != kEmptySlot; slot = (slot + 1) & mask) {
+    Entry& entry = entries_[slots_[slot]];
+    if (entry.hash == hash && entry.line == line) {
+      return entry;
+    }
+  }
+
+  slots_[slot] = static_cast<uint32_t>(entries_.size());
+  entries_.push_back({arena_->copy(line), 0, position, hash});
+  if (entries_.size() * 2 > slots_.size()) {
+    rehash(slots_.size() * 2);
+  }
+  return entries_.back();
+}
+
+void LineCounter::rehash(size_t slot_count) {
+  slots_.assign(slot_count, kEmptySlot);
+  const size_t mask = slot_count - 1;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    size_t slot = entries_[i].hash & mask;
+    while (slots_[slot] != kEmptySlot) {
+      slot = (slot + 1) & mask;
+    }
+    slots_[slot] = static_cast<uint32_t>(i);
+  }
+}
+
+bool countLines(const std::vector<std::string>& files, Input& in,
+                std::string_view name, LineCounter& result) {
+  std::vector<LineCounter> tables(workerCount());
+  uint64_t base = 0;
+  bool ok = true;
+
+  // Regular files are mapped and split at once; stdin and pipes go
+  // through a block buffer whose partial last line is carried over.
+  auto count_stream = [&](int fd) {
+    std::string text;
+    while (true) {
+      const size_t used = text.size();
+      text.resize(used + kReadSize);
+      const size_t size = readFd(fd, text.data() + used, kReadSize);
+      text.resize(used + size);
+      if (size == 0) {
+        countText(text, base, tables);
+        base += text.size();
+        return;
+      }
+      // The carried-over partial line holds no newline; only the new
+      // bytes are searched.
+      const void* newline = memrchr(text.data() + used, '\n', size);
+      if (newline != nullptr) {
+        const size_t complete =
+            static_cast<const char*>(newline) - text.data() + 1;
+        countText(std::string_view(text).substr(0, complete), base, tables);
+        base += complete;
+        text.erase(0, complete);
+      }
+    }
+  };
+
+  if (files.empty()) {
+    count_stream(in.fd());
+  }
+  for (const auto& file : files) {
+    try {
+      if (file == "-") {
+        count_stream(in.fd());
+        continue;
+      }
+      MappedFile mapping(file);
+      countText(mapping.view(), base, tables);
+      base += mapping.view().size();
+    } catch (const std::system_error& e) {
+      std::cerr << name << ": " << file << ": " << e.code().message() << '\n';
+      ok = false;
+    }
+  }
+
+  // Tables are merged into the largest one, which then moves the least.
+  auto largest = std::ranges::max_element(tables, {}, [](const auto& table) {
+    return table.entries().size();
+  });
+  result = std::move(*largest);
+  for (auto& table : tables) {
+    if (&table != &*largest) {
+      result.merge(table);
+    }
+  }
+  return ok;
+}
+
+}  // namespace coreutils
@@ -1,11 +1,35 @@
 #include <ls_command.hpp>
 
+#include <buffered_writer.hpp>
+#include <builtin_registry.hpp>
+#include <dir_listing.hpp>
+#include <parallel.hpp>
+#include <unique_fd.hpp>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <limits.h>
+#include <pwd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <filesystem>
 #include <iostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 namespace coreutils {
@@ -33,50 +57,520 @@ std::filesystem::path ExpandHome(const std::string& path) {
   return std::filesystem::path(path);
 }
 
-}  // namespace
+// Directories with at least this many entries are stat'ed on the worker
+// pool, kStatBlockSize entries per task.
+constexpr size_t kParallelStatThreshold = 1024;
+constexpr size_t kStatBlockSize = 256;
+// -l shows the time of day for files modified within the last half year
+// and the year for older ones, like GNU ls.
+constexpr int64_t kSixMonths = 31556952 / 2;
+constexpr size_t kLookupBufferSize = 16 * 1024;
 
-LsCommand::LsCommand(std::vector<std::string> args) {
-  if (args.size() > 1) {
-    throw std::invalid_argument("ls accepts at most one argument");
+// Metadata an invocation needs. Only these fields are requested from
+// statx(), and nothing is requested at all when d_type is enough.
+enum StatField : unsigned {
+  kStatType = 1U << 0,
+  kStatSize = 1U << 1,
+  kStatMtime = 1U << 2,
+  kStatLong = 1U << 3,  // everything printed by -l
+};
+
+struct EntryInfo {
+  mode_t mode{0};
+  nlink_t nlink{0};
+  uid_t uid{0};
+  gid_t gid{0};
+  uint64_t size{0};
+  uint64_t blocks{0};  // in 512-byte units
+  int64_t mtime_sec{0};
+  uint32_t mtime_nsec{0};
+  unsigned rdev_major{0};
+  unsigned rdev_minor{0};
+};
+
+// Does not follow symlinks. Returns 0 or an errno value.
+int statEntry(int dirfd, const char* name, unsigned fields, EntryInfo& info) {
+#ifdef STATX_BASIC_STATS
+  unsigned mask = STATX_TYPE;
+  if ((fields & kStatSize) != 0) {
+    mask |= STATX_SIZE;
+  }
+  if ((fields & kStatMtime) != 0) {
+    mask |= STATX_MTIME;
   }
+  if ((fields & kStatLong) != 0) {
+    mask |= STATX_MODE | STATX_NLINK | STATX_UID | STATX_GID | STATX_SIZE |
+            STATX_MTIME | STATX_BLOCKS;
+  }
+  struct statx stx {};
+  if (statx(dirfd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, mask, &stx) !=
+      0) {
+    return errno;
+  }
+  info.mode = stx.stx_mode;
+  info.nlink = stx.stx_nlink;
+  info.uid = stx.stx_uid;
+  info.gid = stx.stx_gid;
+  info.size = stx.stx_size;
+  info.blocks = stx.stx_blocks;
+  info.mtime_sec = stx.stx_mtime.tv_sec;
+  info.mtime_nsec = stx.stx_mtime.tv_nsec;
+  info.rdev_major = stx.stx_rdev_major;
+  info.rdev_minor = stx.stx_rdev_minor;
+#else
+  struct stat st {};
+  if (fstatat(dirfd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+    return errno;
+  }
+  info.mode = st.st_mode;
+  info.nlink = st.st_nlink;
+  info.uid = st.st_uid;
+  info.gid = st.st_gid;
+  info.size = static_cast<uint64_t>(st.st_size);
+  info.blocks = static_cast<uint64_t>(st.st_blocks);
+  info.mtime_sec = st.st_mtime;
+  info.rdev_major = major(st.st_rdev);
+  info.rdev_minor = minor(st.st_rdev);
+#endif
+  return 0;
+}
 
-  if (!args.empty()) {
-    target_ = std::move(args[0]);
+// Owner and group names, looked up once per id.
+class IdNameCache final {
+ public:
+  const std::string& user(uid_t uid) {
+    auto [it, inserted] = users_.try_emplace(uid);
+    if (inserted) {
+      std::vector<char> buffer(kLookupBufferSize);
+      struct passwd entry {};
+      struct passwd* result = nullptr;
+      getpwuid_r(uid, &entry, buffer.data(), buffer.size(), &result);
+      it->second = result != nullptr ? result->pw_name : std::to_string(uid);
+    }
+    return it->second;
   }
+
+  const std::string& group(gid_t gid) {
+    auto [it, inserted] = groups_.try_emplace(gid);
+    if (inserted) {
+      std::vector<char> buffer(kLookupBufferSize);
+      struct group entry {};
+      struct group* result = nullptr;
+      getgrgid_r(gid, &entry, buffer.data(), buffer.size(), &result);
+      it->second = result != nullptr ? result->gr_name : std::to_string(gid);
+    }
+    return it->second;
+  }
+
+ private:
+  std::unordered_map<uid_t, std::string> users_;
+  std::unordered_map<gid_t, std::string> groups_;
+};
+
+std::string_view formatNumber(uint64_t value, std::array<char, 24>& digits) {
+  auto [end, ec] =
+      std::to_chars(digits.data(), digits.data() + digits.size(), value);
+  return {digits.data(), static_cast<size_t>(end - digits.data())};
 }
 
-int LsCommand::run(Input&, Output& out) {
-  try {
-    std::filesystem::path target =
-        target_ ? ExpandHome(*target_) : std::filesystem::current_path();
+std::array<char, 10> modeString(mode_t mode) {
+  std::array<char, 10> result{};
+  if (S_ISDIR(mode)) {
+    result[0] = 'd';
+  } else if (S_ISLNK(mode)) {
+    result[0] = 'l';
+  } else if (S_ISCHR(mode)) {
+    result[0] = 'c';
+  } else if (S_ISBLK(mode)) {
+    result[0] = 'b';
+  } else if (S_ISFIFO(mode)) {
+    result[0] = 'p';
+  } else if (S_ISSOCK(mode)) {
+    result[0] = 's';
+  } else {
+    result[0] = '-';
+  }
 
-    if (!std::filesystem::exists(target)) {
-      std::cerr << "ls: cannot access '" << target.string()
-                << "': No such file or directory\n";
-      return 1;
+  constexpr std::string_view kRwx = "rwxrwxrwx";
+  for (size_t bit = 0; bit < kRwx.size(); ++bit) {
+    result[bit + 1] = (mode & (S_IRUSR >> bit)) != 0 ? kRwx[bit] : '-';
+  }
+  auto special = [&](size_t pos, mode_t flag, char executable, char plain) {
+    if ((mode & flag) != 0) {
+      result[pos] = result[pos] == 'x' ? executable : plain;
     }
+  };
+  special(3, S_ISUID, 's', 'S');
+  special(6, S_ISGID, 's', 'S');
+  special(9, S_ISVTX, 't', 'T');
+  return result;
+}
 
-    if (!std::filesystem::is_directory(target)) {
-      auto value = target.string();
-      value.push_back('\n');
-      out.write(value);
-      return 0;
+bool isDotOrDotDot(std::string_view name) {
+  return name == "." || name == "..";
+}
+
+std::string joinPath(const std::string& dir, std::string_view name) {
+  std::string path = dir;
+  if (path.empty() || path.back() != '/') {
+    path.push_back('/');
+  }
+  path.append(name);
+  return path;
+}
+
+// One line of -l output.
+struct LongRow {
+  std::string_view name;
+  const EntryInfo* info;
+};
+
+// Walks the operand and writes the listing; errors go to stderr and are
+// remembered for the exit code.
+class Lister final {
+ public:
+  Lister(const LsCommand::Options& options, BufferedWriter& writer)
+      : options_(options), writer_(writer) {
+    if (options.long_format) {
+      fields_ |= kStatLong;
+    }
+    if (options.sort_by_size) {
+      fields_ |= kStatSize;
+    }
+    if (options.sort_by_time) {
+      fields_ |= kStatMtime;
+    }
+    if (options.recursive) {
+      fields_ |= kStatType;
     }
+  }
+
+  [[nodiscard]] bool failed() const { return failed_; }
 
-    std::vector<std::string> entries;
-    for (const auto& entry : std::filesystem::directory_iterator(target)) {
-      entries.push_back(entry.path().filename().string());
+  void listOperand(const std::string& target) {
+    // -l describes a symlink operand itself instead of what it points to.
+    EntryInfo info;
+    if (options_.long_format &&
+        statEntry(AT_FDCWD, target.c_str(), fields_, info) == 0 &&
+        S_ISLNK(info.mode)) {
+      printLong(AT_FDCWD, {{target, &info}}, false);
+      return;
     }
-    std::sort(entries.begin(), entries.end());
 
-    for (auto& entry : entries) {
-      entry.push_back('\n');
-      out.write(entry);
+    UniqueFd dir(open(target.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (!dir) {
+      if (errno == ENOTDIR) {
+        printFile(target);
+      } else if (errno == ENOENT) {
+        std::cerr << "ls: cannot access '" << target
+                  << "': No such file or directory\n";
+        failed_ = true;
+      } else {
+        reportOpenError(target, errno);
+      }
+      return;
     }
+    listDirectory(dir.get(), target);
+  }
 
-    return 0;
-  } catch (const std::filesystem::filesystem_error& err) {
-    std::cerr << "ls: " << err.what() << '\n';
+ private:
+  void printFile(const std::string& path) {
+    if (!options_.long_format) {
+      writer_.write(path);
+      writer_.put('\n');
+      return;
+    }
+    EntryInfo info;
+    if (int error = statEntry(AT_FDCWD, path.c_str(), fields_, info);
+        error != 0) {
+      reportAccessError(path, error);
+      return;
+    }
+    printLong(AT_FDCWD, {{path, &info}}, false);
+  }
+
+  void printHeader(const std::string& path) {
+    if (!options_.recursive) {
+      return;
+    }
+    if (printed_header_) {
+      writer_.put('\n');
+    }
+    printed_header_ = true;
+    writer_.write(path);
+    writer_.write(":\n");
+  }
+
+  void listDirectory(int dirfd, const std::string& path) {
+    printHeader(path);
+
+    std::vector<std::string> subdirectories;
+    {
+      DirListing listing(dirfd, options_.all);
+      std::vector<size_t> order = listing.sortedByName();
+      if (!options_.all) {
+        std::erase_if(order, [&](size_t index) {
+          return listing.name(index).front() == '.';
+        });
+      }
+
+      std::vector<EntryInfo> infos;
+      if (fields_ != 0) {
+        infos.resize(listing.size());
+        statEntries(dirfd, path, listing, order, infos);
+      }
+
+      if (options_.sort_by_size) {
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+          return infos[a].size > infos[b].size;
+        });
+      } else if (options_.sort_by_time) {
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+          return std::tie(infos[a].mtime_sec, infos[a].mtime_nsec) >
+                 std::tie(infos[b].mtime_sec, infos[b].mtime_nsec);
+        });
+      }
+
+      if (options_.long_format) {
+        std::vector<LongRow> rows;
+        rows.reserve(order.size());
+        for (size_t index : order) {
+          rows.push_back({listing.name(index), &infos[index]});
+        }
+        printLong(dirfd, rows, true);
+      } else {
+        for (size_t index : order) {
+          writer_.write(listing.name(index));
+          writer_.put('\n');
+        }
+      }
+
+      if (options_.recursive) {
+        for (size_t index : order) {
+          const auto name = listing.name(index);
+          if (S_ISDIR(infos[index].mode) && !isDotOrDotDot(name)) {
+            subdirectories.emplace_back(name);
+          }
+        }
+      }
+    }
+
+    for (const auto& name : subdirectories) {
+      const auto child_path = joinPath(path, name);
+      UniqueFd child(openat(dirfd, name.c_str(),
+                            O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC));
+      if (!child) {
+        printHeader(child_path);
+        reportOpenError(child_path, errno);
+        continue;
+      }
+      listDirectory(child.get(), child_path);
+    }
+  }
+
+  // Fills infos[i] for every index in `order`; entries that cannot be
+  // stat'ed are reported and dropped from `order`.
+  void statEntries(int dirfd, const std::string& path,
+                   const DirListing& listing, std::vector<size_t>& order,
+                   std::vector<EntryInfo>& infos) const {
+    std::vector<int> errors(order.size());
+    auto stat_one = [&](size_t position) {
+      const size_t index = order[position];
+      const unsigned char type = listing.type(index);
+      if (fields_ == kStatType && type != DT_UNKNOWN) {
+        infos[index].mode = DTTOIF(type);
+        return;
+      }
+      errors[position] =
+          statEntry(dirfd, listing.name(index).data(), fields_, infos[index]);
+    };
+
+    if (order.size() >= kParallelStatThreshold) {
+      const size_t blocks =
+          (order.size() + kStatBlockSize - 1) / kStatBlockSize;
+      parallelFor(blocks, workerCount(), [&](size_t block, size_t) {
+        const size_t end = std::min(order.size(), (block + 1) * kStatBlockSize);
+        for (size_t position = block * kStatBlockSize; position < end;
+             ++position) {
+          stat_one(position);
+        }
+      });
+    } else {
+      for (size_t position = 0; position < order.size(); ++position) {
+        stat_one(position);
+      }
+    }
+
+    size_t kept = 0;
+    for (size_t position = 0; position < order.size(); ++position) {
+      if (errors[position] != 0) {
+        reportAccessError(joinPath(path, listing.name(order[position])),
+                          errors[position]);
+        continue;
+      }
+      order[kept++] = order[position];
+    }
+    order.resize(kept);
+  }
+
+  void printLong(int dirfd, const std::vector<LongRow>& rows,
+                 bool with_total) {
+    std::array<char, 24> digits{};
+    auto size_field = [&](const EntryInfo& info) -> std::string {
+      if (S_ISCHR(info.mode) || S_ISBLK(info.mode)) {
+        return std::to_string(info.rdev_major) + ", " +
+               std::to_string(info.rdev_minor);
+      }
+      return std::string(formatNumber(info.size, digits));
+    };
+
+    size_t nlink_width = 0;
+    size_t owner_width = 0;
+    size_t group_width = 0;
+    size_t size_width = 0;
+    uint64_t blocks = 0;
+    for (const auto& row : rows) {
+      nlink_width =
+          std::max(nlink_width, formatNumber(row.info->nlink, digits).size());
+      owner_width = std::max(owner_width, names_.user(row.info->uid).size());
+      group_width = std::max(group_width, names_.group(row.info->gid).size());
+      size_width = std::max(size_width, size_field(*row.info).size());
+      blocks += row.info->blocks;
+    }
+
+    if (with_total) {
+      writer_.write("total ");
+      writer_.write(formatNumber((blocks + 1) / 2, digits));
+      writer_.put('\n');
+    }
+
+    const auto now = static_cast<int64_t>(std::time(nullptr));
+    for (const auto& row : rows) {
+      const EntryInfo& info = *row.info;
+      const auto mode = modeString(info.mode);
+      writer_.write({mode.data(), mode.size()});
+      writer_.put(' ');
+      writePadded(formatNumber(info.nlink, digits), nlink_width, true);
+      writer_.put(' ');
+      writePadded(names_.user(info.uid), owner_width, false);
+      writer_.put(' ');
+      writePadded(names_.group(info.gid), group_width, false);
+      writer_.put(' ');
+      writePadded(size_field(info), size_width, true);
+      writer_.put(' ');
+      writeTime(info.mtime_sec, now);
+      writer_.put(' ');
+      writer_.write(row.name);
+      if (S_ISLNK(info.mode)) {
+        writeLinkTarget(dirfd, row.name);
+      }
+      writer_.put('\n');
+    }
+  }
+
+  void writePadded(std::string_view value, size_t width, bool right_align) {
+    if (right_align) {
+      for (size_t i = value.size(); i < width; ++i) {
+        writer_.put(' ');
+      }
+    }
+    writer_.write(value);
+    if (!right_align) {
+      for (size_t i = value.size(); i < width; ++i) {
+        writer_.put(' ');
+      }
+    }
+  }
+
+  void writeTime(int64_t seconds, int64_t now) {
+    const auto time = static_cast<time_t>(seconds);
+    tm local{};
+    localtime_r(&time, &local);
+    const bool recent = seconds <= now && now - seconds < kSixMonths;
+    std::array<char, 32> buffer{};
+    const size_t length =
+        std::strftime(buffer.data(), buffer.size(),
+                      recent ? "%b %e %H:%M" : "%b %e  %Y", &local);
+    writer_.write({buffer.data(), length});
+  }
+
+  void writeLinkTarget(int dirfd, std::string_view name) {
+    std::array<char, PATH_MAX> target{};
+    const auto length =
+        readlinkat(dirfd, std::string(name).c_str(), target.data(),
+                   target.size());
+    if (length >= 0) {
+      writer_.write(" -> ");
+      writer_.write({target.data(), static_cast<size_t>(length)});
+    }
+  }
+
+  void reportAccessError(const std::string& path, int error) const {
+    std::cerr << "ls: cannot access '" << path
+              << "': " << std::strerror(error) << '\n';
+    failed_ = true;
+  }
+
+  void reportOpenError(const std::string& path, int error) const {
+    std::cerr << "ls: cannot open directory '" << path
+              << "': " << std::strerror(error) << '\n';
+    failed_ = true;
+  }
+
+  const LsCommand::Options& options_;
+  BufferedWriter& writer_;
+  IdNameCache names_;
+  unsigned fields_{0};
+  bool printed_header_{false};
+  mutable bool failed_{false};
+};
+
+}  // namespace
+
+LsCommand::LsCommand(std::vector<std::string> args) {
+  for (auto& arg : args) {
+    if (arg.size() < 2 || arg[0] != '-') {
+      if (target_) {
+        throw std::invalid_argument("ls accepts at most one path");
+      }
+      target_ = std::move(arg);
+      continue;
+    }
+    for (char flag : std::string_view(arg).substr(1)) {
+      switch (flag) {
+        case 'l':
+          options_.long_format = true;
+          break;
+        case 'a':
+          options_.all = true;
+          break;
+        case 'S':
+          options_.sort_by_size = true;
+          break;
+        case 't':
+          options_.sort_by_time = true;
+          break;
+        case 'R':
+          options_.recursive = true;
+          break;
+        default:
+          throw std::invalid_argument("ls: invalid option -- '" +
+                                      std::string(1, flag) + "'");
+      }
+    }
+  }
+}
+
+int LsCommand::run(Input&, Output& out) {
+  try {
+    const std::string target =
+        target_ ? ExpandHome(*target_).string() : std::string(".");
+
+    BufferedWriter writer(out);
+    Lister lister(options_, writer);
+    lister.listOperand(target);
+    writer.flush();
+    return lister.failed() ? 1 : 0;
   } catch (const std::runtime_error& err) {
     std::cerr << "ls: " << err.what() << '\n';
   }
@@ -84,4 +578,10 @@ int LsCommand::run(Input&, Output& out) {
   return 1;
 }
 
+namespace {
+
+const BuiltinRegistrar kRegistrar{"ls", makeBuiltin<LsCommand>};
+
+}  // namespace
+
 }  // namespace coreutils
@@ -0,0 +1,65 @@
+#include <mapped_file.hpp>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <system_error>
+
+namespace coreutils {
+
+namespace {
+
+constexpr size_t kReadBlockSize = 64 * 1024;
+
+}  // namespace
+
+MappedFile::MappedFile(int dirfd, const char* path) {
+  fd_ = openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0) {
+    throw std::system_error(errno, std::generic_category(), path);
+  }
+
+  struct stat st {};
+  if (fstat(fd_, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    size_ = static_cast<size_t>(st.st_size);
+    void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (addr != MAP_FAILED) {
+      madvise(addr, size_, MADV_SEQUENTIAL);
+      data_ = static_cast<const char*>(addr);
+      mapped_ = true;
+      return;
+    }
+  }
+
+  size_t used = 0;
+  while (true) {
+    buffer_.resize(used + kReadBlockSize);
+    auto res = ::read(fd_, buffer_.data() + used, kReadBlockSize);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      int err = errno;
+      close(fd_);
+      throw std::system_error(err, std::generic_category(), path);
+    }
+    if (res == 0) {
+      break;
+    }
+    used += static_cast<size_t>(res);
+  }
+  buffer_.resize(used);
+  data_ = buffer_.data();
+  size_ = used;
+}
+
+MappedFile::~MappedFile() {
+  if (mapped_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+  close(fd_);
+}
+
+}  // namespace coreutils
@@ -1,5 +1,8 @@
 #include <output.hpp>
 
+#include <cancellation.hpp>
+
+#include <cerrno>
 #include <stdexcept>
 
 #include <unistd.h>
@@ -7,9 +10,13 @@
 namespace coreutils {
 
 void Output::write(const char* data, size_t size) const {
+  throwIfCancelled();
   size_t written = 0;
   while (written != size) {
     auto res = ::write(fd(), data + written, size - written);  // NOLINT
+    if (res == -1 && errno == EPIPE) {
+      throwBrokenPipe("write");
+    }
     if (res == -1) {
       throw std::runtime_error("Write failed");
     }
@@ -1,11 +1,11 @@
 #include <parser.hpp>
 
+#include <unistd.h>
+
 #include <algorithm>
 #include <cctype>
-#include <cstdlib>
 #include <string>
 #include <string_view>
-#include <unordered_map>
 #include <vector>
 
 namespace coreutils {
@@ -14,180 +14,329 @@ namespace {
 
 bool isValidVarNameChar(char ch) { return std::isalnum(ch) || ch == '_'; }
 
-bool isInvalidBeforeEquals(char ch) {
-  return std::isspace(ch) || ch == '"' || ch == '\'' || ch == '$' ||
-         ch == '&' || ch == '|';
+bool isSpace(char ch) {
+  return std::isspace(static_cast<unsigned char>(ch)) != 0;
 }
 
-void skipWhitespace(std::string_view str, size_t& pos) {
-  pos = str.find_first_not_of(" \t\n\r", pos);
-  if (pos == std::string_view::npos) {
-    pos = str.size();
+// Length of the operator starting at `pos`: "|" or "&&", 0 for none.
+size_t operatorLength(std::string_view input, size_t pos) {
+  if (input[pos] == '|') {
+    return 1;
   }
-}
-
-void pushToken(std::string& current_token, std::vector<std::string>& tokens) {
-  if (!current_token.empty()) {
-    tokens.push_back(std::move(current_token));
-    current_token.clear();
+  if (input[pos] == '&' && pos + 1 < input.size() && input[pos + 1] == '&') {
+    return 2;
   }
+  return 0;
 }
 
-bool handleOperators(std::string_view input, size_t& pos,
-                     std::string& current_token,
-                     std::vector<std::string>& tokens) {
-  char ch = input[pos];
-
-  if (ch == '&' && pos + 1 < input.size() && input[pos + 1] == '&') {
-    pushToken(current_token, tokens);
-    tokens.emplace_back("&&");
-    ++pos;
-    return true;
-  }
-
-  if (ch == '|') {
-    pushToken(current_token, tokens);
-    tokens.emplace_back("|");
-    return true;
-  }
-
-  return false;
+bool endsWord(std::string_view input, size_t pos) {
+  return pos == input.size() || isSpace(input[pos]) ||
+         operatorLength(input, pos) != 0;
 }
 
-std::string extractVariableName(std::string_view input, size_t& pos) {
-  if (pos >= input.size()) return "";
-
-  // Формат ${VAR}
-  if (input[pos] == '{') {
-    ++pos;
-    size_t end = input.find('}', pos);
+// Reads the name after a '$' at `pos - 1`: either ${NAME} or the longest
+// run of name characters, possibly empty. Leaves `pos` past the name.
+std::string_view readVariableName(std::string_view input, size_t& pos) {
+  if (pos < input.size() && input[pos] == '{') {
+    const size_t start = pos + 1;
+    size_t end = input.find('}', start);
     if (end == std::string_view::npos) {
       end = input.size();
     }
-    std::string var_name(input.substr(pos, end - pos));
-    pos = end;  // pos будет указывать на '}', цикл сам сделает ++pos
-    return var_name;
+    pos = std::min(end + 1, input.size());
+    return input.substr(start, end - start);
   }
 
-  // Формат $VAR
-  size_t start = pos;
+  const size_t start = pos;
   while (pos < input.size() && isValidVarNameChar(input[pos])) {
     ++pos;
   }
-  --pos;
-  return std::string(input.substr(start, pos - start + 1));
+  return input.substr(start, pos - start);
+}
+
+// Position of the ')' closing a "$(" that ends at `pos`, or the size of the
+// input when it is unterminated. Parentheses inside quotes do not count.
+size_t findSubstitutionEnd(std::string_view input, size_t pos) {
+  size_t depth = 1;
+  for (; pos < input.size(); ++pos) {
+    const char ch = input[pos];
+    if (ch == '\'' || ch == '"') {
+      pos = input.find(ch, pos + 1);
+      if (pos == std::string_view::npos) {
+        return input.size();
+      }
+    } else if (ch == '(') {
+      ++depth;
+    } else if (ch == ')' && --depth == 0) {
+      return pos;
+    }
+  }
+  return input.size();
+}
+
+// Reads the $(...) or `...` substitution starting at `pos` and returns its
+// command line; leaves `pos` past the closing character.
+std::string_view readSubstitution(std::string_view input, size_t& pos) {
+  size_t start = 0;
+  size_t end = 0;
+  if (input[pos] == '`') {
+    start = pos + 1;
+    end = std::min(input.find('`', start), input.size());
+  } else {
+    start = pos + 2;
+    end = findSubstitutionEnd(input, start);
+  }
+  pos = std::min(end + 1, input.size());
+  return input.substr(start, end - start);
+}
+
+bool startsSubstitution(std::string_view input, size_t pos) {
+  return input[pos] == '`' ||
+         (input[pos] == '$' && pos + 1 < input.size() && input[pos + 1] == '(');
 }
 
 }  // namespace
 
-bool Parser::tryParseAssignment(std::string_view input, size_t& pos) {
-  skipWhitespace(input, pos);
+Parser::Parser() { variables_.importEnvironment(environ); }
+
+bool Parser::tryParseAssignment(std::string_view input, size_t& pos,
+                                Arena& arena) {
+  pos = index_.nextNonSpace(pos);
   if (pos >= input.size()) return false;
 
-  size_t eq_pos = input.find('=', pos);
-  if (eq_pos == std::string_view::npos || eq_pos == pos) {
+  // Имя переменной не может содержать пробелы, кавычки, '$', '|' и '&', а
+  // все они отмечены в индексе, поэтому достаточно найти первый из них или
+  // '=' и проверить, что это '='
+  const size_t eq_pos = index_.nextBreakOrEquals(pos);
+  if (eq_pos == input.size() || input[eq_pos] != '=' || eq_pos == pos) {
     return false;
   }
 
-  // Проверяем корректность имени переменной
-  std::string_view var_name_part = input.substr(pos, eq_pos - pos);
-  if (std::ranges::any_of(var_name_part, isInvalidBeforeEquals)) {
-    return false;
-  }
+  std::string_view var_name = input.substr(pos, eq_pos - pos);
 
-  std::string var_name(var_name_part);
+  // Значение собирается как слово: кавычки снимаются, переменные и
+  // подстановки команд раскрываются, но без разбиения на слова и glob
+  std::vector<std::string_view> unused;
+  word_.clear();
+  pos = assembleWord(input, eq_pos + 1, unused, arena,
+                     /*split_fields=*/false);
+  variables_.set(var_name, word_.text);
+  word_.clear();
+  return true;
+}
+
+std::string_view Parser::lookupVariable(std::string_view name) const {
+  const std::string* value = variables_.find(name);
+  return value != nullptr ? std::string_view(*value) : std::string_view();
+}
 
-  // Извлекаем значение до пробела или конца строки
-  size_t value_start = eq_pos + 1;
-  size_t value_end = input.find_first_of(" \t\n\r", value_start);
-  if (value_end == std::string_view::npos) {
-    value_end = input.size();
+void Parser::Word::appendLiteral(std::string_view part) {
+  if (part.empty()) {
+    return;
   }
+  if (!literal.empty() && literal.back().second == text.size()) {
+    literal.back().second += part.size();
+  } else {
+    literal.emplace_back(text.size(), text.size() + part.size());
+  }
+  text.append(part);
+}
 
-  env_variables_[var_name] =
-      std::string(input.substr(value_start, value_end - value_start));
-  pos = value_end;
-  return true;
+void Parser::Word::appendPlain(std::string_view part, bool wildcards) {
+  text.append(part);
+  has_wildcards = has_wildcards || wildcards;
 }
 
-// Обработка символа '$' и раскрытие переменной
-void Parser::handleDollarSign(std::string_view input, size_t& pos,
-                              std::string& current_token) {
-  ++pos;
-  std::string var_name = extractVariableName(input, pos);
-  current_token += expandVariables(var_name, true);
+void Parser::Word::clear() {
+  text.clear();
+  literal.clear();
+  has_wildcards = false;
 }
 
-std::vector<std::string> Parser::parseToTokens(std::string&& raw_input) {
-  std::vector<std::string> tokens;
-  size_t pos = 0;
+// The word as a GlobPattern: wildcards that came from quotes or expansions
+// are escaped, and so are backslashes, which this shell does not treat as
+// an escape character.
+std::string Parser::Word::globPattern() const {
+  std::string pattern;
+  pattern.reserve(text.size());
+  size_t range = 0;
+  for (size_t i = 0; i < text.size(); ++i) {
+    while (range < literal.size() && literal[range].second <= i) {
+      ++range;
+    }
+    const bool quoted = range < literal.size() && literal[range].first <= i;
+    const char ch = text[i];
+    if (ch == '\\' || (quoted && (ch == '*' || ch == '?' || ch == '['))) {
+      pattern.push_back('\\');
+    }
+    pattern.push_back(ch);
+  }
+  return pattern;
+}
 
-  while (tryParseAssignment(raw_input, pos)) {
-    // Ждём пока находим присваивания
+std::string Parser::substitute(std::string_view command) {
+  if (!run_substitution_) {
+    return {};
   }
 
-  // Основной парсинг
-  std::string current_token;
-  bool in_single_quote = false;
-  bool in_double_quote = false;
+  // The runner tokenizes `command` with this parser, which reuses the
+  // index and the word buffer of the line being tokenized.
+  ShellCharIndex index = std::move(index_);
+  Word word = std::move(word_);
+  std::string output = run_substitution_(command);
+  index_ = std::move(index);
+  word_ = std::move(word);
 
-  for (; pos < raw_input.size(); ++pos) {
-    char ch = raw_input[pos];
+  while (!output.empty() && output.back() == '\n') {
+    output.pop_back();
+  }
+  return output;
+}
 
-    if (in_single_quote) {
-      if (ch == '\'') {
-        in_single_quote = false;
-      } else {
-        current_token += ch;
-      }
-      continue;
-    }
+// Moves the finished word to `tokens`, expanding it when it has unquoted
+// wildcards that match any path. Words that come out empty, such as '' or
+// an unset variable, vanish.
+void Parser::finishWord(std::vector<std::string_view>& tokens, Arena& arena) {
+  if (!word_.text.empty() &&
+      !(word_.has_wildcards &&
+        globber_.expand(word_.globPattern(), arena, tokens))) {
+    tokens.push_back(arena.copy(word_.text));
+  }
+  word_.clear();
+}
 
-    if (in_double_quote) {
-      if (ch == '"') {
-        in_double_quote = false;
-      } else if (ch == '$') {
-        handleDollarSign(raw_input, pos, current_token);
-      } else {
-        current_token += ch;
-      }
-      continue;
+// Appends unquoted substitution output to `word_`. Whitespace in it splits
+// words, so every completed word is moved to `tokens`.
+void Parser::appendFields(std::string_view text,
+                          std::vector<std::string_view>& tokens,
+                          Arena& arena) {
+  while (!text.empty()) {
+    const auto field_end = std::ranges::find_if(text, isSpace);
+    const size_t length = field_end - text.begin();
+    word_.appendLiteral(text.substr(0, length));
+    if (length == text.size()) {
+      break;
     }
+    finishWord(tokens, arena);
+    const auto next = std::find_if_not(field_end, text.end(), isSpace);
+    text.remove_prefix(next - text.begin());
+  }
+}
+
+// Appends the word starting at `pos` to `word_` with quotes removed and
+// variables and substitutions expanded; returns the position where the
+// word ends. With `split_fields`, unquoted substitutions may complete
+// words early, which go to `tokens`.
+size_t Parser::assembleWord(std::string_view input, size_t pos,
+                            std::vector<std::string_view>& tokens,
+                            Arena& arena, bool split_fields) {
+  while (!endsWord(input, pos)) {
+    const char ch = input[pos];
 
-    // Вне кавычек
     if (ch == '\'') {
-      in_single_quote = true;
+      // Everything up to the closing quote is literal; an unterminated
+      // quote runs to the end of the line.
+      size_t end = input.find('\'', pos + 1);
+      if (end == std::string_view::npos) {
+        end = input.size();
+      }
+      word_.appendLiteral(input.substr(pos + 1, end - pos - 1));
+      pos = std::min(end + 1, input.size());
     } else if (ch == '"') {
-      in_double_quote = true;
+      ++pos;
+      while (pos < input.size()) {
+        // Only the closing quote, '$' and '`' matter here; skip the other
+        // breaks.
+        size_t end = index_.nextBreak(pos);
+        while (end < input.size() && input[end] != '"' && input[end] != '$' &&
+               input[end] != '`') {
+          end = index_.nextBreak(end + 1);
+        }
+        word_.appendLiteral(input.substr(pos, end - pos));
+        pos = end;
+        if (pos == input.size()) {
+          break;
+        }
+        if (input[pos] == '"') {
+          ++pos;
+          break;
+        }
+        if (startsSubstitution(input, pos)) {
+          word_.appendLiteral(substitute(readSubstitution(input, pos)));
+        } else {
+          ++pos;
+          word_.appendLiteral(lookupVariable(readVariableName(input, pos)));
+        }
+      }
+    } else if (startsSubstitution(input, pos)) {
+      const std::string output = substitute(readSubstitution(input, pos));
+      if (split_fields) {
+        appendFields(output, tokens, arena);
+      } else {
+        word_.appendLiteral(output);
+      }
     } else if (ch == '$') {
-      handleDollarSign(raw_input, pos, current_token);
-    } else if (std::isspace(static_cast<unsigned char>(ch))) {
-      pushToken(current_token, tokens);
-    } else if (handleOperators(raw_input, pos, current_token, tokens)) {
-      // Оператор обработан
+      ++pos;
+      word_.appendLiteral(lookupVariable(readVariableName(input, pos)));
     } else {
-      current_token += ch;
+      // A run of plain characters; a lone '&' is an ordinary character.
+      const size_t end = std::max(index_.nextBreak(pos), pos + 1);
+      word_.appendPlain(input.substr(pos, end - pos),
+                        index_.hasWildcard(pos, end));
+      pos = end;
     }
   }
-
-  pushToken(current_token, tokens);
-  return tokens;
+  return pos;
 }
 
-std::string Parser::expandVariables(const std::string& str, bool expand) {
-  if (!expand) {
-    return str;
-  }
+std::vector<std::string_view> Parser::tokenize(std::string_view line,
+                                               Arena& arena) {
+  std::vector<std::string_view> tokens;
+  size_t pos = 0;
+  index_.build(line);
+  globber_.clear();
 
-  if (auto it = env_variables_.find(str); it != env_variables_.end()) {
-    return it->second;
+  while (tryParseAssignment(line, pos, arena)) {
+    // Ждём пока находим присваивания
   }
 
-  if (const char* env_value = std::getenv(str.c_str())) {
-    return env_value;
+  while (true) {
+    pos = index_.nextNonSpace(pos);
+    if (pos == line.size()) {
+      break;
+    }
+
+    if (const size_t length = operatorLength(line, pos); length != 0) {
+      tokens.push_back(line.substr(pos, length));
+      pos += length;
+      continue;
+    }
+
+    // Most words are plain text and are returned as a view into the line.
+    const size_t start = pos;
+    pos = index_.nextBreak(pos);
+    while (pos < line.size() && line[pos] == '&' && !endsWord(line, pos)) {
+      pos = index_.nextBreak(pos + 1);
+    }
+    const bool wildcards = index_.hasWildcard(start, pos);
+    if (endsWord(line, pos) && !wildcards) {
+      tokens.push_back(line.substr(start, pos - start));
+      continue;
+    }
+
+    word_.clear();
+    word_.appendPlain(line.substr(start, pos - start), wildcards);
+    pos = assembleWord(line, pos, tokens, arena);
+    finishWord(tokens, arena);
   }
 
-  return "";
+  return tokens;
+}
+
+std::vector<std::string> Parser::parseToTokens(std::string&& raw_input) {
+  Arena arena;
+  const auto views = tokenize(raw_input, arena);
+  return {views.begin(), views.end()};
 }
 
 }  // namespace coreutils
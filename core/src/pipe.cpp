@@ -2,7 +2,9 @@
 #include <pipe.hpp>
 
 #include <array>
+#include <stdexcept>
 
+#include <fcntl.h>
 #include <unistd.h>
 
 namespace coreutils {
@@ -44,8 +46,10 @@ class PipeOutput : public Output {
 }  // namespace
 
 std::pair<std::unique_ptr<Input>, std::unique_ptr<Output>> createPipe() {
+  // Close-on-exec, so that a child started by one stage does not hold the
+  // pipes of the others open.
   std::array<int, 2> fds{};
-  if (pipe(fds.data()) == -1) {
+  if (pipe2(fds.data(), O_CLOEXEC) == -1) {
     throw std::runtime_error("Pipe went wrong");
   }
 
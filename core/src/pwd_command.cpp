@@ -1,7 +1,12 @@
 #include <pwd_command.hpp>
 
+#include <builtin_registry.hpp>
+
 #include <filesystem>
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace coreutils {
 
@@ -12,4 +17,18 @@ int PwdCommand::run(Input& /*in*/, Output& out) {
   return 0;
 }
 
+namespace {
+
+const BuiltinRegistrar kRegistrar{
+    "pwd",
+    [](std::vector<std::string> args,
+       const BuiltinContext& /*context*/) -> std::unique_ptr<Command> {
+      if (!args.empty()) {
+        throw std::invalid_argument("pwd does not accept arguments");
+      }
+      return std::make_unique<PwdCommand>();
+    }};
+
+}  // namespace
+
 }  // namespace coreutils
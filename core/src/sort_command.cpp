@@ -0,0 +1,597 @@
+#include <sort_command.hpp>
+
+#include <buffered_writer.hpp>
+#include <builtin_registry.hpp>
+#include <fd_io.hpp>
+#include <parallel.hpp>
+#include <string_sort.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+namespace coreutils {
+
+namespace {
+
+constexpr size_t kReadSize = 64 * 1024;
+// Slices smaller than this are not worth a thread of their own.
+constexpr size_t kMinSliceLines = 16 * 1024;
+// Runs merged at once; more runs are merged in several passes.
+constexpr size_t kMergeWidth = 64;
+constexpr size_t kMergeBufferSize = 256 * 1024;
+
+bool isBlank(char ch) { return ch == ' ' || ch == '\t'; }
+
+int compareBytes(std::string_view lhs, std::string_view rhs) {
+  const int result = lhs.compare(rhs);
+  return (result > 0) - (result < 0);
+}
+
+// A number as -n reads it: leading blanks, an optional minus sign, digits
+// and an optional fraction. Anything else ends the number; no digits at
+// all reads as zero.
+struct Number {
+  bool negative{false};
+  std::string_view integer;   // without leading zeros
+  std::string_view fraction;  // without trailing zeros
+  // The integer digits as a value when they fit, which settles most
+  // comparisons without reading the text again.
+  uint64_t value{0};
+};
+
+constexpr size_t kMaxValueDigits = 19;
+
+Number parseNumber(std::string_view text) {
+  size_t pos = 0;
+  while (pos < text.size() && isBlank(text[pos])) {
+    ++pos;
+  }
+  Number number;
+  if (pos < text.size() && text[pos] == '-') {
+    number.negative = true;
+    ++pos;
+  }
+  while (pos < text.size() && text[pos] == '0') {
+    ++pos;
+  }
+  const size_t integer_begin = pos;
+  while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+    ++pos;
+  }
+  number.integer = text.substr(integer_begin, pos - integer_begin);
+  if (number.integer.size() <= kMaxValueDigits) {
+    for (char digit : number.integer) {
+      number.value = number.value * 10 + static_cast<uint64_t>(digit - '0');
+    }
+  }
+  if (pos < text.size() && text[pos] == '.') {
+    const size_t fraction_begin = ++pos;
+    while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+      ++pos;
+    }
+    number.fraction = text.substr(fraction_begin, pos - fraction_begin);
+    while (!number.fraction.empty() && number.fraction.back() == '0') {
+      number.fraction.remove_suffix(1);
+    }
+  }
+  if (number.integer.empty() && number.fraction.empty()) {
+    number.negative = false;  // -0 is 0
+  }
+  return number;
+}
+
+// Compares the decimal strings exactly, whatever their length.
+int compareNumbers(const Number& left, const Number& right) {
+  if (left.negative != right.negative) {
+    return left.negative ? -1 : 1;
+  }
+
+  int result = 0;
+  if (left.integer.size() != right.integer.size()) {
+    result = left.integer.size() < right.integer.size() ? -1 : 1;
+  } else if (left.integer.size() <= kMaxValueDigits) {
+    result = left.value != right.value ? (left.value < right.value ? -1 : 1)
+                                       : compareBytes(left.fraction,
+                                                      right.fraction);
+  } else if (int digits = compareBytes(left.integer, right.integer)) {
+    result = digits;
+  } else {
+    result = compareBytes(left.fraction, right.fraction);
+  }
+  return left.negative ? -result : result;
+}
+
+// Unique, already unlinked temporary file for a sorted run.
+UniqueFd createTempFile() {
+  const char* dir = std::getenv("TMPDIR");
+  std::string path = (dir != nullptr && *dir != '\0') ? dir : "/tmp";
+  path += "/sort-XXXXXX";
+  UniqueFd fd(mkostemp(path.data(), O_CLOEXEC));
+  if (!fd) {
+    throw std::system_error(errno, std::generic_category(),
+                            "cannot create temporary file");
+  }
+  unlink(path.c_str());
+  return fd;
+}
+
+class FdOutput final : public Output {
+ public:
+  explicit FdOutput(int fd) : fd_(fd) {}
+  [[nodiscard]] int fd() const override { return fd_; }
+
+ private:
+  int fd_;
+};
+
+// Reads the lines of a sorted run back in large blocks.
+class RunReader final {
+ public:
+  explicit RunReader(UniqueFd fd) : fd_(std::move(fd)) {
+    if (lseek(fd_.get(), 0, SEEK_SET) < 0) {
+      throw std::system_error(errno, std::generic_category(), "lseek");
+    }
+    buffer_.resize(kMergeBufferSize);
+  }
+
+  // The next line without its newline, valid until the next call.
+  [[nodiscard]] std::string_view line() const { return line_; }
+
+  // Advances to the next line; false at the end of the run.
+  bool next() {
+    while (true) {
+      const void* newline =
+          std::memchr(buffer_.data() + begin_, '\n', end_ - begin_);
+      if (newline != nullptr) {
+        const size_t size =
+            static_cast<const char*>(newline) - (buffer_.data() + begin_);
+        line_ = std::string_view(buffer_.data() + begin_, size);
+        begin_ += size + 1;
+        return true;
+      }
+      if (eof_) {
+        return false;
+      }
+
+      // Keeps the partial line and makes room after it, growing the
+      // buffer for lines longer than itself.
+      std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+      end_ -= begin_;
+      begin_ = 0;
+      if (end_ == buffer_.size()) {
+        buffer_.resize(buffer_.size() * 2);
+      }
+      const size_t size = readFd(fd_.get(), buffer_.data() + end_,
+                                 buffer_.size() - end_);
+      eof_ = size == 0;
+      end_ += size;
+    }
+  }
+
+ private:
+  UniqueFd fd_;
+  std::vector<char> buffer_;
+  size_t begin_{0};
+  size_t end_{0};
+  bool eof_{false};
+  std::string_view line_;
+};
+
+// Appends the lines of `text` to `lines`; a last line may lack its newline.
+void splitLines(std::string_view text, std::vector<std::string_view>& lines) {
+  while (!text.empty()) {
+    const void* newline = std::memchr(text.data(), '\n', text.size());
+    const size_t size = newline == nullptr
+                            ? text.size()
+                            : static_cast<const char*>(newline) - text.data();
+    lines.push_back(text.substr(0, size));
+    text.remove_prefix(std::min(size + 1, text.size()));
+  }
+}
+
+}  // namespace
+
+SortCommand::SortCommand(std::vector<std::string> args) {
+  for (size_t pos = 0; pos < args.size(); ++pos) {
+    const std::string_view arg = args[pos];
+    if (arg.size() < 2 || arg[0] != '-') {
+      files_.emplace_back(arg);
+      continue;
+    }
+    for (size_t i = 1; i < arg.size(); ++i) {
+      switch (arg[i]) {
+        case 'n':
+          numeric_ = true;
+          break;
+        case 'r':
+          reverse_ = true;
+          break;
+        case 'u':
+          unique_ = true;
+          break;
+        case 'k':
+        case 't':
+        case 'S': {
+          // The value is the rest of this argument or the next one.
+          const char option = arg[i];
+          std::string_view value = arg.substr(i + 1);
+          if (value.empty()) {
+            if (pos + 1 == args.size()) {
+              throw std::invalid_argument(
+                  std::string("sort: option requires an argument -- '") +
+                  option + "'");
+            }
+            value = args[++pos];
+          }
+          if (option == 'k') {
+            parseKey(value);
+          } else if (option == 'S') {
+            parseMemory(value);
+          } else if (value.size() != 1) {
+            throw std::invalid_argument("sort: multi-character tab '" +
+                                        std::string(value) + "'");
+          } else {
+            separator_ = value[0];
+          }
+          i = arg.size();
+          break;
+        }
+        default:
+          throw std::invalid_argument("sort: invalid option -- '" +
+                                      std::string(1, arg[i]) + "'");
+      }
+    }
+  }
+}
+
+void SortCommand::parseKey(std::string_view spec) {
+  auto field = [&spec](std::string_view text) {
+    size_t value = 0;
+    auto [end, ec] =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || ec != std::errc{} ||
+        end != text.data() + text.size() || value == 0) {
+      throw std::invalid_argument("sort: invalid field specification '" +
+                                  std::string(spec) + "'");
+    }
+    return value - 1;
+  };
+
+  const size_t comma = spec.find(',');
+  key_begin_ = field(spec.substr(0, comma));
+  key_end_ = comma == std::string_view::npos
+                 ? std::numeric_limits<size_t>::max()
+                 : field(spec.substr(comma + 1));
+  if (key_end_ < key_begin_) {
+    throw std::invalid_argument("sort: invalid field specification '" +
+                                std::string(spec) + "'");
+  }
+}
+
+// SIZE is in KiB unless followed by b, K, M, G or T.
+void SortCommand::parseMemory(std::string_view size) {
+  static constexpr std::string_view kSuffixes = "bKMGT";
+  static constexpr unsigned kShifts[] = {0, 10, 20, 30, 40};
+
+  unsigned shift = 10;
+  std::string_view digits = size;
+  if (!digits.empty()) {
+    const size_t suffix = kSuffixes.find(digits.back());
+    if (suffix != std::string_view::npos) {
+      shift = kShifts[suffix];
+      digits.remove_suffix(1);
+    }
+  }
+
+  size_t value = 0;
+  auto [end, ec] =
+      std::from_chars(digits.data(), digits.data() + digits.size(), value);
+  if (digits.empty() || ec != std::errc{} ||
+      end != digits.data() + digits.size() || value == 0 ||
+      value > (std::numeric_limits<size_t>::max() >> shift)) {
+    throw std::invalid_argument("sort: invalid -S argument '" +
+                                std::string(size) + "'");
+  }
+  memory_ = value << shift;
+}
+
+// Without -t a field is a run of non-blanks together with the blanks in
+// front of it, like in GNU sort. With -t fields end at each separator.
+std::string_view SortCommand::keyOf(std::string_view line) const {
+  auto skip_field = [this, line](size_t pos) {
+    if (separator_) {
+      const size_t found = line.find(*separator_, pos);
+      return found == std::string_view::npos ? line.size() : found;
+    }
+    while (pos < line.size() && isBlank(line[pos])) {
+      ++pos;
+    }
+    while (pos < line.size() && !isBlank(line[pos])) {
+      ++pos;
+    }
+    return pos;
+  };
+
+  size_t begin = 0;
+  for (size_t field = 0; field < key_begin_ && begin < line.size(); ++field) {
+    begin = skip_field(begin) + (separator_ ? 1 : 0);
+  }
+  begin = std::min(begin, line.size());
+  if (key_end_ == std::numeric_limits<size_t>::max()) {
+    return line.substr(begin);
+  }
+
+  size_t end = begin;
+  for (size_t field = key_begin_; field <= key_end_ && end < line.size();
+       ++field) {
+    if (field != key_begin_ && separator_) {
+      ++end;
+    }
+    end = skip_field(end);
+  }
+  return line.substr(begin, end - begin);
+}
+
+struct SortCommand::Record {
+  std::string_view line;
+  std::string_view key;
+  Number number;  // -n only
+};
+
+SortCommand::Record SortCommand::recordOf(std::string_view line) const {
+  Record record{line, keyOf(line), {}};
+  if (numeric_) {
+    record.number = parseNumber(record.key);
+  }
+  return record;
+}
+
+int SortCommand::compare(const Record& lhs, const Record& rhs) const {
+  int result = numeric_ ? compareNumbers(lhs.number, rhs.number)
+                        : compareBytes(lhs.key, rhs.key);
+  // Lines with equal keys fall back to comparing the whole lines, except
+  // under -u, which treats them as duplicates.
+  if (result == 0 && !unique_) {
+    result = compareBytes(lhs.line, rhs.line);
+  }
+  return reverse_ ? -result : result;
+}
+
+int SortCommand::compare(std::string_view lhs, std::string_view rhs) const {
+  return compare(recordOf(lhs), recordOf(rhs));
+}
+
+// Sorts slices of the lines in parallel, then merges them pairwise. The
+// slice sorts and the merges are stable, so under -u the first of equal
+// lines in input order comes first.
+void SortCommand::sortLines(std::vector<std::string_view>& lines) const {
+  const size_t slices = std::clamp<size_t>(lines.size() / kMinSliceLines, 1,
+                                           workerCount());
+  std::vector<size_t> bounds(slices + 1);
+  for (size_t i = 0; i <= slices; ++i) {
+    bounds[i] = lines.size() * i / slices;
+  }
+  auto merge_slices = [&bounds, slices](auto& items, auto less) {
+    for (size_t width = 1; width < slices; width *= 2) {
+      for (size_t i = 0; i + width < slices; i += 2 * width) {
+        std::inplace_merge(
+            items.begin() + bounds[i], items.begin() + bounds[i + width],
+            items.begin() + bounds[std::min(i + 2 * width, slices)], less);
+      }
+    }
+  };
+
+  // Whole-line byte order needs no comparator: the radix sort does it, and
+  // equal keys are then identical lines, so stability does not matter.
+  if (!numeric_ && key_begin_ == 0 &&
+      key_end_ == std::numeric_limits<size_t>::max()) {
+    parallelFor(slices, slices, [&](size_t slice, size_t) {
+      radixSort(std::span(lines.data() + bounds[slice],
+                          bounds[slice + 1] - bounds[slice]),
+                [](std::string_view line) { return line; });
+    });
+    merge_slices(lines, std::less<std::string_view>{});
+    if (reverse_) {
+      std::reverse(lines.begin(), lines.end());
+    }
+    return;
+  }
+
+  // Keys are located and parsed once per line rather than per comparison.
+  std::vector<Record> records(lines.size());
+  auto less = [this](const Record& lhs, const Record& rhs) {
+    return compare(lhs, rhs) < 0;
+  };
+  parallelFor(slices, slices, [&](size_t slice, size_t) {
+    for (size_t i = bounds[slice]; i < bounds[slice + 1]; ++i) {
+      records[i] = recordOf(lines[i]);
+    }
+    std::stable_sort(records.begin() + bounds[slice],
+                     records.begin() + bounds[slice + 1], less);
+  });
+  merge_slices(records, less);
+  for (size_t i = 0; i < records.size(); ++i) {
+    lines[i] = records[i].line;
+  }
+}
+
+void SortCommand::writeLines(const std::vector<std::string_view>& lines,
+                             const Output& out) const {
+  BufferedWriter writer(out);
+  const std::string_view* previous = nullptr;
+  for (const auto& line : lines) {
+    if (unique_ && previous != nullptr && compare(*previous, line) == 0) {
+      continue;
+    }
+    writer.write(line);
+    writer.put('\n');
+    previous = &line;
+  }
+  writer.flush();
+}
+
+UniqueFd SortCommand::spill(const std::vector<std::string_view>& lines) const {
+  UniqueFd run = createTempFile();
+  writeLines(lines, FdOutput(run.get()));
+  return run;
+}
+
+// Merges the runs, which hold the input in order, with a binary heap. Ties
+// go to the earlier run, which keeps the merge stable.
+void SortCommand::mergeRuns(std::vector<UniqueFd>& runs,
+                            const Output& out) const {
+  std::vector<RunReader> readers;
+  readers.reserve(runs.size());
+  for (auto& run : runs) {
+    readers.emplace_back(std::move(run));
+  }
+  runs.clear();
+
+  auto after = [&readers, this](size_t lhs, size_t rhs) {
+    const int result = compare(readers[lhs].line(), readers[rhs].line());
+    return result != 0 ? result > 0 : lhs > rhs;
+  };
+  std::vector<size_t> heap;
+  for (size_t i = 0; i < readers.size(); ++i) {
+    if (readers[i].next()) {
+      heap.push_back(i);
+    }
+  }
+  std::ranges::make_heap(heap, after);
+
+  BufferedWriter writer(out);
+  std::string previous;
+  bool has_previous = false;
+  while (!heap.empty()) {
+    std::ranges::pop_heap(heap, after);
+    RunReader& reader = readers[heap.back()];
+    if (!unique_ || !has_previous || compare(previous, reader.line()) != 0) {
+      writer.write(reader.line());
+      writer.put('\n');
+      if (unique_) {
+        previous.assign(reader.line());
+        has_previous = true;
+      }
+    }
+    if (reader.next()) {
+      std::ranges::push_heap(heap, after);
+    } else {
+      heap.pop_back();
+    }
+  }
+  writer.flush();
+}
+
+int SortCommand::run(Input& in, Output& out) {
+  std::vector<int> sources;
+  std::vector<UniqueFd> files;
+  for (const auto& file : files_) {
+    if (file == "-") {
+      sources.push_back(in.fd());
+      continue;
+    }
+    UniqueFd fd(open(file.c_str(), O_RDONLY | O_CLOEXEC));
+    if (!fd) {
+      std::cerr << "sort: cannot read: " << file << ": "
+                << std::strerror(errno) << '\n';
+      return 2;
+    }
+    sources.push_back(fd.get());
+    files.push_back(std::move(fd));
+  }
+  if (files_.empty()) {
+    sources.push_back(in.fd());
+  }
+
+  // A quarter of the budget goes to the text of a chunk, the rest to its
+  // line records and the sort.
+  const size_t chunk_limit = std::max<size_t>(memory_ / 4, 1);
+  std::string text;
+  std::vector<std::string_view> lines;
+  std::vector<UniqueFd> runs;
+
+  try {
+    for (int source : sources) {
+      // End of the last complete line in text, found in each block as it
+      // is read rather than by rescanning the whole chunk. What earlier
+      // files left over is whole lines.
+      size_t complete = text.size();
+      while (true) {
+        const size_t used = text.size();
+        text.resize(used + kReadSize);
+        const size_t size = readFd(source, text.data() + used, kReadSize);
+        text.resize(used + size);
+        if (size == 0) {
+          break;
+        }
+        if (const void* newline = memrchr(text.data() + used, '\n', size)) {
+          complete = static_cast<const char*>(newline) - text.data() + 1;
+        }
+
+        // A full chunk is sorted up to its last complete line and written
+        // out as a run; the partial line starts the next chunk.
+        if (text.size() < chunk_limit || complete == 0) {
+          continue;
+        }
+        lines.clear();
+        splitLines(std::string_view(text).substr(0, complete), lines);
+        sortLines(lines);
+        runs.push_back(spill(lines));
+        text.erase(0, complete);
+        complete = 0;
+      }
+      // Files that do not end in a newline still end their last line.
+      if (!text.empty() && text.back() != '\n') {
+        text.push_back('\n');
+      }
+    }
+
+    lines.clear();
+    splitLines(text, lines);
+    sortLines(lines);
+    if (runs.empty()) {
+      writeLines(lines, out);
+      return 0;
+    }
+    runs.push_back(spill(lines));
+    text = {};
+    lines = {};
+
+    while (runs.size() > kMergeWidth) {
+      std::vector<UniqueFd> merged;
+      for (size_t i = 0; i < runs.size(); i += kMergeWidth) {
+        std::vector<UniqueFd> group;
+        for (size_t j = i; j < std::min(i + kMergeWidth, runs.size()); ++j) {
+          group.push_back(std::move(runs[j]));
+        }
+        UniqueFd run = createTempFile();
+        mergeRuns(group, FdOutput(run.get()));
+        merged.push_back(std::move(run));
+      }
+      runs = std::move(merged);
+    }
+    mergeRuns(runs, out);
+  } catch (const std::system_error& e) {
+    std::cerr << "sort: " << e.what() << '\n';
+    return 2;
+  }
+  return 0;
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{"sort", makeBuiltin<SortCommand>};
+
+}  // namespace
+
+}  // namespace coreutils
@@ -0,0 +1,475 @@
+#include <tail_command.hpp>
+
+#include <builtin_registry.hpp>
+#include <cancellation.hpp>
+#include <fd_io.hpp>
+#include <text_kernels.hpp>
+#include <unique_fd.hpp>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <system_error>
+
+namespace coreutils {
+
+namespace {
+
+constexpr size_t kBlockSize = 64 * 1024;
+constexpr size_t kEventBufferSize = 16 * 1024;
+
+bool isDigit(char ch) { return ch >= '0' && ch <= '9'; }
+
+// Walks back over the newlines of `block`, counting `left` down, and
+// returns the offset just past the one that brings it to zero. `left`
+// must not be zero.
+std::optional<size_t> findLinesStart(std::string_view block, size_t& left) {
+  size_t end = block.size();
+  while (true) {
+    const void* newline = memrchr(block.data(), '\n', end);
+    if (newline == nullptr) {
+      return std::nullopt;
+    }
+    end = static_cast<size_t>(static_cast<const char*>(newline) -
+                              block.data());
+    if (--left == 0) {
+      return end + 1;
+    }
+  }
+}
+
+// The newline at the very end closes the last line rather than starting
+// another one, so it is not counted.
+std::string_view withoutFinalNewline(std::string_view text) {
+  if (text.ends_with('\n')) {
+    text.remove_suffix(1);
+  }
+  return text;
+}
+
+size_t readAt(int fd, char* data, size_t size, off_t offset) {
+  size_t done = 0;
+  while (done != size) {
+    const ssize_t res = pread(fd, data + done, size - done,
+                              offset + static_cast<off_t>(done));
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(), "read");
+    }
+    if (res == 0) {
+      break;
+    }
+    done += static_cast<size_t>(res);
+  }
+  return done;
+}
+
+// Start of the last `count` lines between `begin` and `end` of a file,
+// read backwards a block at a time.
+off_t linesStartInFile(int fd, off_t begin, off_t end, size_t count) {
+  if (count == 0) {
+    return end;
+  }
+  std::vector<char> block(kBlockSize);
+  for (off_t block_end = end; block_end > begin;) {
+    const off_t block_begin =
+        std::max(begin, block_end - static_cast<off_t>(kBlockSize));
+    std::string_view text(
+        block.data(),
+        readAt(fd, block.data(), static_cast<size_t>(block_end - block_begin),
+               block_begin));
+    if (block_end == end) {
+      text = withoutFinalNewline(text);
+    }
+    if (auto start = findLinesStart(text, count)) {
+      return block_begin + static_cast<off_t>(*start);
+    }
+    block_end = block_begin;
+  }
+  return begin;
+}
+
+// Copies from the current offset of `fd` to its end.
+void copyRest(int fd, const Output& out) {
+  if (out.fd() >= 0) {
+    copyFd(fd, out.fd());
+    return;
+  }
+  std::vector<char> block(kBlockSize);
+  for (size_t size = readFd(fd, block.data(), block.size()); size != 0;
+       size = readFd(fd, block.data(), block.size())) {
+    out.write(block.data(), size);
+  }
+}
+
+void reportOpenError(const std::string& file) {
+  std::cerr << "tail: cannot open '" << file
+            << "' for reading: " << std::strerror(errno) << '\n';
+}
+
+}  // namespace
+
+struct TailCommand::Followed {
+  std::string name;
+  UniqueFd fd;
+  int watch{-1};            // inotify watch on the open file
+  int directory_watch{-1};  // -F: inotify watch on the directory
+};
+
+TailCommand::TailCommand(std::vector<std::string> args) {
+  for (size_t i = 0; i < args.size(); ++i) {
+    const std::string& arg = args[i];
+    if (arg.size() < 2 || arg[0] != '-') {
+      files_.push_back(arg);
+      continue;
+    }
+    // The traditional -N means -n N.
+    if (isDigit(arg[1])) {
+      bytes_ = false;
+      parseCount(std::string_view(arg).substr(1));
+      continue;
+    }
+
+    for (size_t pos = 1; pos < arg.size(); ++pos) {
+      const char flag = arg[pos];
+      if (flag == 'f' || flag == 'F') {
+        follow_ = true;
+        by_name_ = by_name_ || flag == 'F';
+        continue;
+      }
+      if (flag != 'n' && flag != 'c') {
+        throw std::invalid_argument(std::string("tail: invalid option -- '") +
+                                    flag + "'");
+      }
+      bytes_ = flag == 'c';
+      // The value is the rest of the argument or the next argument.
+      std::string_view value = std::string_view(arg).substr(pos + 1);
+      if (value.empty()) {
+        if (i + 1 == args.size()) {
+          throw std::invalid_argument(
+              std::string("tail: option requires an argument -- '") + flag +
+              "'");
+        }
+        value = args[++i];
+      }
+      parseCount(value);
+      break;
+    }
+  }
+}
+
+void TailCommand::parseCount(std::string_view value) {
+  auto [end, ec] =
+      std::from_chars(value.data(), value.data() + value.size(), count_);
+  if (value.empty() || ec != std::errc{} ||
+      end != value.data() + value.size()) {
+    throw std::invalid_argument(
+        std::string("tail: invalid number of ") +
+        (bytes_ ? "bytes" : "lines") + ": '" + std::string(value) + "'");
+  }
+}
+
+// Regular files are tailed from their current offset on, which leaves the
+// offset at the end for following.
+void TailCommand::writeTail(int fd, const Output& out) const {
+  struct stat st {};
+  const off_t begin = lseek(fd, 0, SEEK_CUR);
+  // Files of procfs and the like report size 0 and have to be read.
+  if (begin < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+      st.st_size <= 0) {
+    writeStreamTail(fd, out);
+    return;
+  }
+
+  const off_t end = std::max(begin, st.st_size);
+  const off_t start =
+      bytes_ ? end - static_cast<off_t>(std::min(
+                         count_, static_cast<size_t>(end - begin)))
+             : linesStartInFile(fd, begin, end, count_);
+  if (lseek(fd, start, SEEK_SET) < 0) {
+    throw std::system_error(errno, std::generic_category(), "seek");
+  }
+  copyRest(fd, out);
+}
+
+// Keeps the input in a ring of blocks and lets the oldest block go as soon
+// as the newer ones hold the whole tail: count_ bytes, or one newline more
+// than count_ lines, since the last one may only end the input.
+void TailCommand::writeStreamTail(int fd, const Output& out) const {
+  struct Block {
+    std::string data;
+    size_t newlines;
+  };
+  std::deque<Block> ring;
+  size_t bytes = 0;
+  size_t newlines = 0;
+
+  while (true) {
+    Block block{std::string(kBlockSize, '\0'), 0};
+    const size_t size = readFd(fd, block.data.data(), block.data.size());
+    if (size == 0) {
+      break;
+    }
+    block.data.resize(size);
+    if (!bytes_) {
+      block.newlines = countNewlines(block.data);
+    }
+    bytes += size;
+    newlines += block.newlines;
+    ring.push_back(std::move(block));
+
+    while (ring.size() > 1) {
+      const Block& oldest = ring.front();
+      const bool covered = bytes_ ? bytes - oldest.data.size() >= count_
+                                  : newlines - oldest.newlines > count_;
+      if (!covered) {
+        break;
+      }
+      bytes -= oldest.data.size();
+      newlines -= oldest.newlines;
+      ring.pop_front();
+    }
+  }
+
+  std::string text;
+  text.reserve(bytes);
+  for (const auto& block : ring) {
+    text += block.data;
+  }
+  size_t start = text.size();
+  if (bytes_) {
+    start -= std::min(count_, text.size());
+  } else if (count_ != 0) {
+    size_t left = count_;
+    start = findLinesStart(withoutFinalNewline(text), left).value_or(0);
+  }
+  out.write(text.data() + start, text.size() - start);
+}
+
+int TailCommand::run(Input& in, Output& out) {
+  if (files_.empty()) {
+    try {
+      writeTail(in.fd(), out);
+    } catch (const std::system_error& e) {
+      std::cerr << "tail: error reading: " << e.code().message() << '\n';
+      return 1;
+    }
+    return 0;
+  }
+
+  int exit_code = 0;
+  bool first = true;
+  std::vector<Followed> followed;
+  for (const auto& file : files_) {
+    UniqueFd opened;
+    int fd = in.fd();
+    if (file != "-") {
+      opened = UniqueFd(open(file.c_str(), O_RDONLY | O_CLOEXEC));
+      if (!opened) {
+        reportOpenError(file);
+        exit_code = 1;
+        // -F waits for the file to appear.
+        if (by_name_) {
+          followed.push_back({file, UniqueFd{}});
+        }
+        continue;
+      }
+      fd = opened.get();
+    }
+
+    if (files_.size() > 1) {
+      out.write((first ? "==> " : "\n==> ") + file + " <==\n");
+    }
+    first = false;
+    try {
+      writeTail(fd, out);
+    } catch (const std::system_error& e) {
+      std::cerr << "tail: error reading '" << file
+                << "': " << e.code().message() << '\n';
+      exit_code = 1;
+      continue;
+    }
+    if (follow_ && file != "-") {
+      followed.push_back({file, std::move(opened)});
+    }
+  }
+
+  if (!follow_) {
+    return exit_code;
+  }
+  if (followed.empty()) {
+    std::cerr << "tail: no files remaining\n";
+    return 1;
+  }
+  try {
+    follow(followed, out);
+  } catch (const std::system_error& e) {
+    std::cerr << "tail: " << e.what() << '\n';
+    return 1;
+  }
+  return exit_code;
+}
+
+// Sleeps in poll() on the inotify descriptor together with the output,
+// where a pipe whose reader is gone reports POLLERR, and the cancellation
+// of the pipeline stage. Either ends following even while the files are
+// idle.
+void TailCommand::follow(std::vector<Followed>& files,
+                         const Output& out) const {
+  UniqueFd inotify(inotify_init1(IN_CLOEXEC));
+  if (!inotify) {
+    throw std::system_error(errno, std::generic_category(), "inotify");
+  }
+
+  auto watch_file = [&](Followed& file) {
+    file.watch =
+        inotify_add_watch(inotify.get(), file.name.c_str(), IN_MODIFY);
+  };
+  for (auto& file : files) {
+    if (file.fd) {
+      watch_file(file);
+    }
+    if (by_name_) {
+      auto directory = std::filesystem::path(file.name).parent_path();
+      if (directory.empty()) {
+        directory = ".";
+      }
+      file.directory_watch = inotify_add_watch(
+          inotify.get(), directory.c_str(), IN_CREATE | IN_MOVED_TO);
+      if (file.directory_watch < 0) {
+        std::cerr << "tail: cannot watch '" << directory.string()
+                  << "': " << std::strerror(errno) << '\n';
+      }
+    }
+  }
+
+  const bool headers = files_.size() > 1;
+  size_t shown = files.size() - 1;
+
+  // Writes whatever was appended to the file since it was last shown.
+  auto show = [&](size_t index) {
+    Followed& file = files[index];
+    struct stat st {};
+    if (!file.fd || fstat(file.fd.get(), &st) != 0) {
+      return;
+    }
+    off_t offset = lseek(file.fd.get(), 0, SEEK_CUR);
+    if (st.st_size < offset) {
+      std::cerr << "tail: " << file.name << ": file truncated\n";
+      offset = lseek(file.fd.get(), 0, SEEK_SET);
+    }
+    if (st.st_size == offset) {
+      return;
+    }
+    if (headers && index != shown) {
+      out.write("\n==> " + file.name + " <==\n");
+      shown = index;
+    }
+    copyRest(file.fd.get(), out);
+  };
+
+  // -F: a file was created or moved in under the name. The old file is
+  // drained first; writes to it until now are not lost.
+  auto reopen = [&](size_t index) {
+    Followed& file = files[index];
+    UniqueFd fd(open(file.name.c_str(), O_RDONLY | O_CLOEXEC));
+    struct stat fresh {};
+    struct stat current {};
+    if (!fd || fstat(fd.get(), &fresh) != 0) {
+      return;
+    }
+    if (file.fd && fstat(file.fd.get(), &current) == 0 &&
+        fresh.st_ino == current.st_ino && fresh.st_dev == current.st_dev) {
+      return;
+    }
+
+    std::cerr << "tail: '" << file.name << "' has "
+              << (file.fd ? "been replaced" : "appeared")
+              << ";  following new file\n";
+    if (file.fd) {
+      show(index);
+      inotify_rm_watch(inotify.get(), file.watch);
+    }
+    file.fd = std::move(fd);
+    watch_file(file);
+    show(index);
+  };
+
+  // Whatever changed between the first read and the watches is caught up
+  // on here; later changes all come with events.
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (by_name_) {
+      reopen(i);
+    }
+    show(i);
+  }
+
+  // poll() skips the negative descriptors of outputs without one and of
+  // commands run outside of a pipeline.
+  std::array<pollfd, 3> fds{{{inotify.get(), POLLIN, 0},
+                             {out.fd(), 0, 0},
+                             {cancellationFd(), POLLIN, 0}}};
+  alignas(inotify_event) std::array<char, kEventBufferSize> events{};
+  while (true) {
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(), "poll");
+    }
+    throwIfCancelled();
+    if (fds[1].revents != 0) {
+      return;
+    }
+    if (fds[0].revents == 0) {
+      continue;
+    }
+
+    const ssize_t size = read(inotify.get(), events.data(), events.size());
+    if (size < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::system_error(errno, std::generic_category(), "inotify");
+    }
+    for (size_t pos = 0; pos < static_cast<size_t>(size);) {
+      const auto* event =
+          reinterpret_cast<const inotify_event*>(events.data() + pos);
+      pos += sizeof(inotify_event) + event->len;
+
+      for (size_t i = 0; i < files.size(); ++i) {
+        Followed& file = files[i];
+        if ((event->mask & IN_Q_OVERFLOW) != 0 || event->wd == file.watch) {
+          show(i);
+        } else if (event->wd == file.directory_watch && event->len != 0 &&
+                   std::filesystem::path(file.name).filename() ==
+                       event->name) {
+          reopen(i);
+        }
+      }
+    }
+  }
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{"tail", makeBuiltin<TailCommand>};
+
+}  // namespace
+
+}  // namespace coreutils
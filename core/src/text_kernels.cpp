@@ -0,0 +1,1019 @@
+#include <text_kernels.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COREUTILS_X86_KERNELS 1
+#endif
+
+namespace coreutils {
+
+namespace {
+
+constexpr std::array<bool, 256> kIsSpace = [] {
+  std::array<bool, 256> table{};
+  for (unsigned char ch : {' ', '\t', '\n', '\v', '\f', '\r'}) {
+    table[ch] = true;
+  }
+  return table;
+}();
+
+TextCounts countTextScalar(const char* data, size_t size, bool& in_word) {
+  TextCounts counts{};
+  counts.bytes = size;
+  for (size_t i = 0; i < size; ++i) {
+    const auto ch = static_cast<unsigned char>(data[i]);
+    counts.lines += static_cast<size_t>(ch == '\n');
+    const bool space = kIsSpace[ch];
+    counts.words += static_cast<size_t>(!space && !in_word);
+    in_word = !space;
+  }
+  return counts;
+}
+
+constexpr size_t kTabWidth = 8;
+
+bool isContinuationByte(unsigned char ch) { return (ch & 0xC0) == 0x80; }
+
+void advanceLine(unsigned char ch, TextCounts& counts, Utf8TextState& state) {
+  if (ch == '\n') {
+    counts.max_line_length = std::max(counts.max_line_length, state.line_length);
+    state.line_length = 0;
+  } else if (ch == '\t') {
+    state.line_length = (state.line_length / kTabWidth + 1) * kTabWidth;
+  } else if (!isContinuationByte(ch)) {
+    ++state.line_length;
+  }
+}
+
+TextCounts countUtf8TextScalar(const char* data, size_t size,
+                               Utf8TextState& state) {
+  TextCounts counts = countTextScalar(data, size, state.in_word);
+  for (size_t i = 0; i < size; ++i) {
+    const auto ch = static_cast<unsigned char>(data[i]);
+    counts.chars += static_cast<size_t>(!isContinuationByte(ch));
+    advanceLine(ch, counts, state);
+  }
+  return counts;
+}
+
+size_t countByteScalar(const char* data, size_t size, char byte) {
+  size_t count = 0;
+  for (size_t i = 0; i < size; ++i) {
+    count += static_cast<size_t>(data[i] == byte);
+  }
+  return count;
+}
+
+// Bits of kShellCharClass, one per ShellCharMasks field.
+constexpr uint8_t kShellSpace = 1;
+constexpr uint8_t kShellBreak = 2;
+constexpr uint8_t kShellEquals = 4;
+constexpr uint8_t kShellWildcard = 8;
+
+constexpr std::array<uint8_t, 256> kShellCharClass = [] {
+  std::array<uint8_t, 256> table{};
+  for (unsigned char ch : {' ', '\t', '\n', '\v', '\f', '\r'}) {
+    table[ch] = kShellSpace | kShellBreak;
+  }
+  for (unsigned char ch : {'\'', '"', '`', '$', '|', '&'}) {
+    table[ch] = kShellBreak;
+  }
+  table['='] = kShellEquals;
+  for (unsigned char ch : {'*', '?', '['}) {
+    table[ch] = kShellWildcard;
+  }
+  return table;
+}();
+
+// Classifies up to one block of 64 bytes.
+ShellCharMasks classifyShellBlockScalar(const char* data, size_t size) {
+  ShellCharMasks masks;
+  for (size_t i = 0; i < size; ++i) {
+    const uint8_t cls = kShellCharClass[static_cast<unsigned char>(data[i])];
+    masks.space |= uint64_t{(cls & kShellSpace) != 0} << i;
+    masks.breaks |= uint64_t{(cls & kShellBreak) != 0} << i;
+    masks.equals |= uint64_t{(cls & kShellEquals) != 0} << i;
+    masks.wildcards |= uint64_t{(cls & kShellWildcard) != 0} << i;
+  }
+  return masks;
+}
+
+void classifyShellCharsScalar(const char* data, size_t size,
+                              ShellCharMasks* out) {
+  constexpr size_t kBlock = 64;
+  for (size_t i = 0; i < size; i += kBlock) {
+    *out++ = classifyShellBlockScalar(data + i, std::min(kBlock, size - i));
+  }
+}
+
+void maskBytePairScalar(const char* data, size_t size, char first,
+                        char second, uint64_t* out) {
+  constexpr size_t kBlock = 64;
+  for (size_t i = 0; i < size; i += kBlock, ++out) {
+    const size_t end = std::min(kBlock, size - i);
+    uint64_t mask = 0;
+    for (size_t j = 0; j < end; ++j) {
+      const char ch = data[i + j];
+      mask |= uint64_t{ch == first || ch == second} << j;
+    }
+    *out = mask;
+  }
+}
+
+void translateBytesScalar(const ByteMap& map, char* data, size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = static_cast<char>(map.table[static_cast<unsigned char>(data[i])]);
+  }
+}
+
+size_t findByteInSetScalar(const ByteSet& set, const char* data,
+                           size_t size) {
+  for (size_t i = 0; i < size; ++i) {
+    if (set.members[static_cast<unsigned char>(data[i])]) {
+      return i;
+    }
+  }
+  return size;
+}
+
+// Extends the last run when `byte` directly follows it with the same
+// delta; bytes must be added in increasing order.
+void addToRuns(std::vector<ByteRun>& runs, unsigned byte, uint8_t delta) {
+  if (!runs.empty() && runs.back().last + 1U == byte &&
+      runs.back().delta == delta) {
+    runs.back().last = static_cast<uint8_t>(byte);
+    return;
+  }
+  runs.push_back({static_cast<uint8_t>(byte), static_cast<uint8_t>(byte),
+                  delta});
+}
+
+#ifdef COREUTILS_X86_KERNELS
+
+// The vector variants subtract the 0/-1 compare results from per-lane byte
+// counters and fold them with SAD every 255 blocks, before they overflow.
+constexpr size_t kMaxBlocksPerFold = 255;
+
+__attribute__((target("popcnt"))) size_t countByteSse2(const char* data,
+                                                       size_t size,
+                                                       char byte) {
+  constexpr size_t kWidth = 16;
+  const __m128i needle = _mm_set1_epi8(byte);
+  const __m128i zero = _mm_setzero_si128();
+
+  size_t count = 0;
+  size_t i = 0;
+  while (size - i >= kWidth) {
+    const size_t blocks = std::min((size - i) / kWidth, kMaxBlocksPerFold);
+    __m128i acc = zero;
+    for (size_t b = 0; b < blocks; ++b, i += kWidth) {
+      const __m128i chunk =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+      acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(chunk, needle));
+    }
+    const __m128i sums = _mm_sad_epu8(acc, zero);
+    count += static_cast<size_t>(_mm_cvtsi128_si32(sums)) +
+             static_cast<size_t>(_mm_extract_epi16(sums, 4));
+  }
+  return count + countByteScalar(data + i, size - i, byte);
+}
+
+__attribute__((target("avx2,popcnt"))) size_t countByteAvx2(const char* data,
+                                                            size_t size,
+                                                            char byte) {
+  constexpr size_t kWidth = 32;
+  const __m256i needle = _mm256_set1_epi8(byte);
+  const __m256i zero = _mm256_setzero_si256();
+
+  size_t count = 0;
+  size_t i = 0;
+  while (size - i >= kWidth) {
+    const size_t blocks = std::min((size - i) / kWidth, kMaxBlocksPerFold);
+    __m256i acc = zero;
+    for (size_t b = 0; b < blocks; ++b, i += kWidth) {
+      const __m256i chunk =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+      acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(chunk, needle));
+    }
+    const __m256i sums = _mm256_sad_epu8(acc, zero);
+    count += static_cast<size_t>(_mm256_extract_epi64(sums, 0)) +
+             static_cast<size_t>(_mm256_extract_epi64(sums, 1)) +
+             static_cast<size_t>(_mm256_extract_epi64(sums, 2)) +
+             static_cast<size_t>(_mm256_extract_epi64(sums, 3));
+  }
+  return count + countByteSse2(data + i, size - i, byte);
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt"))) size_t countByteAvx512(
+    const char* data, size_t size, char byte) {
+  constexpr size_t kWidth = 64;
+  const __m512i needle = _mm512_set1_epi8(byte);
+
+  size_t count = 0;
+  size_t i = 0;
+  for (; size - i >= kWidth; i += kWidth) {
+    const __m512i chunk = _mm512_loadu_si512(data + i);
+    count += std::popcount(_mm512_cmpeq_epi8_mask(chunk, needle));
+  }
+  if (i < size) {
+    const __mmask64 tail = (uint64_t{1} << (size - i)) - 1;
+    const __m512i chunk = _mm512_maskz_loadu_epi8(tail, data + i);
+    count += std::popcount(_mm512_mask_cmpeq_epi8_mask(tail, chunk, needle));
+  }
+  return count;
+}
+
+// The wc variants build a bitmask of non-space bytes per block. A word starts
+// at every set bit whose predecessor is clear; the predecessor of bit 0 is
+// the last bit of the previous block, carried in `in_word`.
+template <typename Mask>
+__attribute__((always_inline)) inline size_t countWordStarts(Mask non_space,
+                                                             bool& in_word) {
+  constexpr int kBits = std::numeric_limits<Mask>::digits;
+  const Mask previous =
+      static_cast<Mask>(non_space << 1) | static_cast<Mask>(in_word);
+  in_word = ((non_space >> (kBits - 1)) & 1) != 0;
+  return std::popcount(static_cast<Mask>(non_space & ~previous));
+}
+
+__attribute__((target("popcnt"))) TextCounts countTextSse2(const char* data,
+                                                           size_t size,
+                                                           bool& in_word) {
+  constexpr size_t kWidth = 16;
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i four = _mm_set1_epi8(4);
+
+  TextCounts counts{};
+  size_t i = 0;
+  for (; size - i >= kWidth; i += kWidth) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    // '\t'..'\r' are contiguous: (ch - '\t') <= 4 as unsigned bytes.
+    const __m128i shifted = _mm_sub_epi8(chunk, tab);
+    const __m128i in_range =
+        _mm_cmpeq_epi8(_mm_min_epu8(shifted, four), shifted);
+    const __m128i is_space = _mm_or_si128(in_range, _mm_cmpeq_epi8(chunk, space));
+
+    const auto lines = static_cast<uint16_t>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+    const auto non_space =
+        static_cast<uint16_t>(~_mm_movemask_epi8(is_space));
+    counts.lines += std::popcount(lines);
+    counts.words += countWordStarts(non_space, in_word);
+  }
+  counts.bytes = i;
+  return counts += countTextScalar(data + i, size - i, in_word);
+}
+
+__attribute__((target("avx2,popcnt"))) TextCounts countTextAvx2(
+    const char* data, size_t size, bool& in_word) {
+  constexpr size_t kWidth = 32;
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i four = _mm256_set1_epi8(4);
+
+  TextCounts counts{};
+  size_t i = 0;
+  for (; size - i >= kWidth; i += kWidth) {
+    const __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const __m256i shifted = _mm256_sub_epi8(chunk, tab);
+    const __m256i in_range =
+        _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, four), shifted);
+    const __m256i is_space =
+        _mm256_or_si256(in_range, _mm256_cmpeq_epi8(chunk, space));
+
+    const auto lines = static_cast<uint32_t>(
+        _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline)));
+    const auto non_space =
+        static_cast<uint32_t>(~_mm256_movemask_epi8(is_space));
+    counts.lines += std::popcount(lines);
+    counts.words += countWordStarts(non_space, in_word);
+  }
+  counts.bytes = i;
+  return counts += countTextSse2(data + i, size - i, in_word);
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt"))) TextCounts countTextAvx512(
+    const char* data, size_t size, bool& in_word) {
+  constexpr size_t kWidth = 64;
+  const __m512i newline = _mm512_set1_epi8('\n');
+  const __m512i space = _mm512_set1_epi8(' ');
+  const __m512i tab = _mm512_set1_epi8('\t');
+  const __m512i four = _mm512_set1_epi8(4);
+
+  TextCounts counts{};
+  size_t i = 0;
+  for (; size - i >= kWidth; i += kWidth) {
+    const __m512i chunk = _mm512_loadu_si512(data + i);
+    const __mmask64 is_space =
+        _mm512_cmple_epu8_mask(_mm512_sub_epi8(chunk, tab), four) |
+        _mm512_cmpeq_epi8_mask(chunk, space);
+    counts.lines += std::popcount(_mm512_cmpeq_epi8_mask(chunk, newline));
+    counts.words += countWordStarts(static_cast<uint64_t>(~is_space), in_word);
+  }
+  counts.bytes = i;
+  return counts += countTextScalar(data + i, size - i, in_word);
+}
+
+// Folds the per-block bitmasks of the UTF-8 kernels into the counters. The
+// ASCII-only common case never looks at individual bytes: line lengths are
+// popcounts of the character mask between consecutive newline bits. Only a
+// block containing a tab walks its bytes, because tab stops depend on the
+// column.
+template <typename Mask>
+__attribute__((always_inline)) inline void accumulateUtf8Block(
+    const char* block, Mask newline, Mask space, Mask continuation, Mask tab,
+    TextCounts& counts, Utf8TextState& state) {
+  constexpr int kBits = std::numeric_limits<Mask>::digits;
+  const auto chars = static_cast<Mask>(~continuation);
+
+  counts.lines += std::popcount(newline);
+  counts.words += countWordStarts(static_cast<Mask>(~space), state.in_word);
+  counts.chars += std::popcount(chars);
+
+  if (tab != 0) {
+    for (int i = 0; i < kBits; ++i) {
+      advanceLine(static_cast<unsigned char>(block[i]), counts, state);
+    }
+    return;
+  }
+
+  Mask remaining = newline;
+  Mask line_start = ~Mask{0};  // bits at or after the current line start
+  while (remaining != 0) {
+    const int bit = std::countr_zero(remaining);
+    const Mask before_newline = (Mask{1} << bit) - 1;
+    state.line_length += std::popcount(static_cast<Mask>(chars & line_start &
+                                                         before_newline));
+    counts.max_line_length =
+        std::max(counts.max_line_length, state.line_length);
+    state.line_length = 0;
+    line_start = bit + 1 < kBits ? static_cast<Mask>(~Mask{0} << (bit + 1))
+                                 : Mask{0};
+    remaining &= remaining - 1;
+  }
+  state.line_length += std::popcount(static_cast<Mask>(chars & line_start));
+}
+
+__attribute__((target("popcnt"))) TextCounts countUtf8TextSse2(
+    const char* data, size_t size, Utf8TextState& state) {
+  constexpr size_t kWidth = 16;
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i four = _mm_set1_epi8(4);
+  const __m128i continuation_limit = _mm_set1_epi8(-64);
+
+  TextCounts counts{};
+  size_t i = 0;
+  for (; size - i >= kWidth; i += kWidth) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i shifted = _mm_sub_epi8(chunk, tab);
+    const __m128i is_space =
+        _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(shifted, four), shifted),
+                     _mm_cmpeq_epi8(chunk, space));
+    // As signed bytes, continuation bytes 0x80..0xBF are exactly those < -64.
+    accumulateUtf8Block(
+        data + i,
+        static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline))),
+        static_cast<uint16_t>(_mm_movemask_epi8(is_space)),
+        static_cast<uint16_t>(
+            _mm_movemask_epi8(_mm_cmplt_epi8(chunk, continuation_limit))),
+        static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, tab))),
+        counts, state);
+  }
+  counts.bytes = i;
+  return counts += countUtf8TextScalar(data + i, size - i, state);
+}
+
+__attribute__((target("avx2,popcnt"))) TextCounts countUtf8TextAvx2(
+    const char* data, size_t size, Utf8TextState& state) {
+  constexpr size_t kWidth = 32;
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i four = _mm256_set1_epi8(4);
+  const __m256i continuation_limit = _mm256_set1_epi8(-64);
+
+  TextCounts counts{};
+  size_t i = 0;
+  for (; size - i >= kWidth; i += kWidth) {
+    const __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const __m256i shifted = _mm256_sub_epi8(chunk, tab);
+    const __m256i is_space = _mm256_or_si256(
+        _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, four), shifted),
+        _mm256_cmpeq_epi8(chunk, space));
+    accumulateUtf8Block(
+        data + i,
+        static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newline))),
+        static_cast<uint32_t>(_mm256_movemask_epi8(is_space)),
+        static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_cmpgt_epi8(continuation_limit, chunk))),
+        static_cast<uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, tab))),
+        counts, state);
+  }
+  counts.bytes = i;
+  return counts += countUtf8TextScalar(data + i, size - i, state);
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt"))) TextCounts
+countUtf8TextAvx512(const char* data, size_t size, Utf8TextState& state) {
+  constexpr size_t kWidth = 64;
+  const __m512i newline = _mm512_set1_epi8('\n');
+  const __m512i space = _mm512_set1_epi8(' ');
+  const __m512i tab = _mm512_set1_epi8('\t');
+  const __m512i four = _mm512_set1_epi8(4);
+  const __m512i continuation_limit = _mm512_set1_epi8(-64);
+
+  TextCounts counts{};
+  size_t i = 0;
+  for (; size - i >= kWidth; i += kWidth) {
+    const __m512i chunk = _mm512_loadu_si512(data + i);
+    const __mmask64 is_space =
+        _mm512_cmple_epu8_mask(_mm512_sub_epi8(chunk, tab), four) |
+        _mm512_cmpeq_epi8_mask(chunk, space);
+    accumulateUtf8Block<uint64_t>(
+        data + i, _mm512_cmpeq_epi8_mask(chunk, newline), is_space,
+        _mm512_cmplt_epi8_mask(chunk, continuation_limit),
+        _mm512_cmpeq_epi8_mask(chunk, tab), counts, state);
+  }
+  counts.bytes = i;
+  return counts += countUtf8TextScalar(data + i, size - i, state);
+}
+
+// The SSE2 and AVX2 variants assemble each 64-bit mask from four or two
+// movemask results; AVX-512 compares a whole block at once and handles the
+// tail with a masked load.
+__attribute__((always_inline)) inline ShellCharMasks classifyShellChunkSse2(
+    const char* data) {
+  const __m128i chunk =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+  const __m128i shifted = _mm_sub_epi8(chunk, _mm_set1_epi8('\t'));
+  const __m128i space = _mm_or_si128(
+      _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted),
+      _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')));
+  const __m128i quotes = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\'')),
+                   _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))),
+      _mm_cmpeq_epi8(chunk, _mm_set1_epi8('`')));
+  const __m128i operators =
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('|')),
+                   _mm_cmpeq_epi8(chunk, _mm_set1_epi8('&')));
+  const __m128i breaks = _mm_or_si128(
+      _mm_or_si128(space, quotes),
+      _mm_or_si128(operators, _mm_cmpeq_epi8(chunk, _mm_set1_epi8('$'))));
+  const __m128i wildcards = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('*')),
+                   _mm_cmpeq_epi8(chunk, _mm_set1_epi8('?'))),
+      _mm_cmpeq_epi8(chunk, _mm_set1_epi8('[')));
+  return {
+      static_cast<uint16_t>(_mm_movemask_epi8(space)),
+      static_cast<uint16_t>(_mm_movemask_epi8(breaks)),
+      static_cast<uint16_t>(
+          _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('=')))),
+      static_cast<uint16_t>(_mm_movemask_epi8(wildcards)),
+  };
+}
+
+void classifyShellCharsSse2(const char* data, size_t size,
+                            ShellCharMasks* out) {
+  constexpr size_t kBlock = 64;
+  size_t i = 0;
+  for (; size - i >= kBlock; i += kBlock, ++out) {
+    *out = {};
+    for (size_t part = 0; part < kBlock; part += 16) {
+      const ShellCharMasks masks = classifyShellChunkSse2(data + i + part);
+      out->space |= masks.space << part;
+      out->breaks |= masks.breaks << part;
+      out->equals |= masks.equals << part;
+      out->wildcards |= masks.wildcards << part;
+    }
+  }
+  classifyShellCharsScalar(data + i, size - i, out);
+}
+
+__attribute__((target("avx2"))) void classifyShellCharsAvx2(
+    const char* data, size_t size, ShellCharMasks* out) {
+  constexpr size_t kBlock = 64;
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i four = _mm256_set1_epi8(4);
+
+  size_t i = 0;
+  for (; size - i >= kBlock; i += kBlock, ++out) {
+    *out = {};
+    for (size_t part = 0; part < kBlock; part += 32) {
+      const __m256i chunk = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(data + i + part));
+      const __m256i shifted = _mm256_sub_epi8(chunk, tab);
+      const __m256i space = _mm256_or_si256(
+          _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, four), shifted),
+          _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')));
+      const __m256i quotes = _mm256_or_si256(
+          _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\'')),
+                          _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'))),
+          _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('`')));
+      const __m256i operators =
+          _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('|')),
+                          _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('&')));
+      const __m256i breaks = _mm256_or_si256(
+          _mm256_or_si256(space, quotes),
+          _mm256_or_si256(operators,
+                          _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('$'))));
+      const __m256i equals = _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('='));
+      const __m256i wildcards = _mm256_or_si256(
+          _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('*')),
+                          _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('?'))),
+          _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('[')));
+
+      out->space |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(space))}
+                    << part;
+      out->breaks |=
+          uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(breaks))} << part;
+      out->equals |=
+          uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(equals))} << part;
+      out->wildcards |=
+          uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(wildcards))}
+          << part;
+    }
+  }
+  classifyShellCharsScalar(data + i, size - i, out);
+}
+
+__attribute__((target("avx512f,avx512bw"))) void classifyShellCharsAvx512(
+    const char* data, size_t size, ShellCharMasks* out) {
+  constexpr size_t kBlock = 64;
+  const __m512i tab = _mm512_set1_epi8('\t');
+  const __m512i four = _mm512_set1_epi8(4);
+
+  for (size_t i = 0; i < size; i += kBlock, ++out) {
+    const size_t left = size - i;
+    const __mmask64 valid =
+        left >= kBlock ? ~__mmask64{0} : (uint64_t{1} << left) - 1;
+    const __m512i chunk = _mm512_maskz_loadu_epi8(valid, data + i);
+    const __mmask64 space =
+        (_mm512_cmple_epu8_mask(_mm512_sub_epi8(chunk, tab), four) |
+         _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8(' '))) &
+        valid;
+    const __mmask64 breaks =
+        space | _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('\'')) |
+        _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('"')) |
+        _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('`')) |
+        _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('$')) |
+        _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('|')) |
+        _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('&'));
+    const __mmask64 wildcards =
+        _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('*')) |
+        _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('?')) |
+        _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('['));
+    *out = {space, breaks,
+            _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('=')), wildcards};
+  }
+}
+
+void maskBytePairSse2(const char* data, size_t size, char first, char second,
+                      uint64_t* out) {
+  constexpr size_t kBlock = 64;
+  const __m128i first_byte = _mm_set1_epi8(first);
+  const __m128i second_byte = _mm_set1_epi8(second);
+
+  size_t i = 0;
+  for (; size - i >= kBlock; i += kBlock, ++out) {
+    *out = 0;
+    for (size_t part = 0; part < kBlock; part += 16) {
+      const __m128i chunk =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + part));
+      const __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, first_byte),
+                                        _mm_cmpeq_epi8(chunk, second_byte));
+      *out |= uint64_t{static_cast<uint16_t>(_mm_movemask_epi8(hits))} << part;
+    }
+  }
+  maskBytePairScalar(data + i, size - i, first, second, out);
+}
+
+__attribute__((target("avx2"))) void maskBytePairAvx2(const char* data,
+                                                      size_t size, char first,
+                                                      char second,
+                                                      uint64_t* out) {
+  constexpr size_t kBlock = 64;
+  const __m256i first_byte = _mm256_set1_epi8(first);
+  const __m256i second_byte = _mm256_set1_epi8(second);
+
+  size_t i = 0;
+  for (; size - i >= kBlock; i += kBlock, ++out) {
+    *out = 0;
+    for (size_t part = 0; part < kBlock; part += 32) {
+      const __m256i chunk = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(data + i + part));
+      const __m256i hits =
+          _mm256_or_si256(_mm256_cmpeq_epi8(chunk, first_byte),
+                          _mm256_cmpeq_epi8(chunk, second_byte));
+      *out |= uint64_t{static_cast<uint32_t>(_mm256_movemask_epi8(hits))}
+              << part;
+    }
+  }
+  maskBytePairScalar(data + i, size - i, first, second, out);
+}
+
+__attribute__((target("avx512f,avx512bw"))) void maskBytePairAvx512(
+    const char* data, size_t size, char first, char second, uint64_t* out) {
+  constexpr size_t kBlock = 64;
+  const __m512i first_byte = _mm512_set1_epi8(first);
+  const __m512i second_byte = _mm512_set1_epi8(second);
+
+  for (size_t i = 0; i < size; i += kBlock, ++out) {
+    const size_t left = size - i;
+    const __mmask64 valid =
+        left >= kBlock ? ~__mmask64{0} : (uint64_t{1} << left) - 1;
+    const __m512i chunk = _mm512_maskz_loadu_epi8(valid, data + i);
+    *out = (_mm512_cmpeq_epi8_mask(chunk, first_byte) |
+            _mm512_cmpeq_epi8_mask(chunk, second_byte)) &
+           valid;
+  }
+}
+
+// The run kernels test a byte against a run with one unsigned compare:
+// it is in [first, last] when (byte - first) <= (last - first).
+
+void translateBytesSse2(const ByteMap& map, char* data, size_t size) {
+  constexpr size_t kWidth = 16;
+  const size_t runs = map.runs.size();
+  __m128i firsts[kMaxVectorRuns];
+  __m128i spans[kMaxVectorRuns];
+  __m128i deltas[kMaxVectorRuns];
+  for (size_t r = 0; r < runs; ++r) {
+    const ByteRun& run = map.runs[r];
+    firsts[r] = _mm_set1_epi8(static_cast<char>(run.first));
+    spans[r] = _mm_set1_epi8(static_cast<char>(run.last - run.first));
+    deltas[r] = _mm_set1_epi8(static_cast<char>(run.delta));
+  }
+
+  size_t i = 0;
+  for (; size - i >= kWidth; i += kWidth) {
+    auto* chunk_ptr = reinterpret_cast<__m128i*>(data + i);
+    const __m128i chunk = _mm_loadu_si128(chunk_ptr);
+    // Runs are tested on the original bytes, so a translated byte is never
+    // translated again by a later run.
+    __m128i result = chunk;
+    for (size_t r = 0; r < runs; ++r) {
+      const __m128i shifted = _mm_sub_epi8(chunk, firsts[r]);
+      const __m128i in_run =
+          _mm_cmpeq_epi8(_mm_min_epu8(shifted, spans[r]), shifted);
+      result = _mm_add_epi8(result, _mm_and_si128(in_run, deltas[r]));
+    }
+    _mm_storeu_si128(chunk_ptr, result);
+  }
+  translateBytesScalar(map, data + i, size - i);
+}
+
+__attribute__((target("avx2"))) void translateBytesAvx2(const ByteMap& map,
+                                                        char* data,
+                                                        size_t size) {
+  constexpr size_t kWidth = 32;
+  const size_t runs = map.runs.size();
+  __m256i firsts[kMaxVectorRuns];
+  __m256i spans[kMaxVectorRuns];
+  __m256i deltas[kMaxVectorRuns];
+  for (size_t r = 0; r < runs; ++r) {
+    const ByteRun& run = map.runs[r];
+    firsts[r] = _mm256_set1_epi8(static_cast<char>(run.first));
+    spans[r] = _mm256_set1_epi8(static_cast<char>(run.last - run.first));
+    deltas[r] = _mm256_set1_epi8(static_cast<char>(run.delta));
+  }
+
+  size_t i = 0;
+  for (; size - i >= kWidth; i += kWidth) {
+    auto* chunk_ptr = reinterpret_cast<__m256i*>(data + i);
+    const __m256i chunk = _mm256_loadu_si256(chunk_ptr);
+    __m256i result = chunk;
+    for (size_t r = 0; r < runs; ++r) {
+      const __m256i shifted = _mm256_sub_epi8(chunk, firsts[r]);
+      const __m256i in_run =
+          _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, spans[r]), shifted);
+      result = _mm256_add_epi8(result, _mm256_and_si256(in_run, deltas[r]));
+    }
+    _mm256_storeu_si256(chunk_ptr, result);
+  }
+  translateBytesScalar(map, data + i, size - i);
+}
+
+__attribute__((target("avx512f,avx512bw"))) void translateBytesAvx512(
+    const ByteMap& map, char* data, size_t size) {
+  constexpr size_t kWidth = 64;
+  const size_t runs = map.runs.size();
+  __m512i firsts[kMaxVectorRuns];
+  __m512i spans[kMaxVectorRuns];
+  __m512i deltas[kMaxVectorRuns];
+  for (size_t r = 0; r < runs; ++r) {
+    const ByteRun& run = map.runs[r];
+    firsts[r] = _mm512_set1_epi8(static_cast<char>(run.first));
+    spans[r] = _mm512_set1_epi8(static_cast<char>(run.last - run.first));
+    deltas[r] = _mm512_set1_epi8(static_cast<char>(run.delta));
+  }
+
+  for (size_t i = 0; i < size; i += kWidth) {
+    const size_t left = size - i;
+    const __mmask64 valid =
+        left >= kWidth ? ~__mmask64{0} : (uint64_t{1} << left) - 1;
+    const __m512i chunk = _mm512_maskz_loadu_epi8(valid, data + i);
+    __m512i result = chunk;
+    for (size_t r = 0; r < runs; ++r) {
+      const __mmask64 in_run =
+          _mm512_cmple_epu8_mask(_mm512_sub_epi8(chunk, firsts[r]), spans[r]);
+      result = _mm512_mask_add_epi8(result, in_run, result, deltas[r]);
+    }
+    _mm512_mask_storeu_epi8(data + i, valid, result);
+  }
+}
+
+size_t findByteInSetSse2(const ByteSet& set, const char* data, size_t size) {
+  constexpr size_t kWidth = 16;
+  const size_t runs = set.runs.size();
+  __m128i firsts[kMaxVectorRuns];
+  __m128i spans[kMaxVectorRuns];
+  for (size_t r = 0; r < runs; ++r) {
+    firsts[r] = _mm_set1_epi8(static_cast<char>(set.runs[r].first));
+    spans[r] = _mm_set1_epi8(
+        static_cast<char>(set.runs[r].last - set.runs[r].first));
+  }
+
+  size_t i = 0;
+  for (; size - i >= kWidth; i += kWidth) {
+    const __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i hits = _mm_setzero_si128();
+    for (size_t r = 0; r < runs; ++r) {
+      const __m128i shifted = _mm_sub_epi8(chunk, firsts[r]);
+      hits = _mm_or_si128(
+          hits, _mm_cmpeq_epi8(_mm_min_epu8(shifted, spans[r]), shifted));
+    }
+    const auto mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+    if (mask != 0) {
+      return i + static_cast<size_t>(std::countr_zero(mask));
+    }
+  }
+  return i + findByteInSetScalar(set, data + i, size - i);
+}
+
+__attribute__((target("avx2"))) size_t findByteInSetAvx2(const ByteSet& set,
+                                                         const char* data,
+                                                         size_t size) {
+  constexpr size_t kWidth = 32;
+  const size_t runs = set.runs.size();
+  __m256i firsts[kMaxVectorRuns];
+  __m256i spans[kMaxVectorRuns];
+  for (size_t r = 0; r < runs; ++r) {
+    firsts[r] = _mm256_set1_epi8(static_cast<char>(set.runs[r].first));
+    spans[r] = _mm256_set1_epi8(
+        static_cast<char>(set.runs[r].last - set.runs[r].first));
+  }
+
+  size_t i = 0;
+  for (; size - i >= kWidth; i += kWidth) {
+    const __m256i chunk =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    __m256i hits = _mm256_setzero_si256();
+    for (size_t r = 0; r < runs; ++r) {
+      const __m256i shifted = _mm256_sub_epi8(chunk, firsts[r]);
+      hits = _mm256_or_si256(
+          hits,
+          _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, spans[r]), shifted));
+    }
+    const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+    if (mask != 0) {
+      return i + static_cast<size_t>(std::countr_zero(mask));
+    }
+  }
+  return i + findByteInSetScalar(set, data + i, size - i);
+}
+
+__attribute__((target("avx512f,avx512bw"))) size_t findByteInSetAvx512(
+    const ByteSet& set, const char* data, size_t size) {
+  constexpr size_t kWidth = 64;
+  const size_t runs = set.runs.size();
+  __m512i firsts[kMaxVectorRuns];
+  __m512i spans[kMaxVectorRuns];
+  for (size_t r = 0; r < runs; ++r) {
+    firsts[r] = _mm512_set1_epi8(static_cast<char>(set.runs[r].first));
+    spans[r] = _mm512_set1_epi8(
+        static_cast<char>(set.runs[r].last - set.runs[r].first));
+  }
+
+  for (size_t i = 0; i < size; i += kWidth) {
+    const size_t left = size - i;
+    const __mmask64 valid =
+        left >= kWidth ? ~__mmask64{0} : (uint64_t{1} << left) - 1;
+    const __m512i chunk = _mm512_maskz_loadu_epi8(valid, data + i);
+    __mmask64 hits = 0;
+    for (size_t r = 0; r < runs; ++r) {
+      hits |= _mm512_cmple_epu8_mask(_mm512_sub_epi8(chunk, firsts[r]),
+                                     spans[r]);
+    }
+    hits &= valid;
+    if (hits != 0) {
+      return i + static_cast<size_t>(std::countr_zero(hits));
+    }
+  }
+  return size;
+}
+
+#endif  // COREUTILS_X86_KERNELS
+
+}  // namespace
+
+size_t countByte(SimdLevel level, const char* data, size_t size, char byte) {
+  switch (level) {
+#ifdef COREUTILS_X86_KERNELS
+    case SimdLevel::kAvx512:
+      return countByteAvx512(data, size, byte);
+    case SimdLevel::kAvx2:
+      return countByteAvx2(data, size, byte);
+    case SimdLevel::kSse2:
+      return countByteSse2(data, size, byte);
+#endif
+    default:
+      return countByteScalar(data, size, byte);
+  }
+}
+
+size_t countByte(const char* data, size_t size, char byte) {
+  return countByte(simdLevel(), data, size, byte);
+}
+
+bool isWordSeparator(char ch) { return kIsSpace[static_cast<unsigned char>(ch)]; }
+
+TextCounts countText(SimdLevel level, const char* data, size_t size,
+                     bool& in_word) {
+  switch (level) {
+#ifdef COREUTILS_X86_KERNELS
+    case SimdLevel::kAvx512:
+      return countTextAvx512(data, size, in_word);
+    case SimdLevel::kAvx2:
+      return countTextAvx2(data, size, in_word);
+    case SimdLevel::kSse2:
+      return countTextSse2(data, size, in_word);
+#endif
+    default:
+      return countTextScalar(data, size, in_word);
+  }
+}
+
+TextCounts countUtf8Text(SimdLevel level, const char* data, size_t size,
+                         Utf8TextState& state) {
+  switch (level) {
+#ifdef COREUTILS_X86_KERNELS
+    case SimdLevel::kAvx512:
+      return countUtf8TextAvx512(data, size, state);
+    case SimdLevel::kAvx2:
+      return countUtf8TextAvx2(data, size, state);
+    case SimdLevel::kSse2:
+      return countUtf8TextSse2(data, size, state);
+#endif
+    default:
+      return countUtf8TextScalar(data, size, state);
+  }
+}
+
+TextCounts countUtf8Text(const char* data, size_t size, Utf8TextState& state) {
+  static const SimdLevel level = simdLevel();
+  return countUtf8Text(level, data, size, state);
+}
+
+void finishUtf8Text(TextCounts& counts, const Utf8TextState& state) {
+  counts.max_line_length = std::max(counts.max_line_length, state.line_length);
+}
+
+TextCounts countText(const char* data, size_t size, bool& in_word) {
+  // Resolved once; the kernel is called per buffer on the hot path.
+  static const SimdLevel level = simdLevel();
+  return countText(level, data, size, in_word);
+}
+
+void classifyShellChars(SimdLevel level, const char* data, size_t size,
+                        ShellCharMasks* out) {
+  switch (level) {
+#ifdef COREUTILS_X86_KERNELS
+    case SimdLevel::kAvx512:
+      return classifyShellCharsAvx512(data, size, out);
+    case SimdLevel::kAvx2:
+      return classifyShellCharsAvx2(data, size, out);
+    case SimdLevel::kSse2:
+      return classifyShellCharsSse2(data, size, out);
+#endif
+    default:
+      return classifyShellCharsScalar(data, size, out);
+  }
+}
+
+void classifyShellChars(const char* data, size_t size, ShellCharMasks* out) {
+  static const SimdLevel level = simdLevel();
+  classifyShellChars(level, data, size, out);
+}
+
+void maskBytePair(SimdLevel level, const char* data, size_t size, char first,
+                  char second, uint64_t* out) {
+  switch (level) {
+#ifdef COREUTILS_X86_KERNELS
+    case SimdLevel::kAvx512:
+      return maskBytePairAvx512(data, size, first, second, out);
+    case SimdLevel::kAvx2:
+      return maskBytePairAvx2(data, size, first, second, out);
+    case SimdLevel::kSse2:
+      return maskBytePairSse2(data, size, first, second, out);
+#endif
+    default:
+      return maskBytePairScalar(data, size, first, second, out);
+  }
+}
+
+void maskBytePair(const char* data, size_t size, char first, char second,
+                  uint64_t* out) {
+  static const SimdLevel level = simdLevel();
+  maskBytePair(level, data, size, first, second, out);
+}
+
+ByteMap makeByteMap(const std::array<uint8_t, 256>& table) {
+  ByteMap map{table, {}};
+  for (unsigned byte = 0; byte < table.size(); ++byte) {
+    if (table[byte] != byte) {
+      addToRuns(map.runs, byte, static_cast<uint8_t>(table[byte] - byte));
+    }
+  }
+  return map;
+}
+
+ByteSet makeByteSet(const std::bitset<256>& members) {
+  ByteSet set{members, {}};
+  for (unsigned byte = 0; byte < members.size(); ++byte) {
+    if (members[byte]) {
+      addToRuns(set.runs, byte, 0);
+    }
+  }
+  return set;
+}
+
+void translateBytes(SimdLevel level, const ByteMap& map, char* data,
+                    size_t size) {
+  if (map.runs.empty()) {
+    return;
+  }
+  if (map.runs.size() > kMaxVectorRuns) {
+    level = SimdLevel::kScalar;
+  }
+  switch (level) {
+#ifdef COREUTILS_X86_KERNELS
+    case SimdLevel::kAvx512:
+      return translateBytesAvx512(map, data, size);
+    case SimdLevel::kAvx2:
+      return translateBytesAvx2(map, data, size);
+    case SimdLevel::kSse2:
+      return translateBytesSse2(map, data, size);
+#endif
+    default:
+      return translateBytesScalar(map, data, size);
+  }
+}
+
+void translateBytes(const ByteMap& map, char* data, size_t size) {
+  static const SimdLevel level = simdLevel();
+  translateBytes(level, map, data, size);
+}
+
+size_t findByteInSet(SimdLevel level, const ByteSet& set, const char* data,
+                     size_t size) {
+  if (set.runs.size() > kMaxVectorRuns) {
+    level = SimdLevel::kScalar;
+  }
+  switch (level) {
+#ifdef COREUTILS_X86_KERNELS
+    case SimdLevel::kAvx512:
+      return findByteInSetAvx512(set, data, size);
+    case SimdLevel::kAvx2:
+      return findByteInSetAvx2(set, data, size);
+    case SimdLevel::kSse2:
+      return findByteInSetSse2(set, data, size);
+#endif
+    default:
+      return findByteInSetScalar(set, data, size);
+  }
+}
+
+size_t findByteInSet(const ByteSet& set, const char* data, size_t size) {
+  static const SimdLevel level = simdLevel();
+  return findByteInSet(level, set, data, size);
+}
+
+}  // namespace coreutils
@@ -0,0 +1,301 @@
+#include <tr_command.hpp>
+
+#include <builtin_registry.hpp>
+#include <fd_io.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace coreutils {
+
+namespace {
+
+constexpr size_t kBlockSize = 128 * 1024;
+
+using ClassPredicate = bool (*)(int);
+
+// The C-locale character classes, [:name:] in a set.
+constexpr std::array<std::pair<std::string_view, ClassPredicate>, 12>
+    kClasses{{
+        {"alnum", [](int ch) { return std::isalnum(ch) != 0; }},
+        {"alpha", [](int ch) { return std::isalpha(ch) != 0; }},
+        {"blank", [](int ch) { return std::isblank(ch) != 0; }},
+        {"cntrl", [](int ch) { return std::iscntrl(ch) != 0; }},
+        {"digit", [](int ch) { return std::isdigit(ch) != 0; }},
+        {"graph", [](int ch) { return std::isgraph(ch) != 0; }},
+        {"lower", [](int ch) { return std::islower(ch) != 0; }},
+        {"print", [](int ch) { return std::isprint(ch) != 0; }},
+        {"punct", [](int ch) { return std::ispunct(ch) != 0; }},
+        {"space", [](int ch) { return std::isspace(ch) != 0; }},
+        {"upper", [](int ch) { return std::isupper(ch) != 0; }},
+        {"xdigit", [](int ch) { return std::isxdigit(ch) != 0; }},
+    }};
+
+ClassPredicate findClass(std::string_view name) {
+  for (const auto& [class_name, predicate] : kClasses) {
+    if (class_name == name) {
+      return predicate;
+    }
+  }
+  throw std::invalid_argument("tr: invalid character class '" +
+                              std::string(name) + "'");
+}
+
+bool isOctalDigit(char ch) { return ch >= '0' && ch <= '7'; }
+
+// Reads the byte of a set at `pos`, decoding an escape.
+uint8_t readSetByte(std::string_view spec, size_t& pos) {
+  char ch = spec[pos++];
+  if (ch != '\\' || pos == spec.size()) {
+    return static_cast<uint8_t>(ch);
+  }
+  ch = spec[pos++];
+  if (isOctalDigit(ch)) {
+    unsigned value = ch - '0';
+    for (int digits = 1;
+         digits < 3 && pos < spec.size() && isOctalDigit(spec[pos]);
+         ++digits) {
+      value = value * 8 + (spec[pos++] - '0');
+    }
+    return static_cast<uint8_t>(value);
+  }
+  switch (ch) {
+    case 'a':
+      return '\a';
+    case 'b':
+      return '\b';
+    case 'f':
+      return '\f';
+    case 'n':
+      return '\n';
+    case 'r':
+      return '\r';
+    case 't':
+      return '\t';
+    case 'v':
+      return '\v';
+    default:
+      return static_cast<uint8_t>(ch);
+  }
+}
+
+// The bytes of a set in the order they are written, with ranges and
+// classes expanded.
+std::vector<uint8_t> expandSet(std::string_view spec) {
+  std::vector<uint8_t> bytes;
+  size_t pos = 0;
+  while (pos < spec.size()) {
+    const size_t class_end =
+        spec.substr(pos).starts_with("[:") ? spec.find(":]", pos + 2)
+                                           : std::string_view::npos;
+    if (class_end != std::string_view::npos) {
+      const std::string_view name = spec.substr(pos + 2, class_end - pos - 2);
+      const ClassPredicate predicate = findClass(name);
+      for (int ch = 0; ch < 256; ++ch) {
+        if (predicate(ch)) {
+          bytes.push_back(static_cast<uint8_t>(ch));
+        }
+      }
+      pos = class_end + 2;
+      continue;
+    }
+
+    const size_t start = pos;
+    const uint8_t first = readSetByte(spec, pos);
+    if (pos + 1 < spec.size() && spec[pos] == '-') {
+      ++pos;
+      const uint8_t last = readSetByte(spec, pos);
+      if (last < first) {
+        throw std::invalid_argument(
+            "tr: range-endpoints of '" +
+            std::string(spec.substr(start, pos - start)) +
+            "' are in reverse collating sequence order");
+      }
+      for (unsigned ch = first; ch <= last; ++ch) {
+        bytes.push_back(static_cast<uint8_t>(ch));
+      }
+      continue;
+    }
+    bytes.push_back(first);
+  }
+  return bytes;
+}
+
+std::bitset<256> toMembers(const std::vector<uint8_t>& bytes) {
+  std::bitset<256> members;
+  for (uint8_t byte : bytes) {
+    members.set(byte);
+  }
+  return members;
+}
+
+}  // namespace
+
+TrCommand::TrCommand(std::vector<std::string> args) {
+  bool complement = false;
+  size_t first_set = 0;
+  for (; first_set < args.size(); ++first_set) {
+    const std::string& arg = args[first_set];
+    if (arg == "--") {
+      ++first_set;
+      break;
+    }
+    if (arg.size() < 2 || arg[0] != '-') {
+      break;
+    }
+    for (char flag : std::string_view(arg).substr(1)) {
+      switch (flag) {
+        case 'c':
+        case 'C':
+          complement = true;
+          break;
+        case 'd':
+          delete_ = true;
+          break;
+        case 's':
+          squeeze_ = true;
+          break;
+        default:
+          throw std::invalid_argument(std::string("tr: invalid option -- '") +
+                                      flag + "'");
+      }
+    }
+  }
+
+  const std::vector<std::string> sets(args.begin() + first_set, args.end());
+  if (sets.empty()) {
+    throw std::invalid_argument("tr: missing operand");
+  }
+  // -d alone takes one set, translating and -ds two, and -s either.
+  const size_t max_sets = delete_ && !squeeze_ ? 1 : 2;
+  if (sets.size() > max_sets) {
+    throw std::invalid_argument("tr: extra operand '" + sets[max_sets] + "'");
+  }
+  if (sets.size() == 1 && delete_ == squeeze_) {
+    throw std::invalid_argument("tr: missing operand after '" + sets[0] +
+                                "'");
+  }
+
+  std::vector<uint8_t> set1 = expandSet(sets[0]);
+  if (complement) {
+    const std::bitset<256> members = toMembers(set1);
+    set1.clear();
+    for (unsigned byte = 0; byte < members.size(); ++byte) {
+      if (!members[byte]) {
+        set1.push_back(static_cast<uint8_t>(byte));
+      }
+    }
+  }
+  const std::vector<uint8_t> set2 =
+      sets.size() == 2 ? expandSet(sets[1]) : std::vector<uint8_t>{};
+
+  std::array<uint8_t, 256> table{};
+  for (unsigned byte = 0; byte < table.size(); ++byte) {
+    table[byte] = static_cast<uint8_t>(byte);
+  }
+  if (!delete_ && sets.size() == 2) {
+    if (set2.empty() && !set1.empty()) {
+      throw std::invalid_argument(
+          "tr: when not truncating set1, string2 must be non-empty");
+    }
+    for (size_t i = 0; i < set1.size(); ++i) {
+      table[set1[i]] = set2[std::min(i, set2.size() - 1)];
+    }
+  }
+  map_ = makeByteMap(table);
+  if (delete_) {
+    delete_set_ = makeByteSet(toMembers(set1));
+  }
+  if (squeeze_) {
+    squeeze_set_ = makeByteSet(toMembers(sets.size() == 2 ? set2 : set1));
+  }
+}
+
+// Moves the spans between deleted bytes down over them.
+size_t TrCommand::deleteBytes(char* data, size_t size) const {
+  size_t kept = 0;
+  size_t pos = 0;
+  while (pos < size) {
+    const size_t hit =
+        pos + findByteInSet(delete_set_, data + pos, size - pos);
+    if (kept != pos) {
+      std::memmove(data + kept, data + pos, hit - pos);
+    }
+    kept += hit - pos;
+    pos = hit + 1;
+  }
+  return kept;
+}
+
+// Keeps the first byte of each run of a repeated byte of the squeeze set.
+// `previous` is the last byte written before this block, or -1, so runs
+// are squeezed across blocks.
+size_t TrCommand::squeezeBytes(char* data, size_t size, int& previous) const {
+  size_t kept = 0;
+  size_t pos = 0;
+  while (pos < size) {
+    const size_t hit =
+        pos + findByteInSet(squeeze_set_, data + pos, size - pos);
+    if (kept != pos) {
+      std::memmove(data + kept, data + pos, hit - pos);
+    }
+    kept += hit - pos;
+    if (hit == size) {
+      break;
+    }
+    const char ch = data[hit];
+    for (pos = hit + 1; pos < size && data[pos] == ch; ++pos) {
+    }
+    const int before =
+        kept != 0 ? static_cast<unsigned char>(data[kept - 1]) : previous;
+    if (before != static_cast<unsigned char>(ch)) {
+      data[kept++] = ch;
+    }
+  }
+  if (kept != 0) {
+    previous = static_cast<unsigned char>(data[kept - 1]);
+  }
+  return kept;
+}
+
+int TrCommand::run(Input& in, Output& out) {
+  std::vector<char> block(kBlockSize);
+  int previous = -1;
+  try {
+    while (true) {
+      size_t size = readFd(in.fd(), block.data(), block.size());
+      if (size == 0) {
+        return 0;
+      }
+      if (delete_) {
+        size = deleteBytes(block.data(), size);
+      } else {
+        translateBytes(map_, block.data(), size);
+      }
+      if (squeeze_) {
+        size = squeezeBytes(block.data(), size, previous);
+      }
+      out.write(block.data(), size);
+    }
+  } catch (const std::system_error& e) {
+    std::cerr << "tr: " << e.what() << '\n';
+    return 1;
+  }
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{"tr", makeBuiltin<TrCommand>};
+
+}  // namespace
+
+}  // namespace coreutils
@@ -0,0 +1,85 @@
+#include <type_command.hpp>
+
+#include <builtin_registry.hpp>
+
+#include <unistd.h>
+
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace coreutils {
+
+namespace {
+
+// Mirrors the search of execvp(): a name with a slash is used as is,
+// anything else is looked up in the directories of PATH. An empty entry
+// stands for the working directory.
+std::optional<std::string> searchPath(const std::string& name,
+                                       const VariableStore& variables) {
+  if (name.find('/') != std::string::npos) {
+    return access(name.c_str(), X_OK) == 0 ? std::optional(name)
+                                           : std::nullopt;
+  }
+
+  const std::string* path = variables.find("PATH");
+  if (path == nullptr || name.empty()) {
+    return std::nullopt;
+  }
+
+  std::string candidate;
+  std::string_view dirs = *path;
+  while (true) {
+    const size_t colon = dirs.find(':');
+    const std::string_view dir = dirs.substr(0, colon);
+
+    candidate.assign(dir.empty() ? "." : dir);
+    candidate.append("/").append(name);
+    if (access(candidate.c_str(), X_OK) == 0) {
+      return candidate;
+    }
+
+    if (colon == std::string_view::npos) {
+      return std::nullopt;
+    }
+    dirs.remove_prefix(colon + 1);
+  }
+}
+
+}  // namespace
+
+int TypeCommand::run(Input& /*in*/, Output& out) {
+  int status = 0;
+  std::string result;
+  for (const auto& name : args_) {
+    if (BuiltinRegistry::instance().find(name) != nullptr) {
+      result.append(name).append(" is a shell builtin\n");
+      continue;
+    }
+
+    if (auto program = searchPath(name, variables_)) {
+      result.append(name).append(" is ").append(*program).push_back('\n');
+      continue;
+    }
+
+    std::cerr << "type: " << name << ": not found\n";
+    status = 1;
+  }
+  out.write(result);
+  return status;
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{
+    "type",
+    [](std::vector<std::string> args,
+       const BuiltinContext& context) -> std::unique_ptr<Command> {
+      return std::make_unique<TypeCommand>(std::move(args), context.variables);
+    }};
+
+}  // namespace
+
+}  // namespace coreutils
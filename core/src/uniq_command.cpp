@@ -0,0 +1,203 @@
+#include <uniq_command.hpp>
+
+#include <buffered_writer.hpp>
+#include <builtin_registry.hpp>
+#include <fd_io.hpp>
+#include <line_counter.hpp>
+#include <output.hpp>
+#include <unique_fd.hpp>
+
+#include <fcntl.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+namespace coreutils {
+
+namespace {
+
+constexpr size_t kReadSize = 64 * 1024;
+
+// The file named by the OUTPUT operand.
+class FileOutput final : public Output {
+ public:
+  explicit FileOutput(int fd) : fd_(fd) {}
+  [[nodiscard]] int fd() const override { return fd_; }
+
+ private:
+  int fd_;
+};
+
+}  // namespace
+
+UniqCommand::UniqCommand(std::vector<std::string> args) {
+  for (const auto& arg : args) {
+    if (arg == "--unsorted") {
+      unsorted_ = true;
+      continue;
+    }
+    if (arg.size() < 2 || arg[0] != '-') {
+      if (files_.empty()) {
+        files_.push_back(arg);
+      } else if (output_.empty()) {
+        output_ = arg;
+      } else {
+        throw std::invalid_argument("uniq: extra operand '" + arg + "'");
+      }
+      continue;
+    }
+    for (char flag : std::string_view(arg).substr(1)) {
+      switch (flag) {
+        case 'c':
+          show_counts_ = true;
+          break;
+        case 'd':
+          repeated_only_ = true;
+          break;
+        case 'u':
+          unique_only_ = true;
+          break;
+        default:
+          throw std::invalid_argument(std::string("uniq: invalid option -- '") +
+                                      flag + "'");
+      }
+    }
+  }
+}
+
+void UniqCommand::writeGroup(BufferedWriter& writer, std::string_view line,
+                             uint64_t count) const {
+  if ((repeated_only_ && count == 1) || (unique_only_ && count > 1)) {
+    return;
+  }
+  if (show_counts_) {
+    std::array<char, 32> prefix{};
+    const int size =
+        std::snprintf(prefix.data(), prefix.size(), "%7llu ",
+                      static_cast<unsigned long long>(count));
+    writer.write({prefix.data(), static_cast<size_t>(size)});
+  }
+  writer.write(line);
+  writer.put('\n');
+}
+
+// Only the current group's line is kept; each block of input is scanned
+// for whole lines and the partial last line is carried into the next one.
+int UniqCommand::runStreaming(Input& in, Output& out) const {
+  BufferedWriter writer(out);
+  std::string previous;
+  uint64_t count = 0;
+  auto take = [&](std::string_view line) {
+    if (count != 0 && line == previous) {
+      ++count;
+      return;
+    }
+    if (count != 0) {
+      writeGroup(writer, previous, count);
+    }
+    previous.assign(line);
+    count = 1;
+  };
+
+  auto read_lines = [&](int fd) {
+    std::string text;
+    while (true) {
+      const size_t used = text.size();
+      text.resize(used + kReadSize);
+      const size_t size = readFd(fd, text.data() + used, kReadSize);
+      text.resize(used + size);
+      if (size == 0) {
+        break;
+      }
+      size_t pos = 0;
+      for (size_t newline = text.find('\n', used);
+           newline != std::string::npos; newline = text.find('\n', pos)) {
+        take(std::string_view(text).substr(pos, newline - pos));
+        pos = newline + 1;
+      }
+      text.erase(0, pos);
+    }
+    // A last line without a newline is still a line.
+    if (!text.empty()) {
+      take(text);
+    }
+  };
+
+  int status = 0;
+  try {
+    if (files_.empty()) {
+      read_lines(in.fd());
+    }
+    for (const auto& file : files_) {
+      if (file == "-") {
+        read_lines(in.fd());
+        continue;
+      }
+      UniqueFd fd(open(file.c_str(), O_RDONLY | O_CLOEXEC));
+      if (!fd) {
+        std::cerr << "uniq: " << file << ": " << std::strerror(errno) << '\n';
+        status = 1;
+        continue;
+      }
+      read_lines(fd.get());
+    }
+  } catch (const std::system_error& e) {
+    std::cerr << "uniq: " << e.what() << '\n';
+    status = 1;
+  }
+
+  if (count != 0) {
+    writeGroup(writer, previous, count);
+  }
+  writer.flush();
+  return status;
+}
+
+int UniqCommand::runUnsorted(Input& in, Output& out) const {
+  LineCounter counter;
+  const bool ok = countLines(files_, in, "uniq", counter);
+
+  using Entry = LineCounter::Entry;
+  std::vector<const Entry*> order;
+  order.reserve(counter.entries().size());
+  for (const Entry& entry : counter.entries()) {
+    order.push_back(&entry);
+  }
+  std::ranges::sort(order, {}, &Entry::first);
+
+  BufferedWriter writer(out);
+  for (const Entry* entry : order) {
+    writeGroup(writer, entry->line, entry->count);
+  }
+  writer.flush();
+  return ok ? 0 : 1;
+}
+
+int UniqCommand::run(Input& in, Output& out) {
+  if (output_.empty() || output_ == "-") {
+    return unsorted_ ? runUnsorted(in, out) : runStreaming(in, out);
+  }
+
+  UniqueFd fd(open(output_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                   0666));
+  if (!fd) {
+    std::cerr << "uniq: " << output_ << ": " << std::strerror(errno) << '\n';
+    return 1;
+  }
+  FileOutput file(fd.get());
+  return unsorted_ ? runUnsorted(in, file) : runStreaming(in, file);
+}
+
+namespace {
+
+const BuiltinRegistrar kRegistrar{"uniq", makeBuiltin<UniqCommand>};
+
+}  // namespace
+
+}  // namespace coreutils
@@ -0,0 +1,143 @@
+#include <variable_store.hpp>
+
+#include <functional>
+#include <string>
+
+namespace coreutils {
+
+namespace {
+
+size_t hashName(std::string_view name) {
+  return std::hash<std::string_view>{}(name);
+}
+
+}  // namespace
+
+VariableStore::VariableStore(const VariableStore& other)
+    : variables_(other.variables_), slots_(other.slots_) {}
+
+VariableStore& VariableStore::operator=(const VariableStore& other) {
+  if (this != &other) {
+    variables_ = other.variables_;
+    slots_ = other.slots_;
+    env_strings_.clear();
+    envp_.clear();
+    envp_stale_ = true;
+  }
+  return *this;
+}
+
+void VariableStore::importEnvironment(char* const* env) {
+  for (; *env != nullptr; ++env) {
+    const std::string_view entry = *env;
+    const size_t eq_pos = entry.find('=');
+    if (eq_pos == std::string_view::npos || eq_pos == 0) {
+      continue;
+    }
+    Variable& variable = findOrInsert(entry.substr(0, eq_pos));
+    variable.value = entry.substr(eq_pos + 1);
+    variable.assigned = true;
+    variable.exported = true;
+  }
+  envp_stale_ = true;
+}
+
+uint32_t VariableStore::indexOf(std::string_view name, size_t hash) const {
+  if (slots_.empty()) {
+    return kEmptySlot;
+  }
+
+  const size_t mask = slots_.size() - 1;
+  for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+    const uint32_t index = slots_[slot];
+    if (index == kEmptySlot || (variables_[index].hash == hash &&
+                                variables_[index].name == name)) {
+      return index;
+    }
+  }
+}
+
+const VariableStore::Variable* VariableStore::lookup(
+    std::string_view name) const {
+  const uint32_t index = indexOf(name, hashName(name));
+  return index == kEmptySlot ? nullptr : &variables_[index];
+}
+
+const std::string* VariableStore::find(std::string_view name) const {
+  const Variable* variable = lookup(name);
+  return variable != nullptr && variable->assigned ? &variable->value
+                                                   : nullptr;
+}
+
+bool VariableStore::isExported(std::string_view name) const {
+  const Variable* variable = lookup(name);
+  return variable != nullptr && variable->exported;
+}
+
+VariableStore::Variable& VariableStore::findOrInsert(std::string_view name) {
+  const size_t hash = hashName(name);
+  if (const uint32_t index = indexOf(name, hash); index != kEmptySlot) {
+    return variables_[index];
+  }
+
+  if ((variables_.size() + 1) * 2 > slots_.size()) {
+    rehash(slots_.empty() ? kInitialSlots : slots_.size() * 2);
+  }
+
+  const size_t mask = slots_.size() - 1;
+  size_t slot = hash & mask;
+  while (slots_[slot] != kEmptySlot) {
+    slot = (slot + 1) & mask;
+  }
+  slots_[slot] = static_cast<uint32_t>(variables_.size());
+  return variables_.emplace_back(Variable{std::string(name), {}, hash});
+}
+
+void VariableStore::rehash(size_t slot_count) {
+  slots_.assign(slot_count, kEmptySlot);
+  const size_t mask = slot_count - 1;
+  for (size_t index = 0; index < variables_.size(); ++index) {
+    size_t slot = variables_[index].hash & mask;
+    while (slots_[slot] != kEmptySlot) {
+      slot = (slot + 1) & mask;
+    }
+    slots_[slot] = static_cast<uint32_t>(index);
+  }
+}
+
+void VariableStore::set(std::string_view name, std::string_view value) {
+  Variable& variable = findOrInsert(name);
+  if (variable.exported && (!variable.assigned || variable.value != value)) {
+    envp_stale_ = true;
+  }
+  variable.value = value;
+  variable.assigned = true;
+}
+
+void VariableStore::exportVariable(std::string_view name) {
+  Variable& variable = findOrInsert(name);
+  if (!variable.exported && variable.assigned) {
+    envp_stale_ = true;
+  }
+  variable.exported = true;
+}
+
+char* const* VariableStore::envp() const {
+  if (envp_stale_) {
+    env_strings_.clear();
+    for (const auto& variable : variables_) {
+      if (variable.exported && variable.assigned) {
+        env_strings_.push_back(variable.name + '=' + variable.value);
+      }
+    }
+    envp_.clear();
+    for (auto& entry : env_strings_) {
+      envp_.push_back(entry.data());
+    }
+    envp_.push_back(nullptr);
+    envp_stale_ = false;
+  }
+  return envp_.data();
+}
+
+}  // namespace coreutils
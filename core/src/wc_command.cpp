@@ -1,76 +1,132 @@
 #include <wc_command.hpp>
 
-#include <cctype>
-#include <fstream>
+#include <builtin_registry.hpp>
+#include <fd_io.hpp>
+#include <mapped_file.hpp>
+#include <parallel.hpp>
+#include <text_kernels.hpp>
+#include <unique_fd.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
 #include <iostream>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <system_error>
 #include <vector>
 
 namespace coreutils {
 
 namespace {
 
-constexpr size_t kBufferSize = 4096;
+constexpr size_t kBufferSize = 64 * 1024;
+// Regular files of at least kParallelThreshold bytes are mmapped and split
+// into kChunkSize pieces that are counted on the worker pool.
+constexpr size_t kChunkSize = 4 * 1024 * 1024;
+constexpr size_t kParallelThreshold = 4 * kChunkSize;
 
-struct FileStats {
-  size_t lines{};
-  size_t words{};
-  size_t bytes{};
-};
+using FileStats = TextCounts;
 
-[[nodiscard]] FileStats collectStats(auto reader) {
-  FileStats stats{};
-  bool in_word = false;
-  std::vector<char> buffer = reader(kBufferSize);
-  while (!buffer.empty()) {
-    stats.bytes += static_cast<size_t>(buffer.size());
-    for (char ch : buffer) {
-      if (ch == '\n') {
-        ++stats.lines;
-      }
-
-      if (std::isspace(ch) != 0) {
-        if (in_word) {
-          ++stats.words;
-          in_word = false;
-        }
-      } else {
-        in_word = true;
-      }
-    }
+FileStats countBlock(WcCommand::Kernel kernel, const char* data, size_t size,
+                     Utf8TextState& state) {
+  switch (kernel) {
+    case WcCommand::Kernel::kBytes:
+      return {.bytes = size};
+    case WcCommand::Kernel::kLines:
+      return {.lines = countByte(data, size, '\n'), .bytes = size};
+    case WcCommand::Kernel::kFull:
+      return countText(data, size, state.in_word);
+    case WcCommand::Kernel::kUtf8:
+      return countUtf8Text(data, size, state);
+  }
+  return {};
+}
 
-    buffer = reader(kBufferSize);
+// `reader(data, size)` fills the buffer and returns the number of bytes read,
+// 0 at the end of input.
+[[nodiscard]] FileStats collectStats(WcCommand::Kernel kernel, auto reader) {
+  FileStats stats{};
+  Utf8TextState state{};
+  std::vector<char> buffer(kBufferSize);
+  for (size_t size = reader(buffer.data(), buffer.size()); size != 0;
+       size = reader(buffer.data(), buffer.size())) {
+    stats += countBlock(kernel, buffer.data(), size, state);
   }
+  finishUtf8Text(stats, state);
+  return stats;
+}
 
-  if (in_word) {
-    ++stats.words;
+// Byte count of a regular file from its metadata alone, measured from the
+// current offset. Returns false when the size has to be found by reading
+// (not a regular file, or procfs-style files that report size 0).
+bool sizeFromMetadata(int fd, size_t& bytes) {
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+    return false;
   }
+  const off_t offset = lseek(fd, 0, SEEK_CUR);
+  if (offset < 0) {
+    return false;
+  }
+  bytes = offset < st.st_size ? static_cast<size_t>(st.st_size - offset) : 0;
+  return true;
+}
 
-  return stats;
+// Right-aligns the value in an 8-character field; wider values still get
+// one leading space so that adjacent fields never run together.
+void appendField(std::string& result, size_t value) {
+  constexpr size_t kFieldWidth = 8;
+  std::array<char, 24> digits{};
+  auto [end, ec] =
+      std::to_chars(digits.data(), digits.data() + digits.size(), value);
+  const auto length = static_cast<size_t>(end - digits.data());
+  result.append(length < kFieldWidth ? kFieldWidth - length : 1, ' ');
+  result.append(digits.data(), length);
 }
 
-std::string toString(const FileStats& stats, bool lines, bool words,
-                     bool bytes) {
-  std::string result;
-  constexpr int kFieldWidth = 8;
+struct FileResult {
+  FileStats stats{};
+  bool failed{false};
+  std::unique_ptr<MappedFile> mapping;  // set for files split into chunks
+};
+
+struct Chunk {
+  size_t file;
+  size_t offset;
+  size_t size;
+  FileStats stats{};
+};
+
+}  // namespace
 
-  if (lines) {
-    std::string line_str = std::to_string(stats.lines);
-    result += std::string(kFieldWidth - line_str.length(), ' ') + line_str;
+// Columns follow GNU wc: lines, words, characters, bytes, longest line.
+std::string WcCommand::toString(const TextCounts& stats) const {
+  std::string result;
+  if (count_lines_) {
+    appendField(result, stats.lines);
+  }
+  if (count_words_) {
+    appendField(result, stats.words);
+  }
+  if (count_chars_) {
+    appendField(result, stats.chars);
   }
-  if (words) {
-    std::string word_str = std::to_string(stats.words);
-    result += std::string(kFieldWidth - word_str.length(), ' ') + word_str;
+  if (count_bytes_) {
+    appendField(result, stats.bytes);
   }
-  if (bytes) {
-    std::string byte_str = std::to_string(stats.bytes);
-    result += std::string(kFieldWidth - byte_str.length(), ' ') + byte_str;
+  if (max_line_length_) {
+    appendField(result, stats.max_line_length);
   }
   return result;
 }
 
-}  // namespace
-
 WcCommand::WcCommand(std::vector<std::string> args) {
   for (const auto& arg : args) {
     if (arg == "-l") {
@@ -79,53 +135,146 @@ WcCommand::WcCommand(std::vector<std::string> args) {
       count_words_ = true;
     } else if (arg == "-c") {
       count_bytes_ = true;
+    } else if (arg == "-m") {
+      count_chars_ = true;
+    } else if (arg == "-L") {
+      max_line_length_ = true;
     } else if (!arg.empty() && arg[0] != '-') {
       files_.push_back(arg);
     }
   }
 
-  if (!count_lines_ && !count_words_ && !count_bytes_) {
+  if (!count_lines_ && !count_words_ && !count_bytes_ && !count_chars_ &&
+      !max_line_length_) {
     count_lines_ = true;
     count_words_ = true;
     count_bytes_ = true;
   }
+
+  if (count_chars_ || max_line_length_) {
+    kernel_ = Kernel::kUtf8;
+  } else if (count_words_) {
+    kernel_ = Kernel::kFull;
+  } else if (count_lines_) {
+    kernel_ = Kernel::kLines;
+  } else {
+    kernel_ = Kernel::kBytes;
+  }
 }
 
 int WcCommand::run(Input& in, Output& out) {
   if (files_.empty()) {
-    FileStats stats =
-        collectStats([&in](size_t size) { return in.readVector(size); });
+    FileStats stats{};
+    // `wc -c < file`: answer from fstat and consume the input by seeking,
+    // like reading it to the end would have.
+    if (kernel_ == Kernel::kBytes && sizeFromMetadata(in.fd(), stats.bytes)) {
+      lseek(in.fd(), 0, SEEK_END);
+    } else {
+      stats = collectStats(kernel_, [&in](char* data, size_t size) {
+        return in.read(data, size);
+      });
+    }
 
-    auto result =
-        toString(stats, count_lines_, count_words_, count_bytes_) + "\n";
+    auto result = toString(stats) + "\n";
     out.write(result);
     return 0;
   }
 
-  int exit_code = 0;
-  for (const auto& file : files_) {
+  std::vector<FileResult> results(files_.size());
+  std::vector<Chunk> chunks;
+  std::mutex chunks_mutex;
+
+  // Small files are counted whole on a worker; large regular files only get
+  // mapped here and are split into chunks for the second pass.
+  parallelFor(files_.size(), workerCount(), [&](size_t index, size_t) {
+    auto& result = results[index];
+    const auto& file = files_[index];
     try {
-      std::ifstream stream(file, std::ios::binary);
-      if (!stream.is_open()) {
-        throw std::runtime_error("Unable to open file: " + file);
+      UniqueFd fd(open(file.c_str(), O_RDONLY | O_CLOEXEC));
+      if (!fd) {
+        throw std::system_error(errno, std::generic_category(), file);
       }
-      auto stats =
-          collectStats([stream = std::move(stream)](size_t size) mutable {
-            std::vector<char> buf(size);
-            stream.read(buf.data(), static_cast<std::streamsize>(size));
-            buf.resize(stream.gcount());
-            return buf;
-          });
-      auto line = toString(stats, count_lines_, count_words_, count_bytes_) +
-                  " " + file + "\n";
-      out.write(line);
-    } catch (const std::runtime_error&) {
-      std::cerr << "Unable to open file: " << file << '\n';
+
+      if (kernel_ == Kernel::kBytes &&
+          sizeFromMetadata(fd.get(), result.stats.bytes)) {
+        return;
+      }
+
+      // The longest line may straddle chunks and its length depends on the
+      // columns before it, so -L always counts a file in one pass.
+      struct stat st {};
+      if (!max_line_length_ && fstat(fd.get(), &st) == 0 &&
+          S_ISREG(st.st_mode) &&
+          static_cast<size_t>(st.st_size) >= kParallelThreshold) {
+        fd.reset();
+        result.mapping = std::make_unique<MappedFile>(file);
+        const size_t size = result.mapping->view().size();
+        std::lock_guard lock(chunks_mutex);
+        for (size_t offset = 0; offset < size; offset += kChunkSize) {
+          chunks.push_back(
+              {index, offset, std::min(kChunkSize, size - offset)});
+        }
+        return;
+      }
+
+      result.stats = collectStats(kernel_, [&fd](char* data, size_t size) {
+        return readFd(fd.get(), data, size);
+      });
+    } catch (const std::system_error&) {
+      result.failed = true;
+    }
+  });
+
+  parallelFor(chunks.size(), workerCount(), [&](size_t index, size_t) {
+    auto& chunk = chunks[index];
+    const auto view = results[chunk.file].mapping->view();
+    Utf8TextState state{};
+    chunk.stats =
+        countBlock(kernel_, view.data() + chunk.offset, chunk.size, state);
+  });
+
+  // Every chunk was counted as if it started after whitespace, so a word
+  // crossing a chunk boundary was counted twice.
+  for (const auto& chunk : chunks) {
+    auto& stats = results[chunk.file].stats;
+    stats += chunk.stats;
+    const auto view = results[chunk.file].mapping->view();
+    if (count_words_ && chunk.offset > 0 &&
+        !isWordSeparator(view[chunk.offset - 1]) &&
+        !isWordSeparator(view[chunk.offset])) {
+      --stats.words;
+    }
+  }
+
+  int exit_code = 0;
+  FileStats total{};
+  std::string output;
+  for (size_t i = 0; i < files_.size(); ++i) {
+    if (results[i].failed) {
+      std::cerr << "Unable to open file: " << files_[i] << '\n';
       exit_code = 1;
+      continue;
     }
+    total += results[i].stats;
+    output += toString(results[i].stats);
+    output.push_back(' ');
+    output += files_[i];
+    output.push_back('\n');
   }
 
+  if (files_.size() > 1) {
+    output += toString(total);
+    output += " total\n";
+  }
+
+  out.write(output);
   return exit_code;
 }
 
+namespace {
+
+const BuiltinRegistrar kRegistrar{"wc", makeBuiltin<WcCommand>};
+
+}  // namespace
+
 }  // namespace coreutils
@@ -1,18 +1,62 @@
 #include <cli.hpp>
+#include <mapped_file.hpp>
 #include <std_output.hpp>
 #include <std_input.hpp>
 
 #include <iostream>
+#include <optional>
+#include <string_view>
+#include <system_error>
 
-int main() {
+namespace {
+
+constexpr std::string_view kUsage = "usage: CLI [-c command | script]";
+
+// The interpreter line of an executable script is not a command.
+std::string_view skipShebang(std::string_view script) {
+  if (!script.starts_with("#!")) {
+    return script;
+  }
+  const size_t newline = script.find('\n');
+  return newline == std::string_view::npos ? std::string_view{}
+                                           : script.substr(newline + 1);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
   coreutils::Parser parser;
   coreutils::StdOutput output;
   coreutils::StdInput input;
 
   coreutils::CLI cli{parser};
 
+  const std::string_view mode = argc > 1 ? argv[1] : "";
+  if ((mode == "-c" && argc != 3) || (mode != "-c" && argc > 2)) {
+    std::cerr << kUsage << '\n';
+    return 2;
+  }
+
+  // The script is mapped whole, so stdin stays untouched for the commands
+  // it runs.
+  std::optional<coreutils::MappedFile> script;
+  if (argc == 2 && mode != "-c") {
+    try {
+      script.emplace(argv[1]);
+    } catch (const std::system_error& ex) {
+      std::cerr << "CLI: " << argv[1] << ": " << ex.code().message() << '\n';
+      return 127;
+    }
+  }
+
   try {
-    cli.runCli(input, output);
+    if (mode == "-c") {
+      return cli.runScript(argv[2], input, output);
+    }
+    if (script) {
+      return cli.runScript(skipShebang(script->view()), input, output);
+    }
+    return cli.runCli(input, output);
   } catch (const std::exception& ex) {
     std::cerr << ex.what() << '\n';
     return -1;
@@ -0,0 +1,71 @@
+#include <command.hpp>
+#include <plugin_api.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Sample plugin: `rev`, which reverses the characters of every line of its
+// stdin. Load it with `enable -f librev_plugin.so rev`.
+
+namespace coreutils::plugins {
+
+namespace {
+
+constexpr size_t kReadSize = 64 * 1024;
+
+class RevCommand final : public Command {
+ public:
+  explicit RevCommand(std::vector<std::string> args) {
+    if (!args.empty()) {
+      throw std::invalid_argument("rev: only reads stdin");
+    }
+  }
+
+  int run(Input& in, Output& out) override {
+    std::string pending;
+    std::string result;
+    std::vector<char> block(kReadSize);
+
+    while (true) {
+      const size_t size = in.read(block.data(), block.size());
+      pending.append(block.data(), size);
+
+      // Complete lines are reversed in place of the block; a partial last
+      // line waits for the next read, or for EOF.
+      size_t line_begin = 0;
+      for (size_t newline = pending.find('\n'); newline != std::string::npos;
+           newline = pending.find('\n', line_begin)) {
+        result.append(pending.rbegin() + (pending.size() - newline),
+                      pending.rbegin() + (pending.size() - line_begin));
+        result.push_back('\n');
+        line_begin = newline + 1;
+      }
+      pending.erase(0, line_begin);
+
+      if (size == 0) {
+        std::ranges::reverse(pending);
+        result.append(pending);
+      }
+      if (!result.empty()) {
+        out.write(result);
+        result.clear();
+      }
+      if (size == 0) {
+        return 0;
+      }
+    }
+  }
+};
+
+const Builtin kBuiltins[] = {
+    {"rev", makeBuiltin<RevCommand>},
+};
+
+}  // namespace
+
+}  // namespace coreutils::plugins
+
+COREUTILS_PLUGIN(coreutils::plugins::kBuiltins)
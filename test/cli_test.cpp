@@ -77,4 +77,184 @@ TEST_F(CLITest, RunCliCdAffectsExternalCommand) {
   EXPECT_EQ(output.read(), target.string() + "\n");
 }
 
+TEST_F(CLITest, RunCliAssemblesLinesAcrossReads) {
+  // Lines longer than a pipe read arrive in several pieces.
+  const std::string word(100000, 'x');
+  std::string script;
+  for (int i = 0; i < 3; ++i) {
+    script += "echo " + word + "\n";
+  }
+  script += "echo done";
+
+  TextOutput output;
+  TextInput input(script);
+  EXPECT_EQ(cli->runCli(input, output), 0);
+  const std::string line = word + "\n";
+  EXPECT_EQ(output.read(), line + line + line + "done\n");
+}
+
+TEST_F(CLITest, RunScriptRunsEveryLineAndStopsAtExit) {
+  TextOutput output;
+  TextInput input("");
+  EXPECT_EQ(cli->runScript("echo a\n\necho b | wc -l\nexit\necho c\n",
+                           input, output),
+            0);
+  EXPECT_EQ(output.read(), "a\n       1\n");
+  EXPECT_TRUE(IsExit);
+}
+
+TEST_F(CLITest, EarlyPipelineStagesDoNotChangeTheShell) {
+  ScopedChdir guard;
+  const auto target = std::filesystem::path(TEST_DATA_DIR);
+
+  TextOutput output;
+  TextInput input("cd " + target.string() +
+                  "\n"
+                  "cd / | echo a\n"
+                  "pwd\n"
+                  "export ZZZ_EARLY_STAGE=1 | echo b\n"
+                  "export | grep ZZZ_EARLY_STAGE\n"
+                  "exit | echo c\n"
+                  "echo still here\n");
+  EXPECT_NO_THROW(cli->runCli(input, output));
+  EXPECT_EQ(output.read(),
+            "a\n" + target.string() + "\nb\nc\nstill here\n");
+  EXPECT_FALSE(IsExit);
+}
+
+TEST_F(CLITest, ExportPassesVariablesToChildren) {
+  TextOutput output;
+  TextInput input(
+      "LOCAL=1\n"
+      "export SHARED=2\n"
+      "sh -c 'echo [$LOCAL][$SHARED]'\n"
+      "export LOCAL\n"
+      "sh -c 'echo [$LOCAL][$SHARED]'\n");
+  EXPECT_NO_THROW(cli->runCli(input, output));
+  EXPECT_EQ(output.read(), "[][2]\n[1][2]\n");
+}
+
+TEST_F(CLITest, ExportListsExportedVariables) {
+  TextOutput output;
+  TextInput input("export ZZZ_EXPORT_TEST=1\nexport | grep ZZZ_EXPORT\n");
+  EXPECT_NO_THROW(cli->runCli(input, output));
+  EXPECT_EQ(output.read(), "export ZZZ_EXPORT_TEST=1\n");
+}
+
+TEST_F(CLITest, CommandSubstitutionOfBuiltins) {
+  ScopedChdir guard;
+  const auto target = std::filesystem::path(TEST_DATA_DIR);
+
+  TextOutput output;
+  TextInput input("cd " + target.string() +
+                  "\n"
+                  "echo [$(pwd)]\n"
+                  "echo \"$(echo a b c | wc -w)\" words\n"
+                  "echo $(echo $(echo deep) `echo tick`)\n"
+                  "echo $(cat file.txt | wc -l) lines\n");
+  EXPECT_NO_THROW(cli->runCli(input, output));
+  EXPECT_EQ(output.read(), "[" + target.string() +
+                               "]\n"
+                               "       3 words\n"
+                               "deep tick\n"
+                               "15 lines\n");
+}
+
+TEST_F(CLITest, AssignmentCapturesCommandOutput) {
+  ScopedChdir guard;
+  const auto target = std::filesystem::path(TEST_DATA_DIR);
+
+  TextOutput output;
+  TextInput input("cd " + target.string() +
+                  "\n"
+                  "X=$(pwd)\n"
+                  "echo [$X]\n"
+                  "Y=`pwd`\n"
+                  "echo [$Y]\n"
+                  "Z=$(echo a   b)-$X\n"
+                  "echo \"[$Z]\"\n");
+  EXPECT_NO_THROW(cli->runCli(input, output));
+  // The value is not split into words, so the spaces survive.
+  EXPECT_EQ(output.read(), "[" + target.string() + "]\n[" +
+                               target.string() + "]\n[a b-" +
+                               target.string() + "]\n");
+}
+
+TEST_F(CLITest, CommandSubstitutionKeepsCwdInTheSubshell) {
+  ScopedChdir guard;
+  const auto target = std::filesystem::path(TEST_DATA_DIR);
+
+  TextOutput output;
+  TextInput input("cd " + target.string() + "\necho [$(cd /)]\npwd\n");
+  EXPECT_NO_THROW(cli->runCli(input, output));
+  EXPECT_EQ(output.read(), "[]\n" + target.string() + "\n");
+}
+
+TEST_F(CLITest, CommandSubstitutionKeepsAssignmentsInTheSubshell) {
+  TextOutput output;
+  TextInput input("Y=1\necho $(Y=5) $(Y=6 echo $Y)\necho [$Y]\n");
+  EXPECT_NO_THROW(cli->runCli(input, output));
+  EXPECT_EQ(output.read(), "6\n[1]\n");
+}
+
+TEST_F(CLITest, CommandSubstitutionExitOnlyLeavesTheSubshell) {
+  TextOutput output;
+  TextInput input("echo [$(exit)]\necho still here\n");
+  EXPECT_NO_THROW(cli->runCli(input, output));
+  EXPECT_EQ(output.read(), "[]\nstill here\n");
+  EXPECT_FALSE(IsExit);
+}
+
+TEST_F(CLITest, CommandSubstitutionOfExternalPipeline) {
+  TextOutput output;
+  TextInput input("echo <$(printf 'a\\nb\\n' | wc -l)> $(cat /dev/null)!\n");
+  EXPECT_NO_THROW(cli->runCli(input, output));
+  // The padded count of the wc builtin is split off the '<'.
+  EXPECT_EQ(output.read(), "< 2> !\n");
+}
+
+TEST_F(CLITest, CommandSubstitutionCopiesFilesIntoMemory) {
+  const std::string path = std::string(TEST_DATA_DIR) + "/file.txt";
+
+  TextOutput output;
+  TextInput input("echo \"$(cat " + path + ")\"\ncat " + path + "\n");
+  EXPECT_NO_THROW(cli->runCli(input, output));
+  // cat writes into the memory output of the substitution with plain
+  // writes, and echo restores the one trailing newline it stripped.
+  const std::string& text = output.read();
+  const size_t half = text.size() / 2;
+  EXPECT_GT(half, 0);
+  EXPECT_EQ(text.substr(0, half), text.substr(half));
+}
+
+TEST_F(CLITest, TypeAndBuiltinResolveNames) {
+  TextOutput output;
+  TextInput input(
+      "type echo sh\n"
+      "type no-such-command\n"
+      "builtin echo from builtin\n"
+      "builtin sh -c 'echo no'\n"
+      "pwd extra\n"
+      "echo still running\n");
+  EXPECT_EQ(cli->runCli(input, output), 0);
+
+  const std::string& text = output.read();
+  EXPECT_TRUE(text.starts_with("echo is a shell builtin\nsh is /")) << text;
+  EXPECT_TRUE(text.ends_with("/sh\nfrom builtin\nstill running\n")) << text;
+}
+
+TEST_F(CLITest, EnableLoadsPluginBuiltins) {
+  const std::string enable = "enable -f " REV_PLUGIN_PATH;
+
+  TextOutput output;
+  TextInput input(enable + " rev\n" + enable +
+                  " rev\n"
+                  "echo abc def | rev\n"
+                  "printf 'ab\\ncd' | rev\n"
+                  "type rev\n" +
+                  enable + " no-such-builtin\n");
+  EXPECT_EQ(cli->runCli(input, output), 1);
+  EXPECT_EQ(output.read(), "fed cba\nba\ndcrev is a shell builtin\n");
+}
+
 }  // namespace coreutils::test
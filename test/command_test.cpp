@@ -1,22 +1,52 @@
 #include <gtest/gtest.h>
 
+#include <builtin_registry.hpp>
+#include <cancellation.hpp>
 #include <cat_command.hpp>
 #include <cd_command.hpp>
+#include <count_command.hpp>
+#include <cut_command.hpp>
+#include <du_command.hpp>
 #include <echo_command.hpp>
+#include <enable_command.hpp>
 #include <exit_command.hpp>
+#include <find_command.hpp>
 #include <global_state.hpp>
 #include <ls_command.hpp>
 #include <grep_command.hpp>
+#include <head_command.hpp>
+#include <line_counter.hpp>
+#include <pipe.hpp>
 #include <pwd_command.hpp>
+#include <sort_command.hpp>
+#include <tail_command.hpp>
 #include <text_input.hpp>
 #include <text_output.hpp>
+#include <tr_command.hpp>
+#include <uniq_command.hpp>
+#include <unique_fd.hpp>
 #include <wc_command.hpp>
 
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
 #include <iterator>
+#include <map>
+#include <sstream>
 #include <string>
+#include <system_error>
+#include <thread>
 #include <optional>
+#include <random>
+#include <regex>
 #include <cstdlib>
 #include <vector>
 
@@ -61,6 +91,21 @@ class ScopedChdir {
   std::filesystem::path initial_;
 };
 
+class FileInput final : public Input {
+ public:
+  explicit FileInput(const std::filesystem::path& path)
+      : fd_(open(path.c_str(), O_RDONLY | O_CLOEXEC)) {
+    if (!fd_) {
+      throw std::runtime_error("Unable to open file: " + path.string());
+    }
+  }
+
+  [[nodiscard]] int fd() const override { return fd_.get(); }
+
+ private:
+  UniqueFd fd_;
+};
+
 class ScopedEnvVar {
  public:
   ScopedEnvVar(std::string name, std::string value)
@@ -119,6 +164,74 @@ TEST(CommandTest, CatReadInput) {
   EXPECT_EQ(output.read(), file);
 }
 
+TEST(CommandTest, CatCopiesRedirectedFile) {
+  const auto file = std::filesystem::path(TEST_DATA_DIR) / "file.txt";
+  CatCommand command({});
+  FileInput input(file);
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), ReadFile(file));
+}
+
+TEST(CommandTest, CatNumbersLines) {
+  CatCommand command({"-n"});
+  TextInput input("a\n\nb");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), "     1\ta\n     2\t\n     3\tb");
+}
+
+TEST(CommandTest, CatNumbersNonblankAndSqueezes) {
+  CatCommand command({"-bs"});
+  TextInput input("\n\n\na\n\n\n\nb\n");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), "\n     1\ta\n\n     2\tb\n");
+}
+
+TEST(CommandTest, CatShowAll) {
+  CatCommand command({"-A"});
+  TextInput input(std::string("a\tb\x01\x7f\xe9\n", 7));
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), "a^Ib^A^?M-i$\n");
+}
+
+TEST(CommandTest, CatNumberingContinuesAcrossFiles) {
+  const auto dir = CreateTempDirectory("cat-files");
+  {
+    std::ofstream(dir / "a.txt") << "one\ntw";
+    std::ofstream(dir / "b.txt") << "o\nthree\n";
+  }
+  CatCommand command(
+      {"-n", (dir / "a.txt").string(), (dir / "b.txt").string()});
+  TextInput input("");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), "     1\tone\n     2\ttwo\n     3\tthree\n");
+  std::filesystem::remove_all(dir);
+}
+
+TEST(CommandTest, CatLongLinesAcrossBlocks) {
+  std::string text(300 * 1024, 'x');
+  text += "\n\n";
+  CatCommand command({"-E"});
+  TextInput input(text);
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), std::string(300 * 1024, 'x') + "$\n$\n");
+}
+
+TEST(CommandTest, CatRejectsUnknownOption) {
+  EXPECT_THROW(CatCommand({"-z"}), std::invalid_argument);
+}
+
 TEST(CommandTest, WcReturnsFileStats) {
   const auto file = std::filesystem::path(TEST_DATA_DIR) / "file.txt";
   WcCommand command({file.string()});
@@ -141,6 +254,145 @@ TEST(CommandTest, WcReadInput) {
   EXPECT_EQ(output.read(), "      15      98    1039\n");
 }
 
+TEST(CommandTest, WcMultipleFilesPrintsTotal) {
+  const auto dir = CreateTempDirectory("wc-total");
+  std::ofstream(dir / "a.txt") << "one two\nthree\n";
+  std::ofstream(dir / "b.txt") << "four\n";
+  const auto a = (dir / "a.txt").string();
+  const auto b = (dir / "b.txt").string();
+
+  WcCommand command({b, a});
+  TextInput input("");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), "       1       1       5 " + b + "\n" +
+                               "       2       3      14 " + a + "\n" +
+                               "       3       4      19 total\n");
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(CommandTest, WcMissingFileKeepsOthers) {
+  const auto dir = CreateTempDirectory("wc-missing");
+  std::ofstream(dir / "a.txt") << "word\n";
+  const auto a = (dir / "a.txt").string();
+  const auto missing = (dir / "missing.txt").string();
+
+  WcCommand command({"-l", missing, a});
+  TextInput input("");
+  TextOutput output;
+
+  EXPECT_EQ(command.run(input, output), 1);
+  EXPECT_EQ(output.read(), "       1 " + a + "\n       1 total\n");
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(CommandTest, WcLargeFileWordsAcrossChunks) {
+  // Large enough to be counted in parallel chunks; words of odd lengths
+  // guarantee that some of them straddle chunk boundaries.
+  const auto dir = CreateTempDirectory("wc-chunks");
+  const auto file = dir / "big.txt";
+  std::string content;
+  size_t words = 0;
+  size_t lines = 0;
+  for (size_t i = 0; content.size() < (size_t{40} << 20); ++i) {
+    content.append(1 + i % 13, 'x');
+    ++words;
+    if (i % 7 == 0) {
+      content.push_back('\n');
+      ++lines;
+    } else {
+      content.push_back(' ');
+    }
+  }
+  std::ofstream(file, std::ios::binary) << content;
+
+  WcCommand command({file.string()});
+  TextInput input("");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  auto field = [](size_t value) {
+    auto digits = std::to_string(value);
+    return std::string(digits.size() < 8 ? 8 - digits.size() : 1, ' ') +
+           digits;
+  };
+  EXPECT_EQ(output.read(), field(lines) + field(words) +
+                               field(content.size()) + " " + file.string() +
+                               "\n");
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(CommandTest, WcSelectedCounters) {
+  const auto file = std::filesystem::path(TEST_DATA_DIR) / "file.txt";
+  TextInput input("");
+
+  TextOutput bytes;
+  ASSERT_EQ(WcCommand({"-c", file.string()}).run(input, bytes), 0);
+  EXPECT_EQ(bytes.read(), "    1039 " + file.string() + "\n");
+
+  TextOutput lines;
+  ASSERT_EQ(WcCommand({"-l", file.string()}).run(input, lines), 0);
+  EXPECT_EQ(lines.read(), "      15 " + file.string() + "\n");
+
+  TextOutput lines_and_bytes;
+  ASSERT_EQ(WcCommand({"-l", "-c", file.string()}).run(input, lines_and_bytes),
+            0);
+  EXPECT_EQ(lines_and_bytes.read(), "      15    1039 " + file.string() + "\n");
+}
+
+TEST(CommandTest, WcBytesFromRedirectedRegularFile) {
+  const auto file = std::filesystem::path(TEST_DATA_DIR) / "file.txt";
+  FileInput input(file);
+  TextOutput output;
+
+  ASSERT_EQ(WcCommand({"-c"}).run(input, output), 0);
+  EXPECT_EQ(output.read(), "    1039\n");
+  // The input is consumed, as if it had been read to the end.
+  char ch = 0;
+  EXPECT_EQ(input.read(&ch, 1), 0);
+}
+
+TEST(CommandTest, WcLinesFromPipe) {
+  TextInput input("a b\nc\n\nd");
+  TextOutput output;
+
+  ASSERT_EQ(WcCommand({"-l"}).run(input, output), 0);
+  EXPECT_EQ(output.read(), "       3\n");
+}
+
+TEST(CommandTest, WcCharsAndMaxLineLength) {
+  // "привет" is 6 characters in 12 bytes.
+  TextInput input(
+      "\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82 world\nab\tc\n");
+  TextOutput output;
+
+  ASSERT_EQ(WcCommand({"-l", "-w", "-m", "-c", "-L"}).run(input, output), 0);
+  EXPECT_EQ(output.read(), "       2       4      18      24      12\n");
+}
+
+TEST(CommandTest, WcCharsReadFile) {
+  const auto file = std::filesystem::path(TEST_DATA_DIR) / "file.txt";
+  const auto content = ReadFile(file);
+  size_t chars = 0;
+  for (char ch : content) {
+    const auto byte = static_cast<unsigned char>(ch);
+    chars += static_cast<size_t>((byte & 0xC0) != 0x80);
+  }
+
+  WcCommand command({"-m", file.string()});
+  TextInput input("");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  auto digits = std::to_string(chars);
+  EXPECT_EQ(output.read(), std::string(8 - digits.size(), ' ') + digits + " " +
+                               file.string() + "\n");
+}
+
 TEST(CommandTest, PwdPrintsCurrentWorkingDirectory) {
   PwdCommand command;
   TextInput input("");
@@ -205,6 +457,13 @@ TEST(CommandTest, CdFailsOnMissingDirectory) {
   EXPECT_NE(std::filesystem::current_path(), missing);
 }
 
+TEST(CommandTest, EnableChangesShellStateOnlyWhenLoading) {
+  // Early pipeline stages skip such commands, so `enable -f lib.so rev |
+  // cat` must not load anything while `enable | grep rev` still lists.
+  EXPECT_TRUE(EnableCommand({"-f", "lib.so", "rev"}).changesShellState());
+  EXPECT_FALSE(EnableCommand({}).changesShellState());
+}
+
 TEST(CommandTest, LsPrintsDirectoryEntries) {
   const auto dir = CreateTempDirectory("ls-test");
 
@@ -222,6 +481,136 @@ TEST(CommandTest, LsPrintsDirectoryEntries) {
   std::filesystem::remove_all(dir);
 }
 
+TEST(CommandTest, LsSortsLargeDirectory) {
+  const auto dir = CreateTempDirectory("ls-large");
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int> letter('a', 'z');
+  std::vector<std::string> names;
+  for (size_t i = 0; i < 3000; ++i) {
+    std::string name = "file-";
+    for (int j = 0; j < 6; ++j) {
+      name.push_back(static_cast<char>(letter(rng)));
+    }
+    name += std::to_string(i);
+    std::ofstream(dir / name).put('x');
+    names.push_back(std::move(name));
+  }
+  std::sort(names.begin(), names.end());
+  std::string expected;
+  for (const auto& name : names) {
+    expected += name + "\n";
+  }
+
+  LsCommand command(std::vector<std::string>{dir.string()});
+  TextInput input("");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), expected);
+  std::filesystem::remove_all(dir);
+}
+
+TEST(CommandTest, LsMissingDirectoryFails) {
+  LsCommand command(std::vector<std::string>{"/nonexistent/ls-target"});
+  TextInput input("");
+  TextOutput output;
+
+  EXPECT_EQ(command.run(input, output), 1);
+  EXPECT_EQ(output.read(), "");
+}
+
+TEST(CommandTest, LsHidesDotFilesUnlessAll) {
+  const auto dir = CreateTempDirectory("ls-hidden");
+  std::ofstream(dir / ".hidden").put('h');
+  std::ofstream(dir / "visible").put('v');
+
+  TextInput input("");
+  TextOutput plain;
+  ASSERT_EQ(LsCommand({dir.string()}).run(input, plain), 0);
+  EXPECT_EQ(plain.read(), "visible\n");
+
+  TextOutput all;
+  ASSERT_EQ(LsCommand({"-a", dir.string()}).run(input, all), 0);
+  EXPECT_EQ(all.read(), ".\n..\n.hidden\nvisible\n");
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(CommandTest, LsSortsBySizeAndTime) {
+  const auto dir = CreateTempDirectory("ls-sort");
+  std::ofstream(dir / "small") << "1";
+  std::ofstream(dir / "large") << "12345";
+  std::ofstream(dir / "medium") << "123";
+  const auto now = std::filesystem::file_time_type::clock::now();
+  std::filesystem::last_write_time(dir / "small", now - std::chrono::hours(1));
+  std::filesystem::last_write_time(dir / "large", now - std::chrono::hours(3));
+  std::filesystem::last_write_time(dir / "medium", now - std::chrono::hours(2));
+
+  TextInput input("");
+  TextOutput by_size;
+  ASSERT_EQ(LsCommand({"-S", dir.string()}).run(input, by_size), 0);
+  EXPECT_EQ(by_size.read(), "large\nmedium\nsmall\n");
+
+  TextOutput by_time;
+  ASSERT_EQ(LsCommand({"-t", dir.string()}).run(input, by_time), 0);
+  EXPECT_EQ(by_time.read(), "small\nmedium\nlarge\n");
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(CommandTest, LsLongFormat) {
+  const auto dir = CreateTempDirectory("ls-long");
+  std::ofstream(dir / "file") << "hello";
+  std::filesystem::permissions(dir / "file",
+                               std::filesystem::perms::owner_read |
+                                   std::filesystem::perms::owner_write |
+                                   std::filesystem::perms::group_read);
+  std::filesystem::create_directory(dir / "sub");
+  std::filesystem::create_symlink("file", dir / "link");
+
+  LsCommand command({"-l", dir.string()});
+  TextInput input("");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  const auto result = output.read();
+  EXPECT_TRUE(result.starts_with("total ")) << result;
+  EXPECT_TRUE(std::regex_search(
+      result, std::regex("\n-rw-r----- +1 [^ ]+ +[^ ]+ +5 [A-Z][a-z]{2} "
+                         "[ 0-9]{2} [0-9]{2}:[0-9]{2} file\n")))
+      << result;
+  EXPECT_TRUE(std::regex_search(
+      result, std::regex("\nl[rwx-]{9} .* link -> file\n")))
+      << result;
+  EXPECT_TRUE(
+      std::regex_search(result, std::regex("\nd[rwx-]{9} .* sub\n$")))
+      << result;
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(CommandTest, LsRecursive) {
+  const auto dir = CreateTempDirectory("ls-recursive");
+  std::filesystem::create_directories(dir / "b" / "c");
+  std::ofstream(dir / "a").put('a');
+  std::ofstream(dir / "b" / "c" / "d").put('d');
+
+  LsCommand command({"-R", dir.string()});
+  TextInput input("");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  const auto root = dir.string();
+  EXPECT_EQ(output.read(), root + ":\na\nb\n\n" + root + "/b:\nc\n\n" + root +
+                               "/b/c:\nd\n");
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(CommandTest, LsRejectsUnknownOption) {
+  EXPECT_THROW(LsCommand({"-Z"}), std::invalid_argument);
+}
+
 TEST(CommandTest, LsPrintsFileNameWhenArgumentIsFile) {
   const auto file =
       std::filesystem::path(TEST_DATA_DIR) / "file.txt";
@@ -424,5 +813,782 @@ TEST(GrepTest, EmptyPatternMatchesAll) {
   EXPECT_TRUE(result.find("line2") != std::string::npos);
 }
 
+TEST(GrepTest, MultipleFilesKeepArgumentOrder) {
+  const auto dir = CreateTempDirectory("grep-files");
+  std::ofstream(dir / "a.txt") << "match a\nskip\n";
+  std::ofstream(dir / "b.txt") << "skip\nmatch b\n";
+
+  GrepCommand command(
+      {"match", (dir / "b.txt").string(), (dir / "a.txt").string()});
+  TextInput input("");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), (dir / "b.txt").string() + ":match b\n" +
+                               (dir / "a.txt").string() + ":match a\n");
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(GrepTest, RecursiveSearch) {
+  const auto dir = CreateTempDirectory("grep-recursive");
+  std::filesystem::create_directories(dir / "sub" / "deeper");
+  std::ofstream(dir / "top.txt") << "needle here\nnothing\n";
+  std::ofstream(dir / "sub" / "mid.txt") << "nothing\n";
+  std::ofstream(dir / "sub" / "deeper" / "low.txt") << "a needle\n";
+
+  GrepCommand command({"-r", "needle", dir.string()});
+  TextInput input("");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  std::string result = output.read();
+  EXPECT_NE(result.find((dir / "top.txt").string() + ":needle here\n"),
+            std::string::npos);
+  EXPECT_NE(
+      result.find((dir / "sub" / "deeper" / "low.txt").string() + ":a needle\n"),
+      std::string::npos);
+  EXPECT_EQ(result.find("mid.txt"), std::string::npos);
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(GrepTest, RecursiveSkipsBinaryFiles) {
+  const auto dir = CreateTempDirectory("grep-binary");
+  std::ofstream(dir / "text.txt") << "needle\n";
+  {
+    std::ofstream binary(dir / "blob.bin", std::ios::binary);
+    binary << "needle" << '\0' << "needle\n";
+  }
+
+  GrepCommand command({"-r", "needle", dir.string()});
+  TextInput input("");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), (dir / "text.txt").string() + ":needle\n");
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(GrepTest, RecursiveIncludeExcludeGlobs) {
+  ScopedChdir guard;
+  const auto dir = CreateTempDirectory("grep-globs");
+  std::filesystem::create_directories(dir / "build");
+  std::ofstream(dir / "main.cpp") << "needle\n";
+  std::ofstream(dir / "notes.md") << "needle\n";
+  std::ofstream(dir / "build" / "gen.cpp") << "needle\n";
+  std::filesystem::current_path(dir);
+
+  GrepCommand command(
+      {"-r", "--include", "*.cpp", "--exclude-dir=build", "needle"});
+  TextInput input("");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), "main.cpp:needle\n");
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(GrepTest, RecursiveMissingPathFails) {
+  GrepCommand command({"-r", "needle", "/nonexistent/grep/dir"});
+  TextInput input("");
+  TextOutput output;
+
+  EXPECT_EQ(command.run(input, output), 2);
+  EXPECT_EQ(output.read(), "");
+}
+
+namespace {
+
+// Output whose every write fails, like a full disk.
+class FailingOutput final : public Output {
+ public:
+  void write(const char* /*data*/, size_t /*size*/) const override {
+    throw std::system_error(EIO, std::generic_category(), "write");
+  }
+  [[nodiscard]] int fd() const override { return -1; }
+};
+
+}  // namespace
+
+TEST(GrepTest, RecursiveWriteErrorIsNotADirectoryError) {
+  // The write fails inside the walker's visitor; it must reach the caller
+  // rather than be reported as an error reading the directory.
+  const auto dir = CreateTempDirectory("grep-write-error");
+  std::ofstream(dir / "a.txt") << "needle\n";
+
+  GrepCommand command({"-r", "needle", dir.string()});
+  TextInput input("");
+  FailingOutput output;
+  EXPECT_THROW(command.run(input, output), std::system_error);
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(GrepTest, LineNumbers) {
+  std::string test_input = "alpha\nbeta\ngamma\nbeta again\n";
+  GrepCommand command({"-n", "beta"});
+  TextInput input(test_input);
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), "2:beta\n4:beta again\n");
+}
+
+TEST(GrepTest, ByteOffsets) {
+  std::string test_input = "alpha\nbeta\ngamma\n";
+  GrepCommand command({"-b", "-n", "gamma"});
+  TextInput input(test_input);
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), "3:11:gamma\n");
+}
+
+TEST(GrepTest, LineNumbersWithContext) {
+  std::string test_input = "match1\nctx\nskip\nskip\nmatch2\nctx\n";
+  GrepCommand command({"-n", "-A", "1", "match"});
+  TextInput input(test_input);
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), "1:match1\n2-ctx\n--\n5:match2\n6-ctx\n");
+}
+
+TEST(GrepTest, StdinScansAcrossBlocksLikeFiles) {
+  // Matches with context straddle the 64K read blocks of stdin; the
+  // output has to be that of the same text scanned whole from a file.
+  std::string text;
+  for (int i = 0; i < 20000; ++i) {
+    text += (i % 997 == 0 ? "match " : "line ") + std::to_string(i) + "\n";
+  }
+  text += "match without newline";
+  const auto path = std::filesystem::temp_directory_path() / "grep-blocks";
+  std::ofstream(path) << text;
+
+  const std::vector<std::string> flags = {"-n", "-b", "-A", "2", "match"};
+  GrepCommand from_stdin(flags);
+  TextInput input(text);
+  TextOutput stdin_output;
+  ASSERT_EQ(from_stdin.run(input, stdin_output), 0);
+
+  auto file_flags = flags;
+  file_flags.push_back(path.string());
+  GrepCommand from_file(file_flags);
+  TextInput no_input("");
+  TextOutput file_output;
+  ASSERT_EQ(from_file.run(no_input, file_output), 0);
+
+  EXPECT_EQ(stdin_output.read(), file_output.read());
+  EXPECT_TRUE(stdin_output.read().ends_with(":match without newline\n"));
+  std::filesystem::remove(path);
+}
+
+TEST(GrepTest, LineNumbersPerFile) {
+  const auto dir = CreateTempDirectory("grep-numbers");
+  std::ofstream(dir / "a.txt") << "x\nx\nneedle\n";
+  std::ofstream(dir / "b.txt") << "needle\n";
+
+  GrepCommand command(
+      {"-n", "needle", (dir / "a.txt").string(), (dir / "b.txt").string()});
+  TextInput input("");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), (dir / "a.txt").string() + ":3:needle\n" +
+                               (dir / "b.txt").string() + ":1:needle\n");
+
+  std::filesystem::remove_all(dir);
+}
+
+namespace {
+
+// Runs `find -s root args...` and returns its output with `root/` stripped.
+std::string RunFindSorted(const std::filesystem::path& root,
+                          std::vector<std::string> args) {
+  args.insert(args.begin(), {"-s", root.string()});
+  FindCommand command(std::move(args));
+  TextInput input("");
+  TextOutput output;
+  EXPECT_EQ(command.run(input, output), 0);
+
+  std::string result = output.read();
+  const std::string prefix = root.string() + "/";
+  for (size_t pos = result.find(prefix); pos != std::string::npos;
+       pos = result.find(prefix, pos)) {
+    result.erase(pos, prefix.size());
+  }
+  return result;
+}
+
+std::filesystem::path CreateFindTree() {
+  const auto dir = CreateTempDirectory("find-tree");
+  std::filesystem::create_directories(dir / "src" / "deep");
+  std::ofstream(dir / "README.md") << "readme";
+  std::ofstream(dir / "src" / "main.cpp") << std::string(2000, 'x');
+  std::ofstream(dir / "src" / "util.hpp") << "u";
+  std::ofstream(dir / "src" / "deep" / "old.cpp") << "";
+  std::filesystem::create_symlink("main.cpp", dir / "src" / "link.cpp");
+  const auto ten_days_ago = std::filesystem::file_time_type::clock::now() -
+                            std::chrono::hours(24 * 10);
+  std::filesystem::last_write_time(dir / "src" / "deep" / "old.cpp",
+                                   ten_days_ago);
+  return dir;
+}
+
+}  // namespace
+
+TEST(FindTest, ListsEverythingSorted) {
+  const auto dir = CreateFindTree();
+  EXPECT_EQ(RunFindSorted(dir, {}),
+            dir.string() +
+                "\nREADME.md\nsrc\nsrc/deep\nsrc/deep/old.cpp\nsrc/link.cpp\n"
+                "src/main.cpp\nsrc/util.hpp\n");
+  std::filesystem::remove_all(dir);
+}
+
+TEST(FindTest, NameAndType) {
+  const auto dir = CreateFindTree();
+  EXPECT_EQ(RunFindSorted(dir, {"-name", "*.cpp"}),
+            "src/deep/old.cpp\nsrc/link.cpp\nsrc/main.cpp\n");
+  EXPECT_EQ(RunFindSorted(dir, {"-name", "*.cpp", "-type", "f"}),
+            "src/deep/old.cpp\nsrc/main.cpp\n");
+  EXPECT_EQ(RunFindSorted(dir, {"-type", "l"}), "src/link.cpp\n");
+  EXPECT_EQ(RunFindSorted(dir, {"-type", "d", "-name", "d*"}), "src/deep\n");
+  std::filesystem::remove_all(dir);
+}
+
+TEST(FindTest, OperatorsAndGrouping) {
+  const auto dir = CreateFindTree();
+  EXPECT_EQ(RunFindSorted(dir, {"-name", "*.hpp", "-o", "-name", "*.md"}),
+            "README.md\nsrc/util.hpp\n");
+  EXPECT_EQ(RunFindSorted(dir, {"-type", "f", "!", "-name", "*.cpp"}),
+            "README.md\nsrc/util.hpp\n");
+  EXPECT_EQ(RunFindSorted(dir, {"(", "-name", "*.md", "-o", "-name", "*.hpp",
+                                ")", "-a", "-size", "-2c"}),
+            "src/util.hpp\n");
+  std::filesystem::remove_all(dir);
+}
+
+TEST(FindTest, SizeMtimeAndMaxDepth) {
+  const auto dir = CreateFindTree();
+  // 2000 bytes round up to 4 blocks of 512 bytes.
+  EXPECT_EQ(RunFindSorted(dir, {"-size", "4"}), "src/main.cpp\n");
+  EXPECT_EQ(RunFindSorted(dir, {"-type", "f", "-size", "+1k"}),
+            "src/main.cpp\n");
+  EXPECT_EQ(RunFindSorted(dir, {"-type", "f", "-size", "0"}),
+            "src/deep/old.cpp\n");
+  EXPECT_EQ(RunFindSorted(dir, {"-type", "f", "-mtime", "+5"}),
+            "src/deep/old.cpp\n");
+  EXPECT_EQ(RunFindSorted(dir, {"-maxdepth", "1", "-type", "d"}),
+            dir.string() + "\nsrc\n");
+  std::filesystem::remove_all(dir);
+}
+
+TEST(FindTest, StreamsUnsortedOutput) {
+  const auto dir = CreateFindTree();
+  FindCommand command({dir.string(), "-name", "*.hpp"});
+  TextInput input("");
+  TextOutput output;
+
+  ASSERT_EQ(command.run(input, output), 0);
+  EXPECT_EQ(output.read(), (dir / "src" / "util.hpp").string() + "\n");
+  std::filesystem::remove_all(dir);
+}
+
+TEST(FindTest, MissingPathFails) {
+  FindCommand command({"/nonexistent/find-root"});
+  TextInput input("");
+  TextOutput output;
+
+  EXPECT_EQ(command.run(input, output), 1);
+  EXPECT_EQ(output.read(), "");
+}
+
+TEST(FindTest, RejectsMalformedExpressions) {
+  EXPECT_THROW(FindCommand({".", "-bogus"}), std::invalid_argument);
+  EXPECT_THROW(FindCommand({".", "-name"}), std::invalid_argument);
+  EXPECT_THROW(FindCommand({".", "(", "-true"}), std::invalid_argument);
+  EXPECT_THROW(FindCommand({".", "-type", "x"}), std::invalid_argument);
+  EXPECT_THROW(FindCommand({".", "-size", "1q"}), std::invalid_argument);
+  EXPECT_THROW(FindCommand({".", "-maxdepth", "x"}), std::invalid_argument);
+}
+
+namespace {
+
+std::string RunDu(std::vector<std::string> args) {
+  DuCommand command(std::move(args));
+  TextInput input("");
+  TextOutput output;
+  EXPECT_EQ(command.run(input, output), 0);
+  return output.read();
+}
+
+uint64_t ApparentSize(const std::filesystem::path& path) {
+  struct stat st {};
+  EXPECT_EQ(lstat(path.c_str(), &st), 0);
+  return static_cast<uint64_t>(st.st_size);
+}
+
+}  // namespace
+
+TEST(DuTest, CountsHardLinksOnce) {
+  const auto dir = CreateTempDirectory("du-links");
+  std::filesystem::create_directory(dir / "sub");
+  std::ofstream(dir / "data") << std::string(10000, 'x');
+  std::filesystem::create_hard_link(dir / "data", dir / "sub" / "link");
+
+  const uint64_t bytes =
+      ApparentSize(dir) + ApparentSize(dir / "sub") + 10000;
+  EXPECT_EQ(RunDu({"--apparent-size", "-s", dir.string()}),
+            std::to_string((bytes + 1023) / 1024) + "\t" + dir.string() +
+                "\n");
+  std::filesystem::remove_all(dir);
+}
+
+TEST(DuTest, PrintsDirectoriesInPostOrder) {
+  const auto dir = CreateTempDirectory("du-order");
+  std::filesystem::create_directories(dir / "b" / "deep");
+  std::filesystem::create_directories(dir / "a");
+  std::ofstream(dir / "a" / "file") << "data";
+
+  auto paths_of = [](const std::string& output) {
+    std::string paths;
+    std::istringstream lines(output);
+    for (std::string line; std::getline(lines, line);) {
+      paths += line.substr(line.find('\t') + 1) + "\n";
+    }
+    return paths;
+  };
+
+  const auto root = dir.string();
+  EXPECT_EQ(paths_of(RunDu({root})), root + "/a\n" + root + "/b/deep\n" +
+                                         root + "/b\n" + root + "\n");
+  EXPECT_EQ(paths_of(RunDu({"-d", "1", root})),
+            root + "/a\n" + root + "/b\n" + root + "\n");
+  EXPECT_EQ(paths_of(RunDu({"-s", root})), root + "\n");
+  std::filesystem::remove_all(dir);
+}
+
+TEST(DuTest, HumanReadableSizes) {
+  const auto dir = CreateTempDirectory("du-human");
+  const std::vector<std::pair<uint64_t, std::string>> cases = {
+      {100, "100"},
+      {1536, "1.5K"},
+      {10 * 1024 - 1, "10K"},
+      {5 * 1024 * 1024, "5.0M"},
+      {uint64_t{3} << 30, "3.0G"},
+  };
+  for (const auto& [size, expected] : cases) {
+    const auto file = dir / std::to_string(size);
+    std::ofstream{file};
+    std::filesystem::resize_file(file, size);
+    EXPECT_EQ(RunDu({"-h", "--apparent-size", file.string()}),
+              expected + "\t" + file.string() + "\n");
+  }
+  std::filesystem::remove_all(dir);
+}
+
+TEST(DuTest, MissingPathFails) {
+  DuCommand command({"/nonexistent/du-root"});
+  TextInput input("");
+  TextOutput output;
+
+  EXPECT_EQ(command.run(input, output), 1);
+  EXPECT_EQ(output.read(), "");
+}
+
+TEST(DuTest, RejectsBadOptions) {
+  EXPECT_THROW(DuCommand({"-x"}), std::invalid_argument);
+  EXPECT_THROW(DuCommand({"-d"}), std::invalid_argument);
+  EXPECT_THROW(DuCommand({"-d", "deep"}), std::invalid_argument);
+}
+
+namespace {
+
+std::string RunSort(std::vector<std::string> args, std::string text) {
+  SortCommand command(std::move(args));
+  TextInput input(std::move(text));
+  TextOutput output;
+  EXPECT_EQ(command.run(input, output), 0);
+  return output.read();
+}
+
+}  // namespace
+
+TEST(SortTest, OrdersBytesNumbersAndReverses) {
+  const std::string text = "b\n10\na\n-2.5\n\n9\nB\n10\n";
+  EXPECT_EQ(RunSort({}, text), "\n-2.5\n10\n10\n9\nB\na\nb\n");
+  EXPECT_EQ(RunSort({"-n"}, text), "-2.5\n\nB\na\nb\n9\n10\n10\n");
+  // -u keeps the first line of each group in input order, also with -r.
+  EXPECT_EQ(RunSort({"-nru"}, text), "10\n9\nb\n-2.5\n");
+  // A missing final newline still ends the line.
+  EXPECT_EQ(RunSort({"-r"}, "x\ny"), "y\nx\n");
+}
+
+TEST(SortTest, SortsByFieldKeys) {
+  const std::string text = "a:3:x\nb:10:y\nc:3:a\nd\n";
+  EXPECT_EQ(RunSort({"-t", ":", "-k", "2,2", "-n"}, text),
+            "d\na:3:x\nc:3:a\nb:10:y\n");
+  EXPECT_EQ(RunSort({"-t:", "-k2,2", "-nu"}, "x:1\ny:01\nz:2\n"),
+            "x:1\nz:2\n");
+  // Without -t the blanks in front of a field belong to it.
+  EXPECT_EQ(RunSort({"-k2"}, "a  b\nb c\nc a\n"), "a  b\nc a\nb c\n");
+}
+
+TEST(SortTest, SpilledRunsMergeLikeInMemorySort) {
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int> letter('a', 'e');
+  std::uniform_int_distribution<int> length(0, 12);
+  std::vector<std::string> lines;
+  std::string text;
+  for (int i = 0; i < 20000; ++i) {
+    std::string line(length(rng), ' ');
+    for (auto& ch : line) {
+      ch = static_cast<char>(letter(rng));
+    }
+    text += line + "\n";
+    lines.push_back(std::move(line));
+  }
+
+  std::sort(lines.begin(), lines.end());
+  std::string expected;
+  for (const auto& line : lines) {
+    expected += line + "\n";
+  }
+  // -S 1 gives 256-byte chunks: hundreds of runs, merged in two passes.
+  EXPECT_EQ(RunSort({}, text), expected);
+  EXPECT_EQ(RunSort({"-S", "1"}, text), expected);
+
+  lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+  std::string unique;
+  for (auto it = lines.rbegin(); it != lines.rend(); ++it) {
+    unique += *it + "\n";
+  }
+  EXPECT_EQ(RunSort({"-S1", "-ru"}, text), unique);
+}
+
+TEST(SortTest, RejectsBadOptions) {
+  EXPECT_THROW(SortCommand({"-x"}), std::invalid_argument);
+  EXPECT_THROW(SortCommand({"-k"}), std::invalid_argument);
+  EXPECT_THROW(SortCommand({"-k", "0"}), std::invalid_argument);
+  EXPECT_THROW(SortCommand({"-k", "3,2"}), std::invalid_argument);
+  EXPECT_THROW(SortCommand({"-t", "ab"}), std::invalid_argument);
+  EXPECT_THROW(SortCommand({"-S", "lots"}), std::invalid_argument);
+}
+
+namespace {
+
+template <typename CommandT>
+std::string RunLines(std::vector<std::string> args, std::string text) {
+  CommandT command(std::move(args));
+  TextInput input(std::move(text));
+  TextOutput output;
+  EXPECT_EQ(command.run(input, output), 0);
+  return output.read();
+}
+
+}  // namespace
+
+TEST(CountTest, CountsMostFrequentFirst) {
+  const std::string text = "b\na\nb\nc\na\nb\n\nd";
+  EXPECT_EQ(RunLines<CountCommand>({}, text),
+            "      3 b\n      2 a\n      1 c\n      1 \n      1 d\n");
+  // Equal counts keep the order of first occurrence, also in the top K.
+  EXPECT_EQ(RunLines<CountCommand>({"-n", "3"}, text),
+            "      3 b\n      2 a\n      1 c\n");
+  EXPECT_EQ(RunLines<CountCommand>({"-n1"}, text), "      3 b\n");
+  EXPECT_EQ(RunLines<CountCommand>({"-n0"}, text), "");
+  EXPECT_THROW(CountCommand({"-n"}), std::invalid_argument);
+  EXPECT_THROW(CountCommand({"-n", "many"}), std::invalid_argument);
+  EXPECT_THROW(CountCommand({"-x"}), std::invalid_argument);
+}
+
+TEST(CountTest, PartialTablesMergeToTotals) {
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int> value(0, 999);
+  LineCounter first;
+  LineCounter second;
+  std::map<std::string, std::pair<uint64_t, uint64_t>> expected;
+  for (uint64_t i = 0; i < 20000; ++i) {
+    const std::string line = "line" + std::to_string(value(rng));
+    (i % 3 == 0 ? first : second).add(line, i);
+    auto [it, inserted] = expected.try_emplace(line, 0, i);
+    ++it->second.first;
+  }
+
+  first.merge(second);
+  ASSERT_EQ(first.entries().size(), expected.size());
+  for (const auto& entry : first.entries()) {
+    const auto& [count, position] = expected.at(std::string(entry.line));
+    EXPECT_EQ(entry.count, count) << entry.line;
+    EXPECT_EQ(entry.first, position) << entry.line;
+  }
+}
+
+TEST(UniqTest, CollapsesAdjacentLines) {
+  const std::string text = "a\na\nb\na\nc\nc\nc";
+  EXPECT_EQ(RunLines<UniqCommand>({}, text), "a\nb\na\nc\n");
+  EXPECT_EQ(RunLines<UniqCommand>({"-c"}, text),
+            "      2 a\n      1 b\n      1 a\n      3 c\n");
+  EXPECT_EQ(RunLines<UniqCommand>({"-d"}, text), "a\nc\n");
+  EXPECT_EQ(RunLines<UniqCommand>({"-u"}, text), "b\na\n");
+  // --unsorted counts lines wherever they are, in first-seen order.
+  EXPECT_EQ(RunLines<UniqCommand>({"-c", "--unsorted"}, text),
+            "      3 a\n      1 b\n      3 c\n");
+  EXPECT_EQ(RunLines<UniqCommand>({"--unsorted", "-u"}, text), "b\n");
+  EXPECT_THROW(UniqCommand({"-x"}), std::invalid_argument);
+}
+
+TEST(UniqTest, WritesToTheOutputOperand) {
+  const auto dir = CreateTempDirectory("uniq-output");
+  std::ofstream(dir / "in") << "a\na\nb\n";
+  std::ofstream(dir / "out") << "stale contents\n";
+
+  for (const char* flags : {"-c", "--unsorted"}) {
+    UniqCommand command(
+        {flags, (dir / "in").string(), (dir / "out").string()});
+    TextInput input("");
+    TextOutput output;
+    EXPECT_EQ(command.run(input, output), 0);
+    EXPECT_EQ(output.read(), "");
+    std::ifstream file(dir / "out");
+    EXPECT_EQ(std::string(std::istreambuf_iterator<char>(file), {}),
+              std::string(flags) == "-c" ? "      2 a\n      1 b\n"
+                                         : "a\nb\n");
+  }
+  EXPECT_THROW(UniqCommand({"in", "out", "extra"}), std::invalid_argument);
+
+  std::filesystem::remove_all(dir);
+}
+
+TEST(UniqTest, StreamsGroupsAcrossReads) {
+  // Groups of up to 50 long lines, so groups and lines span read blocks.
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int> repeats(1, 50);
+  std::string text;
+  std::string expected;
+  for (int group = 0; group < 300; ++group) {
+    const std::string line(100 + group, static_cast<char>('a' + group % 2));
+    const int count = repeats(rng);
+    for (int i = 0; i < count; ++i) {
+      text += line + "\n";
+    }
+    std::array<char, 16> prefix{};
+    std::snprintf(prefix.data(), prefix.size(), "%7d ", count);
+    expected += prefix.data() + line + "\n";
+  }
+  EXPECT_EQ(RunLines<UniqCommand>({"-c"}, text), expected);
+}
+
+TEST(HeadTest, PrintsFirstLinesOrBytes) {
+  std::string text;
+  for (int i = 1; i <= 20; ++i) {
+    text += std::to_string(i) + "\n";
+  }
+  EXPECT_EQ(RunLines<HeadCommand>({}, text),
+            "1\n2\n3\n4\n5\n6\n7\n8\n9\n10\n");
+  EXPECT_EQ(RunLines<HeadCommand>({"-n", "2"}, text), "1\n2\n");
+  EXPECT_EQ(RunLines<HeadCommand>({"-3"}, text), "1\n2\n3\n");
+  EXPECT_EQ(RunLines<HeadCommand>({"-c5"}, text), "1\n2\n3");
+  EXPECT_EQ(RunLines<HeadCommand>({"-n", "50"}, "a\nb"), "a\nb");
+  EXPECT_EQ(RunLines<HeadCommand>({"-n0"}, text), "");
+  EXPECT_THROW(HeadCommand({"-n"}), std::invalid_argument);
+  EXPECT_THROW(HeadCommand({"-c", "x"}), std::invalid_argument);
+  EXPECT_THROW(HeadCommand({"-q"}), std::invalid_argument);
+}
+
+TEST(HeadTest, HandsBackUnreadInputOfFiles) {
+  const auto path = std::filesystem::temp_directory_path() / "head-test.txt";
+  std::ofstream(path) << "one\ntwo\nthree\n";
+  FileInput input(path);
+
+  HeadCommand head({"-n", "1"});
+  TextOutput output;
+  EXPECT_EQ(head.run(input, output), 0);
+  EXPECT_EQ(output.read(), "one\n");
+  EXPECT_EQ(lseek(input.fd(), 0, SEEK_CUR), 4);
+
+  TextOutput headers;
+  HeadCommand several({"-n1", path.string(), "-"});
+  EXPECT_EQ(several.run(input, headers), 0);
+  EXPECT_EQ(headers.read(), "==> " + path.string() +
+                                " <==\none\n\n==> - <==\ntwo\n");
+  std::filesystem::remove(path);
+}
+
+TEST(TailTest, KeepsTheEndOfStreams) {
+  std::string text;
+  for (int i = 1; i <= 100000; ++i) {
+    text += std::to_string(i) + "\n";
+  }
+  EXPECT_EQ(RunLines<TailCommand>({}, text),
+            "99991\n99992\n99993\n99994\n99995\n"
+            "99996\n99997\n99998\n99999\n100000\n");
+  EXPECT_EQ(RunLines<TailCommand>({"-n", "2"}, text), "99999\n100000\n");
+  EXPECT_EQ(RunLines<TailCommand>({"-c8"}, text), "\n100000\n");
+  EXPECT_EQ(RunLines<TailCommand>({"-2"}, "a\nb\nc"), "b\nc");
+  EXPECT_EQ(RunLines<TailCommand>({"-n", "5"}, "a\nb\n"), "a\nb\n");
+  EXPECT_EQ(RunLines<TailCommand>({"-n0"}, text), "");
+  EXPECT_THROW(TailCommand({"-n"}), std::invalid_argument);
+  EXPECT_THROW(TailCommand({"-c", "x"}), std::invalid_argument);
+  EXPECT_THROW(TailCommand({"-q"}), std::invalid_argument);
+}
+
+TEST(TailTest, ReadsFilesBackwards) {
+  const auto path = std::filesystem::temp_directory_path() / "tail-test.txt";
+  std::string text;
+  for (int i = 1; i <= 100000; ++i) {
+    text += "line " + std::to_string(i) + "\n";
+  }
+  std::ofstream(path) << text;
+  auto run = [&](std::vector<std::string> args) {
+    args.push_back(path.string());
+    return RunLines<TailCommand>(std::move(args), "");
+  };
+
+  // The last lines reach back over several blocks.
+  EXPECT_EQ(run({"-n", "30000"}), text.substr(text.rfind("line 70001\n")));
+  EXPECT_EQ(run({"-n1"}), "line 100000\n");
+  EXPECT_EQ(run({"-c", "3"}), "00\n");
+  EXPECT_EQ(run({"-n", "200000"}), text);
+  EXPECT_EQ(run({"-n0"}), "");
+  std::filesystem::remove(path);
+}
+
+TEST(TailTest, FollowsAppendsAndRotatedFiles) {
+  const auto dir = std::filesystem::temp_directory_path() / "tail-follow";
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  const auto path = dir / "app.log";
+  std::ofstream(path) << "old 1\nold 2\n";
+
+  // As in the shell, a write to a pipe without readers fails with EPIPE.
+  std::signal(SIGPIPE, SIG_IGN);
+  auto [reader, writer] = createPipe();
+  TailCommand tail({"-F", "-n1", path.string()});
+  TextInput input("");
+  std::thread thread([&] {
+    // Run as a stage of a pipeline, for which a vanished reader is a
+    // cancellation.
+    Cancellation cancellation;
+    CancellationScope scope(cancellation);
+    try {
+      tail.run(input, *writer);
+    } catch (const PipelineCancelled&) {
+      // The reader went away in the middle of a write.
+    }
+  });
+
+  // Reads the pipe until `expected` has arrived.
+  std::string received;
+  auto wait_for = [&](std::string_view expected) {
+    while (!received.ends_with(expected)) {
+      pollfd fd{reader->fd(), POLLIN, 0};
+      ASSERT_EQ(poll(&fd, 1, 5000), 1) << received;
+      std::array<char, 256> block{};
+      const size_t size = reader->read(block.data(), block.size());
+      ASSERT_NE(size, 0);
+      received.append(block.data(), size);
+    }
+  };
+  wait_for("old 2\n");
+  std::ofstream(path, std::ios::app) << "new 3\n";
+  wait_for("new 3\n");
+  std::filesystem::rename(path, dir / "app.log.1");
+  std::ofstream(path) << "fresh 1\n";
+  wait_for("fresh 1\n");
+  EXPECT_EQ(received, "old 2\nnew 3\nfresh 1\n");
+
+  // Once nothing reads the output, tail stops following.
+  reader.reset();
+  thread.join();
+  std::filesystem::remove_all(dir);
+}
+
+TEST(TrTest, TranslatesDeletesAndSqueezes) {
+  EXPECT_EQ(RunLines<TrCommand>({"a-z", "A-Z"}, "Hello, World\n"),
+            "HELLO, WORLD\n");
+  EXPECT_EQ(RunLines<TrCommand>({"[:upper:]", "[:lower:]"}, "ABC def\n"),
+            "abc def\n");
+  // A shorter set2 is padded with its last byte; a later mapping wins.
+  EXPECT_EQ(RunLines<TrCommand>({"abcd", "xy"}, "abcdef"), "xyyyef");
+  EXPECT_EQ(RunLines<TrCommand>({"aa", "xy"}, "aba"), "yby");
+  EXPECT_EQ(RunLines<TrCommand>({"\\101\\n", "a "}, "AB\nA"), "aB a");
+  EXPECT_EQ(RunLines<TrCommand>({"-d", "\\r"}, "a\r\nb\r\n"), "a\nb\n");
+  EXPECT_EQ(RunLines<TrCommand>({"-cd", "0-9\\n"}, "a1b2\nc3\n"), "12\n3\n");
+  EXPECT_EQ(RunLines<TrCommand>({"-s", " "}, "a   b  c d"), "a b c d");
+  EXPECT_EQ(RunLines<TrCommand>({"-s", "a-z", "A-Z"}, "aabbcc  dd"),
+            "ABC  D");
+  EXPECT_EQ(RunLines<TrCommand>({"-ds", "x", "y"}, "yxyxyz"), "yz");
+  EXPECT_THROW(TrCommand({}), std::invalid_argument);
+  EXPECT_THROW(TrCommand({"a"}), std::invalid_argument);
+  EXPECT_THROW(TrCommand({"-d", "a", "b"}), std::invalid_argument);
+  EXPECT_THROW(TrCommand({"z-a", "x"}), std::invalid_argument);
+  EXPECT_THROW(TrCommand({"[:bogus:]", "x"}), std::invalid_argument);
+  EXPECT_THROW(TrCommand({"a", ""}), std::invalid_argument);
+}
+
+TEST(TrTest, SqueezesRunsAcrossBlocks) {
+  // Runs longer than a read block still come out as one byte.
+  const std::string text =
+      "a" + std::string(300000, ' ') + "b" + std::string(200000, ' ');
+  EXPECT_EQ(RunLines<TrCommand>({"-s", " "}, text), "a b ");
+  EXPECT_EQ(RunLines<TrCommand>({"-d", " "}, text), "ab");
+}
+
+TEST(CutTest, SelectsFieldsOrBytes) {
+  const std::string text = "a,b,c,d\nno delimiter\n1,2\n,,\n";
+  EXPECT_EQ(RunLines<CutCommand>({"-d,", "-f2"}, text),
+            "b\nno delimiter\n2\n\n");
+  EXPECT_EQ(RunLines<CutCommand>({"-d", ",", "-f", "3-,1"}, text),
+            "a,c,d\nno delimiter\n1\n,\n");
+  EXPECT_EQ(RunLines<CutCommand>({"-s", "-d,", "-f-2"}, text),
+            "a,b\n1,2\n,\n");
+  EXPECT_EQ(RunLines<CutCommand>({"-f2"}, "x\ty\tz"), "y\n");
+  EXPECT_EQ(RunLines<CutCommand>({"-b", "2-3,5-"}, "abcdefg\nab\n\n"),
+            "bcefg\nb\n\n");
+  EXPECT_EQ(RunLines<CutCommand>({"-c1"}, "xyz"), "x\n");
+  EXPECT_THROW(CutCommand({}), std::invalid_argument);
+  EXPECT_THROW(CutCommand({"-f0"}), std::invalid_argument);
+  EXPECT_THROW(CutCommand({"-f3-2"}), std::invalid_argument);
+  EXPECT_THROW(CutCommand({"-f1", "-b1"}), std::invalid_argument);
+  EXPECT_THROW(CutCommand({"-d", "ab", "-f1"}), std::invalid_argument);
+  EXPECT_THROW(CutCommand({"-d,", "-b1"}), std::invalid_argument);
+}
+
+TEST(CutTest, CarriesLinesAcrossBlocks) {
+  // Lines straddle read blocks, and the last one outgrows the buffer.
+  std::string text;
+  std::string expected;
+  for (int i = 0; i < 20000; ++i) {
+    text += std::to_string(i) + ":" + std::string(i % 37, 'x') + ":" +
+            std::to_string(i * 7) + "\n";
+    expected += std::to_string(i) + ":" + std::to_string(i * 7) + "\n";
+  }
+  text += std::string(300000, 'y') + ":z:w";
+  expected += std::string(300000, 'y') + ":w\n";
+  EXPECT_EQ(RunLines<CutCommand>({"-d:", "-f1,3"}, text), expected);
+}
+
+TEST(BuiltinRegistryTest, TableIsSortedAndResolvesNames) {
+  auto& registry = BuiltinRegistry::instance();
+  const auto builtins = registry.builtins();
+  EXPECT_TRUE(std::ranges::is_sorted(builtins, {}, &Builtin::name));
+
+  for (std::string_view name : {"cat", "echo", "exit", "type", "wc"}) {
+    const Builtin* builtin = registry.find(name);
+    ASSERT_NE(builtin, nullptr) << name;
+    EXPECT_EQ(builtin->name, name);
+  }
+  EXPECT_EQ(registry.find("ca"), nullptr);
+  EXPECT_EQ(registry.find("zzz"), nullptr);
+
+  // Names cannot be registered twice.
+  EXPECT_FALSE(registry.add("echo", makeBuiltin<EchoCommand>));
+  EXPECT_EQ(registry.builtins().size(), builtins.size());
+}
 
 }  // namespace coreutils::test
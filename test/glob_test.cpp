@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+
+#include <glob.hpp>
+#include <glob_expander.hpp>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils::test {
+
+namespace {
+
+// Fresh directory holding empty files at the given relative paths.
+std::filesystem::path CreateTree(const std::string& name,
+                                 const std::vector<std::string>& files) {
+  const auto dir = std::filesystem::temp_directory_path() /
+                   ("glob-" + name + "-" + std::to_string(getpid()));
+  std::filesystem::remove_all(dir);
+  for (const auto& file : files) {
+    std::filesystem::create_directories((dir / file).parent_path());
+    std::ofstream(dir / file).put('x');
+  }
+  return dir;
+}
+
+std::vector<std::string> Expand(GlobExpander& expander,
+                                const std::string& pattern) {
+  Arena arena;
+  std::vector<std::string_view> views;
+  expander.expand(pattern, arena, views);
+  return {views.begin(), views.end()};
+}
+
+}  // namespace
+
+TEST(Glob, Literal) {
+  GlobPattern glob("file.txt");
+  EXPECT_FALSE(glob.hasWildcards());
+  EXPECT_TRUE(glob.match("file.txt"));
+  EXPECT_FALSE(glob.match("file.txt2"));
+  EXPECT_FALSE(glob.match("file"));
+}
+
+TEST(Glob, Star) {
+  GlobPattern glob("*.log");
+  EXPECT_TRUE(glob.hasWildcards());
+  EXPECT_TRUE(glob.match("app.log"));
+  EXPECT_TRUE(glob.match(".log"));
+  EXPECT_FALSE(glob.match("app.log.1"));
+  EXPECT_TRUE(GlobPattern("*").match(""));
+  EXPECT_TRUE(GlobPattern("a*b*c").match("abc"));
+  EXPECT_TRUE(GlobPattern("a*b*c").match("aXbYbZc"));
+  EXPECT_FALSE(GlobPattern("a*b*c").match("aXcYb"));
+  EXPECT_FALSE(GlobPattern("ab*ba").match("aba"));
+}
+
+TEST(Glob, QuestionMarkAndClasses) {
+  EXPECT_TRUE(GlobPattern("shard-??.csv").match("shard-07.csv"));
+  EXPECT_FALSE(GlobPattern("shard-??.csv").match("shard-7.csv"));
+  EXPECT_TRUE(GlobPattern("[a-c]x").match("bx"));
+  EXPECT_FALSE(GlobPattern("[a-c]x").match("dx"));
+  EXPECT_TRUE(GlobPattern("[!a-c]x").match("dx"));
+  EXPECT_TRUE(GlobPattern("[]]").match("]"));
+  EXPECT_TRUE(GlobPattern("[").match("["));
+}
+
+TEST(Glob, Escapes) {
+  EXPECT_FALSE(GlobPattern("\\*").hasWildcards());
+  EXPECT_TRUE(GlobPattern("\\*").match("*"));
+  EXPECT_FALSE(GlobPattern("\\*").match("a"));
+}
+
+TEST(Glob, NoExponentialBlowup) {
+  std::string text(10000, 'a');
+  GlobPattern glob("*a*a*a*a*a*a*a*a*b");
+  EXPECT_FALSE(glob.match(text));
+}
+
+TEST(GlobExpander, MatchesSortedAndSkipsHiddenFiles) {
+  const auto dir = CreateTree(
+      "basic", {"b.log", "a.log", "c.txt", ".hidden.log", "shard-01.csv",
+                "shard-1.csv", "sub/x.log"});
+  const std::string root = dir.string();
+
+  GlobExpander expander;
+  EXPECT_EQ(Expand(expander, root + "/*.log"),
+            (std::vector<std::string>{root + "/a.log", root + "/b.log"}));
+  EXPECT_EQ(Expand(expander, root + "/.*.log"),
+            std::vector<std::string>{root + "/.hidden.log"});
+  EXPECT_EQ(Expand(expander, root + "/shard-??.csv"),
+            std::vector<std::string>{root + "/shard-01.csv"});
+  EXPECT_EQ(Expand(expander, root + "/s*/*.log"),
+            std::vector<std::string>{root + "/sub/x.log"});
+  EXPECT_EQ(Expand(expander, root + "/*/"),
+            std::vector<std::string>{root + "/sub/"});
+  std::filesystem::remove_all(dir);
+}
+
+TEST(GlobExpander, NoMatchAppendsNothing) {
+  const auto dir = CreateTree("none", {"a.txt", "d/a.txt"});
+  const std::string root = dir.string();
+
+  GlobExpander expander;
+  Arena arena;
+  std::vector<std::string_view> out = {"keep"};
+  EXPECT_FALSE(expander.expand(root + "/*.log", arena, out));
+  EXPECT_FALSE(expander.expand(root + "/*/missing", arena, out));
+  EXPECT_FALSE(expander.expand(root + "/nowhere/*", arena, out));
+  EXPECT_EQ(out, std::vector<std::string_view>{"keep"});
+  EXPECT_EQ(Expand(expander, root + "/*/a.txt"),
+            std::vector<std::string>{root + "/d/a.txt"});
+  std::filesystem::remove_all(dir);
+}
+
+TEST(GlobExpander, ListingIsCachedUntilClear) {
+  const auto dir = CreateTree("cache", {"a.log"});
+  const std::string root = dir.string();
+
+  GlobExpander expander;
+  EXPECT_EQ(Expand(expander, root + "/*.log").size(), 1);
+  std::ofstream(dir / "b.log").put('x');
+  EXPECT_EQ(Expand(expander, root + "/*.log").size(), 1);
+  expander.clear();
+  EXPECT_EQ(Expand(expander, root + "/*.log").size(), 2);
+  std::filesystem::remove_all(dir);
+}
+
+TEST(GlobExpander, ManyMatchesAcrossDirectoriesAreSorted) {
+  std::vector<std::string> files;
+  for (int i = 0; i < 3000; ++i) {
+    files.push_back((i % 2 == 0 ? "a/" : "a.b/") + std::to_string(i) +
+                    ".dat");
+  }
+  const auto dir = CreateTree("many", files);
+  const std::string root = dir.string();
+
+  GlobExpander expander;
+  const auto matches = Expand(expander, root + "/a*/*.dat");
+  ASSERT_EQ(matches.size(), files.size());
+  EXPECT_TRUE(std::ranges::is_sorted(matches));
+  std::filesystem::remove_all(dir);
+}
+
+}  // namespace coreutils::test
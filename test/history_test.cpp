@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <history.hpp>
+#include <history_command.hpp>
+#include <text_input.hpp>
+#include <text_output.hpp>
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils::test {
+
+namespace {
+
+// Path of a history file that does not exist yet.
+std::string FreshFile(const std::string& name) {
+  const auto path = std::filesystem::temp_directory_path() /
+                    ("history-" + name + "-" + std::to_string(getpid()));
+  std::filesystem::remove(path);
+  return path.string();
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream stream(path, std::ios::binary);
+  return {std::istreambuf_iterator<char>(stream),
+          std::istreambuf_iterator<char>()};
+}
+
+std::vector<std::string> Strings(const std::vector<std::string_view>& views) {
+  return {views.begin(), views.end()};
+}
+
+}  // namespace
+
+TEST(HistoryTest, AppendsEveryCommandAndListsEachOnce) {
+  const auto path = FreshFile("append");
+  {
+    History history;
+    history.open(path);
+    for (auto line : {"ls", "pwd", "pwd", "  ", "", "ls", "cd /"}) {
+      history.add(line);
+    }
+    // Commands added before the first lookup come back from the file.
+    EXPECT_EQ(Strings(history.entries()),
+              (std::vector<std::string>{"pwd", "ls", "cd /"}));
+    history.add("pwd");
+    EXPECT_EQ(Strings(history.entries()),
+              (std::vector<std::string>{"ls", "cd /", "pwd"}));
+  }
+  EXPECT_EQ(ReadFile(path), "ls\npwd\nls\ncd /\npwd\n");
+
+  History reopened;
+  reopened.open(path);
+  EXPECT_EQ(Strings(reopened.entries()),
+            (std::vector<std::string>{"ls", "cd /", "pwd"}));
+  std::filesystem::remove(path);
+}
+
+TEST(HistoryTest, ConcurrentSessionsShareTheFile) {
+  const auto path = FreshFile("shared");
+  History first;
+  History second;
+  first.open(path);
+  second.open(path);
+  first.add("echo 1");
+  second.add("echo 2");
+  first.add("echo 3");
+
+  History third;
+  third.open(path);
+  EXPECT_EQ(Strings(third.entries()),
+            (std::vector<std::string>{"echo 1", "echo 2", "echo 3"}));
+  std::filesystem::remove(path);
+}
+
+TEST(HistoryTest, SearchMatchesBruteForce) {
+  // Random lines over a small alphabet, so that many trigram signatures
+  // collide and the text comparison has to reject them.
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> letter('a', 'f');
+  std::uniform_int_distribution<int> length(0, 40);
+
+  History history;
+  std::vector<std::string> lines;
+  for (int i = 0; i < 20000; ++i) {
+    std::string line(length(rng), ' ');
+    for (auto& ch : line) {
+      ch = static_cast<char>(letter(rng));
+    }
+    history.add(line);
+    lines.push_back(line);
+  }
+
+  for (std::string_view text : {"", "a", "fe", "abc", "fedcb", "abcdefab"}) {
+    std::vector<std::string> expected;
+    for (auto it = lines.rbegin(); it != lines.rend(); ++it) {
+      if (!it->empty() && it->find(text) != std::string::npos &&
+          std::find(expected.begin(), expected.end(), *it) ==
+              expected.end()) {
+        expected.push_back(*it);
+      }
+    }
+    EXPECT_EQ(Strings(history.search(text, SIZE_MAX)), expected) << text;
+
+    expected.resize(std::min<size_t>(expected.size(), 3));
+    EXPECT_EQ(Strings(history.search(text, 3)), expected) << text;
+  }
+}
+
+TEST(HistoryTest, HistoryCommandListsAndSearches) {
+  History history;
+  for (auto line : {"make build", "ls -l", "make test", "make build"}) {
+    history.add(line);
+  }
+
+  TextInput input("");
+  TextOutput list;
+  HistoryCommand({"2"}, history).run(input, list);
+  EXPECT_EQ(list.read(), "    2  make test\n    3  make build\n");
+
+  TextOutput found;
+  HistoryCommand({"-s", "make"}, history).run(input, found);
+  EXPECT_EQ(found.read(), "make build\nmake test\n");
+
+  EXPECT_THROW(HistoryCommand({"-s"}, history), std::invalid_argument);
+  EXPECT_THROW(HistoryCommand({"x"}, history), std::invalid_argument);
+}
+
+}  // namespace coreutils::test
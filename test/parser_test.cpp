@@ -1,6 +1,13 @@
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+
 #include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include <parser.hpp>
 
@@ -15,6 +22,8 @@ class ParserTest : public ::testing::Test {
     setenv("A", "AAA", 1);
     setenv("B", "BBB", 1);
     setenv("VAR", "value", 1);
+    // The parser snapshots the environment when it is constructed.
+    parser = Parser();
   }
 
   void TearDown() override {
@@ -225,4 +234,144 @@ TEST_F(ParserTest, NestedQuotesWithVariable) {
   EXPECT_EQ(tokens[1], "\"$y\"");
 }
 
+TEST_F(ParserTest, TokenizeReturnsViewsIntoLineForPlainWords) {
+  Parser parser;
+  Arena arena;
+  const std::string line = "grep -n foo|wc -l && a&b";
+  auto tokens = parser.tokenize(line, arena);
+
+  const std::vector<std::string_view> expected = {
+      "grep", "-n", "foo", "|", "wc", "-l", "&&", "a&b"};
+  ASSERT_EQ(tokens, expected);
+  for (auto token : tokens) {
+    EXPECT_GE(token.data(), line.data());
+    EXPECT_LE(token.data() + token.size(), line.data() + line.size());
+  }
+}
+
+TEST_F(ParserTest, TokenizeCopiesAssembledWordsIntoArena) {
+  Parser parser;
+  Arena arena;
+  const std::string line = "echo pre'fix' \"$A\"x ${B}";
+  auto tokens = parser.tokenize(line, arena);
+
+  const std::vector<std::string_view> expected = {"echo", "prefix", "AAAx",
+                                                  "BBB"};
+  ASSERT_EQ(tokens, expected);
+  for (size_t i = 1; i < tokens.size(); ++i) {
+    const bool in_line = tokens[i].data() >= line.data() &&
+                         tokens[i].data() < line.data() + line.size();
+    EXPECT_FALSE(in_line) << tokens[i];
+  }
+}
+
+TEST_F(ParserTest, TokenizeLongArgumentList) {
+  // Long enough to span many 64-byte index blocks, with words, quotes and
+  // assignments straddling block boundaries.
+  Parser parser;
+  Arena arena;
+  std::string line = "X=1 Y=\"2\" echo";
+  std::vector<std::string> expected = {"echo"};
+  for (int i = 0; i < 20000; ++i) {
+    const std::string word = "arg" + std::to_string(i);
+    if (i % 7 == 0) {
+      line += " '" + word + " q'";
+      expected.push_back(word + " q");
+    } else if (i % 11 == 0) {
+      line += "  \"${A}" + word + "\"";
+      expected.push_back("AAA" + word);
+    } else {
+      line += " " + word + "=v";
+      expected.push_back(word + "=v");
+    }
+  }
+  line += " | wc";
+  expected.push_back("|");
+  expected.push_back("wc");
+
+  auto tokens = parser.tokenize(line, arena);
+  ASSERT_EQ(tokens.size(), expected.size());
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    EXPECT_EQ(tokens[i], expected[i]) << i;
+  }
+
+  auto assigned = parser.parseToTokens("echo $X $Y");
+  ASSERT_EQ(assigned.size(), 3);
+  EXPECT_EQ(assigned[1], "1");
+  // Assignment values lose their quotes, like any other word.
+  EXPECT_EQ(assigned[2], "2");
+}
+
+TEST_F(ParserTest, CommandSubstitutionSplitsUnquotedOutput) {
+  std::vector<std::string> commands;
+  parser.setSubstitutionRunner([&](std::string_view command) {
+    commands.emplace_back(command);
+    return std::string("one  two\n\n");
+  });
+
+  auto tokens = parser.parseToTokens(
+      R"cmd(echo x$(ls -a | wc)y "$(pwd)" `a b` "q`c`")cmd");
+
+  const std::vector<std::string> expected = {
+      "echo", "xone", "twoy", "one  two", "one", "two", "qone  two"};
+  EXPECT_EQ(tokens, expected);
+  EXPECT_EQ(commands,
+            (std::vector<std::string>{"ls -a | wc", "pwd", "a b", "c"}));
+}
+
+TEST_F(ParserTest, CommandSubstitutionFindsClosingParenthesis) {
+  std::vector<std::string> commands;
+  parser.setSubstitutionRunner([&](std::string_view command) {
+    commands.emplace_back(command);
+    return std::string();
+  });
+
+  auto tokens =
+      parser.parseToTokens(R"cmd(echo $(f (x) ')' ")") end $(open)cmd");
+
+  EXPECT_EQ(tokens, (std::vector<std::string>{"echo", "end"}));
+  EXPECT_EQ(commands,
+            (std::vector<std::string>{R"cmd(f (x) ')' ")")cmd", "open"}));
+}
+
+TEST_F(ParserTest, GlobsOnlyUnquotedWildcards) {
+  const auto dir = std::filesystem::temp_directory_path() /
+                   ("parser-glob-" + std::to_string(getpid()));
+  std::filesystem::remove_all(dir);
+  std::filesystem::create_directories(dir);
+  for (const char* name : {"a.log", "b.log", "*.log"}) {
+    std::ofstream(dir / name).put('x');
+  }
+  const std::string root = dir.string();
+
+  // Variables hold literal text; only wildcards typed unquoted expand.
+  auto tokens = parser.parseToTokens(
+      "PATTERN=*.log cat " + root + "/*.log " + root + "/'*'.log \"" + root +
+      "/*.log\" " + root + "/$PATTERN " + root + "/*.txt");
+  const std::vector<std::string> expected = {
+      "cat",
+      root + "/*.log",
+      root + "/a.log",
+      root + "/b.log",
+      root + "/*.log",
+      root + "/*.log",
+      root + "/*.log",
+      root + "/*.txt",
+  };
+  EXPECT_EQ(tokens, expected);
+  std::filesystem::remove_all(dir);
+}
+
+TEST(ArenaTest, ResetReusesFirstBlock) {
+  Arena arena;
+  const std::string_view first = arena.copy("first");
+  const char* block = first.data();
+  const std::string big(Arena::kDefaultBlockSize * 3, 'x');
+  EXPECT_EQ(arena.copy(big), big);
+  EXPECT_EQ(first, "first");
+
+  arena.reset();
+  EXPECT_EQ(arena.copy("again").data(), block);
+}
+
 }  // namespace coreutils::test
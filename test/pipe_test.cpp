@@ -1,13 +1,27 @@
 #include <pipe.hpp>
 
+#include <algorithm>
+#include <array>
+#include <csignal>
 #include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
 #include <vector>
 
 #include <cat_command.hpp>
+#include <dir_walker.hpp>
 #include <echo_command.hpp>
+#include <executor.hpp>
 #include <exit_command.hpp>
 #include <external_command.hpp>
 #include <global_state.hpp>
+#include <head_command.hpp>
+#include <parallel.hpp>
+#include <tail_command.hpp>
 #include <text_input.hpp>
 #include <text_output.hpp>
 #include <wc_command.hpp>
@@ -131,4 +145,198 @@ TEST(Pipe, EmptyPipelineInput) {
   EXPECT_EQ(final_out.read(), "       0       0       0\n");
 }
 
+namespace {
+
+// The shell ignores SIGPIPE from startup, so writes to a pipe without
+// readers fail with EPIPE.
+const auto kPreviousSigpipe = std::signal(SIGPIPE, SIG_IGN);
+
+// Writes numbered lines until the pipeline is cancelled.
+class EndlessProducer final : public Command {
+ public:
+  int run(Input& /*in*/, Output& out) override {
+    for (size_t i = 0;; ++i) {
+      out.write(std::to_string(i) + "\n");
+    }
+  }
+};
+
+// Reads everything and writes nothing, like grep without matches.
+class Drain final : public Command {
+ public:
+  int run(Input& in, Output& /*out*/) override {
+    std::array<char, DEFAULT_BLOCK_SIZE> block{};
+    while (in.read(block.data(), block.size()) != 0) {
+    }
+    return 0;
+  }
+};
+
+// Fans numbered lines out over several workers, as the parallel builtins
+// do, whatever the number of cores.
+class ParallelProducer final : public Command {
+ public:
+  int run(Input& /*in*/, Output& out) override {
+    constexpr size_t kLines = size_t{1} << 24;
+    std::mutex out_mutex;
+    parallelFor(kLines, 4, [&](size_t index, size_t /*worker*/) {
+      const std::string line = std::to_string(index) + "\n";
+      std::lock_guard lock(out_mutex);
+      out.write(line);
+    });
+    return 0;
+  }
+};
+
+// Walks `root` on several workers, writing a long line per entry, and
+// reports walk errors the way find and du do.
+class WalkingProducer final : public Command {
+ public:
+  explicit WalkingProducer(std::string root) : root_(std::move(root)) {}
+
+  int run(Input& /*in*/, Output& out) override {
+    std::mutex out_mutex;
+    DirWalker walker(4);
+    walker.walk(
+        {root_},
+        [&](const WalkEntry& entry) {
+          const std::string line =
+              std::string(entry.path) + std::string(4096, ' ') + "\n";
+          std::lock_guard lock(out_mutex);
+          out.write(line);
+          return WalkAction::kContinue;
+        },
+        [](std::string_view path, int error) {
+          std::cerr << "walk: " << path << ": " << error << '\n';
+        });
+    return 0;
+  }
+
+ private:
+  std::string root_;
+};
+
+std::vector<Executor::CommandPtr> Stages(auto... stages) {
+  std::vector<Executor::CommandPtr> result;
+  (result.push_back(std::move(stages)), ...);
+  return result;
+}
+
+}  // namespace
+
+TEST(Executor, StagesStreamIntoEachOther) {
+  // Far more than a pipe holds, so the stages have to run concurrently.
+  TextInput input(std::string(1 << 20, 'x'));
+  TextOutput output;
+  auto commands =
+      Stages(std::make_unique<CatCommand>(std::vector<std::string>{}),
+             std::make_unique<WcCommand>(std::vector<std::string>{"-c"}));
+  EXPECT_EQ(Executor().runCommands(std::move(commands), input, output), 0);
+  EXPECT_EQ(output.read(), " 1048576\n");
+}
+
+TEST(Executor, HeadCancelsUpstreamStages) {
+  TextInput input("");
+  TextOutput output;
+  auto commands = Stages(std::make_unique<EndlessProducer>(),
+                         std::make_unique<HeadCommand>(
+                             std::vector<std::string>{"-n", "3"}));
+  EXPECT_EQ(Executor().runCommands(std::move(commands), input, output), 0);
+  EXPECT_EQ(output.read(), "0\n1\n2\n");
+}
+
+TEST(Executor, CancelsWorkersOfParallelStages) {
+  // Workers a stage fans out to are cancelled with it, so once head is
+  // done they stop quietly instead of each reporting a broken pipe.
+  const auto root = std::filesystem::temp_directory_path() / "executor-walk";
+  std::filesystem::remove_all(root);
+  for (int dir = 0; dir < 8; ++dir) {
+    const auto path = root / ("d" + std::to_string(dir));
+    std::filesystem::create_directories(path);
+    for (int file = 0; file < 200; ++file) {
+      std::ofstream(path / std::to_string(file));
+    }
+  }
+
+  TextInput input("");
+  testing::internal::CaptureStderr();
+  TextOutput parallel_output;
+  auto commands = Stages(std::make_unique<ParallelProducer>(),
+                         std::make_unique<HeadCommand>(
+                             std::vector<std::string>{"-n", "1"}));
+  EXPECT_EQ(
+      Executor().runCommands(std::move(commands), input, parallel_output), 0);
+  TextOutput walk_output;
+  commands = Stages(std::make_unique<WalkingProducer>(root.string()),
+                    std::make_unique<HeadCommand>(
+                        std::vector<std::string>{"-n", "1"}));
+  EXPECT_EQ(Executor().runCommands(std::move(commands), input, walk_output),
+            0);
+  EXPECT_EQ(testing::internal::GetCapturedStderr(), "");
+  EXPECT_EQ(std::count(parallel_output.read().begin(),
+                       parallel_output.read().end(), '\n'),
+            1);
+  EXPECT_EQ(walk_output.read().rfind(root.string(), 0), 0);
+  std::filesystem::remove_all(root);
+}
+
+TEST(Executor, CancelsStagesThatOnlyRead) {
+  // The drain never writes, so it only stops because its reads are
+  // cancelled once head is done.
+  TextInput input("");
+  TextOutput output;
+  auto commands = Stages(std::make_unique<EndlessProducer>(),
+                         std::make_unique<Drain>(),
+                         std::make_unique<HeadCommand>(
+                             std::vector<std::string>{"-n0"}));
+  EXPECT_EQ(Executor().runCommands(std::move(commands), input, output), 0);
+  EXPECT_EQ(output.read(), "");
+}
+
+TEST(Executor, ExternalProducersGetSigpipe) {
+  TextInput input("");
+  TextOutput output;
+  auto commands = Stages(
+      std::make_unique<ExternalCommand>("yes", std::vector<std::string>{}),
+      std::make_unique<HeadCommand>(std::vector<std::string>{"-2"}));
+  EXPECT_EQ(Executor().runCommands(std::move(commands), input, output), 0);
+  EXPECT_EQ(output.read(), "y\ny\n");
+}
+
+TEST(Executor, LoneCommandGetsAWriteError) {
+  // Nothing downstream cancelled it, so a closed stdout is an ordinary
+  // error rather than a quiet cancellation.
+  auto [reader, writer] = createPipe();
+  reader.reset();
+  TextInput input("");
+  auto commands =
+      Stages(std::make_unique<EchoCommand>(std::vector<std::string>{"x"}));
+  EXPECT_THROW(Executor().runCommands(std::move(commands), input, *writer),
+               std::system_error);
+
+  // The same goes for the last stage of a pipeline.
+  commands = Stages(
+      std::make_unique<EchoCommand>(std::vector<std::string>{"x"}),
+      std::make_unique<EchoCommand>(std::vector<std::string>{"y"}));
+  EXPECT_THROW(Executor().runCommands(std::move(commands), input, *writer),
+               std::system_error);
+}
+
+TEST(Executor, CancellationWakesIdleFollowers) {
+  // tail -f sleeps until the file changes and the drain until tail writes;
+  // only the cancellation sent once head is done wakes them up.
+  const auto path = std::filesystem::temp_directory_path() / "executor-tail";
+  std::ofstream(path) << "line\n";
+  TextInput input("");
+  TextOutput output;
+  auto commands = Stages(std::make_unique<TailCommand>(
+                             std::vector<std::string>{"-f", path.string()}),
+                         std::make_unique<Drain>(),
+                         std::make_unique<HeadCommand>(
+                             std::vector<std::string>{"-n0"}));
+  EXPECT_EQ(Executor().runCommands(std::move(commands), input, output), 0);
+  EXPECT_EQ(output.read(), "");
+  std::filesystem::remove(path);
+}
+
 }  // namespace coreutils::test
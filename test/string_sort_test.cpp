@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <string_sort.hpp>
+
+#include <algorithm>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils::test {
+
+namespace {
+
+void ExpectSortedLikeStdSort(const std::vector<std::string>& strings) {
+  std::vector<std::string_view> views(strings.begin(), strings.end());
+  radixSort(std::span(views), [](std::string_view value) { return value; });
+
+  auto expected = strings;
+  std::sort(expected.begin(), expected.end());
+  ASSERT_EQ(views.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(views[i], expected[i]) << "at " << i;
+  }
+}
+
+// Strings over a tiny alphabet that includes NUL and a high byte, with a
+// long shared prefix on some of them, so that ties cross several keys.
+std::vector<std::string> RandomStrings(size_t count, std::mt19937& rng) {
+  static constexpr char kAlphabet[] = {'\0', 'a', 'b', '\xff'};
+  std::uniform_int_distribution<size_t> length(0, 40);
+  std::uniform_int_distribution<size_t> letter(0, std::size(kAlphabet) - 1);
+  std::uniform_int_distribution<int> coin(0, 1);
+
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < count; ++i) {
+    std::string value = coin(rng) != 0 ? "shared/prefix/of/some/names/" : "";
+    for (size_t j = length(rng); j > 0; --j) {
+      value.push_back(kAlphabet[letter(rng)]);
+    }
+    strings.push_back(std::move(value));
+  }
+  return strings;
+}
+
+}  // namespace
+
+TEST(StringSort, Empty) { ExpectSortedLikeStdSort({}); }
+
+TEST(StringSort, PrefixesAndPadding) {
+  std::vector<std::string> strings = {"abcdefgh", "abcdefg", "", "b", "a"};
+  strings.emplace_back("abcdefgh\0", 9);
+  strings.emplace_back("abcdefg\0", 8);
+  strings.resize(100, "abcdefghijklmnopq");
+  ExpectSortedLikeStdSort(strings);
+}
+
+TEST(StringSort, RandomSizes) {
+  std::mt19937 rng(5);
+  for (size_t count : {1, 2, 31, 32, 33, 100, 1000, 20000}) {
+    ExpectSortedLikeStdSort(RandomStrings(count, rng));
+  }
+}
+
+TEST(StringSort, ManyDuplicates) {
+  std::vector<std::string> strings(5000, "same-name-longer-than-a-key");
+  strings.resize(10000, "same");
+  ExpectSortedLikeStdSort(strings);
+}
+
+TEST(StringSort, SortsIndicesByProjection) {
+  const std::vector<std::string> names = {"delta", "alpha", "charlie",
+                                          "bravo"};
+  std::vector<size_t> order = {0, 1, 2, 3};
+  radixSort(std::span(order), [&](size_t index) {
+    return std::string_view(names[index]);
+  });
+  EXPECT_EQ(order, (std::vector<size_t>{1, 3, 2, 0}));
+}
+
+}  // namespace coreutils::test
@@ -0,0 +1,375 @@
+#include <gtest/gtest.h>
+
+#include <cpu_features.hpp>
+#include <text_kernels.hpp>
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cctype>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils::test {
+
+namespace {
+
+std::vector<SimdLevel> SupportedLevels() {
+  std::vector<SimdLevel> levels;
+  for (auto level : {SimdLevel::kScalar, SimdLevel::kSse2, SimdLevel::kAvx2,
+                     SimdLevel::kAvx512}) {
+    if (level <= simdLevel()) {
+      levels.push_back(level);
+    }
+  }
+  return levels;
+}
+
+std::string RandomText(size_t size, std::mt19937& rng) {
+  static constexpr std::string_view kAlphabet = "ab \n\t\r\v\f\xd0\x96";
+  std::uniform_int_distribution<size_t> pick(0, kAlphabet.size() - 1);
+  std::string text(size, '\0');
+  for (auto& ch : text) {
+    ch = kAlphabet[pick(rng)];
+  }
+  return text;
+}
+
+// The semantics wc had before the vector kernels: one std::isspace call per
+// (signed) char in the default C locale.
+TextCounts ReferenceCounts(std::string_view text) {
+  TextCounts counts{};
+  counts.bytes = text.size();
+  bool in_word = false;
+  for (char ch : text) {
+    if (ch == '\n') {
+      ++counts.lines;
+    }
+    if (std::isspace(ch) != 0) {
+      in_word = false;
+    } else {
+      counts.words += static_cast<size_t>(!in_word);
+      in_word = true;
+    }
+  }
+  return counts;
+}
+
+// Byte-at-a-time definition of the -m and -L counters.
+TextCounts ReferenceUtf8Counts(std::string_view text) {
+  TextCounts counts = ReferenceCounts(text);
+  size_t line_length = 0;
+  for (char ch : text) {
+    const auto byte = static_cast<unsigned char>(ch);
+    if ((byte & 0xC0) != 0x80) {
+      ++counts.chars;
+    }
+    if (ch == '\n') {
+      counts.max_line_length = std::max(counts.max_line_length, line_length);
+      line_length = 0;
+    } else if (ch == '\t') {
+      line_length = (line_length / 8 + 1) * 8;
+    } else if ((byte & 0xC0) != 0x80) {
+      ++line_length;
+    }
+  }
+  counts.max_line_length = std::max(counts.max_line_length, line_length);
+  return counts;
+}
+
+void ExpectSameCounts(const TextCounts& actual, const TextCounts& expected,
+                      SimdLevel level) {
+  EXPECT_EQ(actual.lines, expected.lines) << toString(level);
+  EXPECT_EQ(actual.words, expected.words) << toString(level);
+  EXPECT_EQ(actual.bytes, expected.bytes) << toString(level);
+  EXPECT_EQ(actual.chars, expected.chars) << toString(level);
+  EXPECT_EQ(actual.max_line_length, expected.max_line_length)
+      << toString(level);
+}
+
+}  // namespace
+
+TEST(TextKernels, CountByteMatchesScalar) {
+  std::mt19937 rng(42);
+  for (size_t size = 0; size < 300; ++size) {
+    auto text = RandomText(size, rng);
+    // Misaligned starts exercise the unaligned loads and the tails.
+    for (size_t offset = 0; offset < 3 && offset <= size; ++offset) {
+      const size_t expected = countByte(SimdLevel::kScalar, text.data() + offset,
+                                        size - offset, '\n');
+      for (auto level : SupportedLevels()) {
+        EXPECT_EQ(countByte(level, text.data() + offset, size - offset, '\n'),
+                  expected)
+            << toString(level) << " size=" << size << " offset=" << offset;
+      }
+    }
+  }
+}
+
+TEST(TextKernels, CountByteLongRuns) {
+  // More than 255 vector blocks of matches overflow a byte counter unless
+  // the variant folds its accumulators in time.
+  std::string text(64 * 1024 + 7, '\n');
+  for (auto level : SupportedLevels()) {
+    EXPECT_EQ(countByte(level, text.data(), text.size(), '\n'), text.size())
+        << toString(level);
+  }
+}
+
+TEST(TextKernels, CountTextEveryByteValueAtEveryPosition) {
+  // Each byte value is planted at every offset of a 130-byte window of
+  // words, so it lands in the head, middle and tail of every vector width.
+  constexpr size_t kWindow = 130;
+  std::string base;
+  while (base.size() < kWindow) {
+    base += "word ";
+  }
+  base.resize(kWindow);
+
+  for (int value = 0; value < 256; ++value) {
+    for (size_t pos = 0; pos < kWindow; ++pos) {
+      std::string text = base;
+      text[pos] = static_cast<char>(value);
+      const auto expected = ReferenceCounts(text);
+      for (auto level : SupportedLevels()) {
+        bool in_word = false;
+        ExpectSameCounts(countText(level, text.data(), text.size(), in_word),
+                         expected, level);
+        if (HasFailure()) {
+          FAIL() << "byte=" << value << " pos=" << pos;
+        }
+      }
+    }
+  }
+}
+
+TEST(TextKernels, CountTextRandomSplits) {
+  std::mt19937 rng(7);
+  for (size_t size : {0, 1, 15, 16, 17, 63, 64, 65, 1000, 100000}) {
+    const auto text = RandomText(size, rng);
+    const auto expected = ReferenceCounts(text);
+
+    for (auto level : SupportedLevels()) {
+      // Feeding the text in random pieces must give the same result as one
+      // call, which checks that word state is carried across buffers.
+      std::uniform_int_distribution<size_t> piece(0, 200);
+      TextCounts counts{};
+      bool in_word = false;
+      for (size_t pos = 0; pos < text.size();) {
+        const size_t length = std::min(piece(rng), text.size() - pos);
+        counts += countText(level, text.data() + pos, length, in_word);
+        pos += length;
+      }
+      ExpectSameCounts(counts, expected, level);
+    }
+  }
+}
+
+TEST(TextKernels, CountUtf8TextEveryByteValueAtEveryPosition) {
+  constexpr size_t kWindow = 130;
+  std::string base;
+  while (base.size() < kWindow) {
+    base += "\xd1\x81\xd0\xbb\xd0\xbe\xd0\xb2\xd0\xbe x\n";
+  }
+  base.resize(kWindow);
+
+  for (int value = 0; value < 256; ++value) {
+    for (size_t pos = 0; pos < kWindow; ++pos) {
+      std::string text = base;
+      text[pos] = static_cast<char>(value);
+      const auto expected = ReferenceUtf8Counts(text);
+      for (auto level : SupportedLevels()) {
+        Utf8TextState state{};
+        auto counts = countUtf8Text(level, text.data(), text.size(), state);
+        finishUtf8Text(counts, state);
+        ExpectSameCounts(counts, expected, level);
+        if (HasFailure()) {
+          FAIL() << "byte=" << value << " pos=" << pos;
+        }
+      }
+    }
+  }
+}
+
+TEST(TextKernels, CountUtf8TextRandomSplits) {
+  std::mt19937 rng(11);
+  for (size_t size : {0, 1, 15, 16, 17, 63, 64, 65, 1000, 100000}) {
+    const auto text = RandomText(size, rng);
+    const auto expected = ReferenceUtf8Counts(text);
+
+    for (auto level : SupportedLevels()) {
+      std::uniform_int_distribution<size_t> piece(0, 200);
+      TextCounts counts{};
+      Utf8TextState state{};
+      for (size_t pos = 0; pos < text.size();) {
+        const size_t length = std::min(piece(rng), text.size() - pos);
+        counts += countUtf8Text(level, text.data() + pos, length, state);
+        pos += length;
+      }
+      finishUtf8Text(counts, state);
+      ExpectSameCounts(counts, expected, level);
+    }
+  }
+}
+
+TEST(TextKernels, CountUtf8TextLongLines) {
+  // Lines much longer than a vector, with and without tabs.
+  std::string text = std::string(1000, 'a') + "\n" + std::string(300, 'b') +
+                     "\t" + std::string(700, 'c') + "\n" + "\xe2\x82\xac";
+  const auto expected = ReferenceUtf8Counts(text);
+  for (auto level : SupportedLevels()) {
+    Utf8TextState state{};
+    auto counts = countUtf8Text(level, text.data(), text.size(), state);
+    finishUtf8Text(counts, state);
+    ExpectSameCounts(counts, expected, level);
+  }
+}
+
+TEST(TextKernels, ClassifyShellCharsEveryByteValueAtEveryPosition) {
+  // Every byte value lands in every lane of a block, for lengths that end
+  // mid-block, so each variant's masks and tail are checked bit by bit.
+  for (int value = 0; value < 256; ++value) {
+    const char ch = static_cast<char>(value);
+    const bool space = std::isspace(value) != 0;
+    const bool breaks =
+        space || std::string_view("'\"`$|&").find(ch) != std::string_view::npos;
+    const bool wildcard = ch == '*' || ch == '?' || ch == '[';
+    for (size_t size : {1, 17, 64, 100, 130}) {
+      std::string text(size, ch);
+      for (auto level : SupportedLevels()) {
+        std::vector<ShellCharMasks> masks((size + 63) / 64);
+        classifyShellChars(level, text.data(), size, masks.data());
+        for (size_t i = 0; i < masks.size(); ++i) {
+          const size_t bits = std::min<size_t>(64, size - i * 64);
+          const uint64_t all = bits == 64 ? ~uint64_t{0}
+                                          : (uint64_t{1} << bits) - 1;
+          EXPECT_EQ(masks[i].space, space ? all : 0)
+              << toString(level) << " byte=" << value << " size=" << size;
+          EXPECT_EQ(masks[i].breaks, breaks ? all : 0)
+              << toString(level) << " byte=" << value << " size=" << size;
+          EXPECT_EQ(masks[i].equals, ch == '=' ? all : 0)
+              << toString(level) << " byte=" << value << " size=" << size;
+          EXPECT_EQ(masks[i].wildcards, wildcard ? all : 0)
+              << toString(level) << " byte=" << value << " size=" << size;
+        }
+      }
+    }
+  }
+}
+
+TEST(TextKernels, ClassifyShellCharsMatchesScalar) {
+  static constexpr std::string_view kAlphabet = "ab= \t'\"`$|&*?[";
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<size_t> pick(0, kAlphabet.size() - 1);
+  for (size_t size = 0; size < 300; ++size) {
+    std::string text(size, '\0');
+    for (auto& ch : text) {
+      ch = kAlphabet[pick(rng)];
+    }
+    std::vector<ShellCharMasks> expected((size + 63) / 64);
+    classifyShellChars(SimdLevel::kScalar, text.data(), size, expected.data());
+    for (auto level : SupportedLevels()) {
+      std::vector<ShellCharMasks> masks(expected.size());
+      classifyShellChars(level, text.data(), size, masks.data());
+      for (size_t i = 0; i < masks.size(); ++i) {
+        EXPECT_EQ(masks[i].space, expected[i].space) << toString(level);
+        EXPECT_EQ(masks[i].breaks, expected[i].breaks) << toString(level);
+        EXPECT_EQ(masks[i].equals, expected[i].equals) << toString(level);
+        EXPECT_EQ(masks[i].wildcards, expected[i].wildcards)
+            << toString(level);
+      }
+    }
+  }
+}
+
+TEST(TextKernels, MaskBytePairMatchesScalar) {
+  std::mt19937 rng(11);
+  for (size_t size = 0; size < 300; ++size) {
+    const auto text = RandomText(size, rng);
+    std::vector<uint64_t> expected((size + 63) / 64);
+    maskBytePair(SimdLevel::kScalar, text.data(), size, '\t', '\n',
+                 expected.data());
+    for (auto level : SupportedLevels()) {
+      std::vector<uint64_t> masks(expected.size());
+      maskBytePair(level, text.data(), size, '\t', '\n', masks.data());
+      EXPECT_EQ(masks, expected) << toString(level) << " size=" << size;
+    }
+  }
+}
+
+TEST(TextKernels, TranslateBytesMatchesTable) {
+  // Tables with a handful of runs take the vector path, random tables the
+  // scalar one; every byte value is translated at every lane.
+  std::mt19937 rng(5);
+  std::array<uint8_t, 256> upper{};
+  std::array<uint8_t, 256> random{};
+  for (unsigned byte = 0; byte < 256; ++byte) {
+    upper[byte] = static_cast<uint8_t>(
+        byte >= 'a' && byte <= 'z' ? byte - 'a' + 'A' : byte);
+    random[byte] = static_cast<uint8_t>(rng());
+  }
+  upper[0xff] = 0;
+  upper['\n'] = ' ';
+  for (const auto& table : {upper, random}) {
+    const ByteMap map = makeByteMap(table);
+    std::string text;
+    for (int i = 0; i < 3 * 256 + 5; ++i) {
+      text += static_cast<char>(i * 7);
+    }
+    std::string expected = text;
+    for (auto& ch : expected) {
+      ch = static_cast<char>(table[static_cast<unsigned char>(ch)]);
+    }
+    for (auto level : SupportedLevels()) {
+      for (size_t size : {0UL, 15UL, 64UL, 100UL, text.size()}) {
+        std::string translated = text.substr(0, size);
+        translateBytes(level, map, translated.data(), size);
+        EXPECT_EQ(translated, expected.substr(0, size))
+            << toString(level) << " size=" << size;
+      }
+    }
+  }
+  EXPECT_EQ(makeByteMap(upper).runs.size(), 3);
+}
+
+TEST(TextKernels, FindByteInSetFindsFirstMember) {
+  std::bitset<256> digits;
+  for (char ch = '0'; ch <= '9'; ++ch) {
+    digits.set(static_cast<unsigned char>(ch));
+  }
+  std::bitset<256> scattered;
+  for (unsigned byte = 0; byte < 256; byte += 5) {
+    scattered.set(byte);
+  }
+  for (const auto& members : {digits, ~digits, scattered, std::bitset<256>{}}) {
+    const ByteSet set = makeByteSet(members);
+    unsigned outside = 0;
+    while (members[outside]) {
+      ++outside;
+    }
+    const bool empty = members.none();
+    unsigned inside = 0;
+    while (!empty && !members[inside]) {
+      ++inside;
+    }
+    // One member at every position of every length, or none at all.
+    for (size_t size = 0; size < 200; ++size) {
+      for (size_t hit = 0; hit <= size; ++hit) {
+        std::string text(size, static_cast<char>(outside));
+        if (hit < size) {
+          text[hit] = static_cast<char>(inside);
+        }
+        const size_t expected = empty ? size : hit;
+        for (auto level : SupportedLevels()) {
+          EXPECT_EQ(findByteInSet(level, set, text.data(), size), expected)
+              << toString(level) << " size=" << size << " hit=" << hit;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace coreutils::test
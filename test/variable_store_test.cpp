@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <variable_store.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace coreutils::test {
+
+namespace {
+
+std::vector<std::string> EnvEntries(const VariableStore& store) {
+  std::vector<std::string> entries;
+  for (char* const* entry = store.envp(); *entry != nullptr; ++entry) {
+    entries.emplace_back(*entry);
+  }
+  return entries;
+}
+
+}  // namespace
+
+TEST(VariableStore, SetFindAndOverwrite) {
+  VariableStore store;
+  EXPECT_EQ(store.find("A"), nullptr);
+
+  store.set("A", "1");
+  ASSERT_NE(store.find("A"), nullptr);
+  EXPECT_EQ(*store.find("A"), "1");
+
+  store.set("A", "22");
+  EXPECT_EQ(*store.find("A"), "22");
+  EXPECT_EQ(store.find("AB"), nullptr);
+}
+
+TEST(VariableStore, GrowsPastInitialCapacity) {
+  VariableStore store;
+  for (int i = 0; i < 5000; ++i) {
+    store.set("VAR_" + std::to_string(i), std::to_string(i * 3));
+  }
+  for (int i = 0; i < 5000; ++i) {
+    const std::string* value = store.find("VAR_" + std::to_string(i));
+    ASSERT_NE(value, nullptr) << i;
+    EXPECT_EQ(*value, std::to_string(i * 3));
+  }
+  EXPECT_EQ(store.find("VAR_5000"), nullptr);
+}
+
+TEST(VariableStore, ImportEnvironmentExportsEverything) {
+  std::string first = "HOME=/home/user";
+  std::string second = "EMPTY=";
+  std::string third = "EQ=a=b";
+  char* env[] = {first.data(), second.data(), third.data(), nullptr};
+
+  VariableStore store;
+  store.importEnvironment(env);
+
+  EXPECT_EQ(*store.find("HOME"), "/home/user");
+  EXPECT_EQ(*store.find("EMPTY"), "");
+  EXPECT_EQ(*store.find("EQ"), "a=b");
+  EXPECT_TRUE(store.isExported("EQ"));
+  EXPECT_EQ(EnvEntries(store), (std::vector<std::string>{
+                                   "HOME=/home/user", "EMPTY=", "EQ=a=b"}));
+}
+
+TEST(VariableStore, EnvpHoldsOnlyAssignedExportedVariables) {
+  VariableStore store;
+  store.set("LOCAL", "1");
+  store.exportVariable("LATER");
+  EXPECT_TRUE(EnvEntries(store).empty());
+
+  store.set("LATER", "2");
+  store.set("SHARED", "3");
+  store.exportVariable("SHARED");
+  EXPECT_EQ(EnvEntries(store),
+            (std::vector<std::string>{"LATER=2", "SHARED=3"}));
+}
+
+TEST(VariableStore, EnvpIsRebuiltOnlyWhenExportsChange) {
+  VariableStore store;
+  store.set("A", "1");
+  store.exportVariable("A");
+
+  char* const* snapshot = store.envp();
+  const char* entry = snapshot[0];
+
+  // Neither local variables nor unchanged values touch the snapshot.
+  store.set("LOCAL", "x");
+  store.set("A", "1");
+  store.exportVariable("A");
+  EXPECT_EQ(store.envp(), snapshot);
+  EXPECT_EQ(store.envp()[0], entry);
+
+  store.set("A", "2");
+  EXPECT_EQ(EnvEntries(store), std::vector<std::string>{"A=2"});
+}
+
+}  // namespace coreutils::test